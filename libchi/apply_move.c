@@ -38,6 +38,7 @@ chi_apply_move(chi_pos *pos, chi_move move)
 		chi_material(pos) += chi_move_material(move);
 	else
 		chi_material(pos) -= chi_move_material(move);
+	chi_psq_move(pos, move, chi_on_move(pos), 1);
 
 	chi_on_move(pos) = !chi_on_move(pos);
 
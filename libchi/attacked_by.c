@@ -0,0 +1,86 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libchi.h"
+#include "bitmasks.h"
+#include "magicmoves.h"
+
+bitv64
+chi_attacked_by(const chi_pos *pos, chi_color_t color, bitv64 occupancy)
+{
+	bitv64 attacked;
+	bitv64 pieces;
+	bitv64 knights, bishops, rooks, kings;
+
+	if (color == chi_white) {
+		pieces = pos->w_pawns;
+		attacked = ((pieces & ~CHI_A_MASK) << 9)
+			| ((pieces & ~CHI_H_MASK) << 7);
+		knights = pos->w_knights;
+		bishops = pos->w_bishops;
+		rooks = pos->w_rooks;
+		kings = pos->w_kings;
+	} else {
+		pieces = pos->b_pawns;
+		attacked = ((pieces & ~CHI_A_MASK) >> 7)
+			| ((pieces & ~CHI_H_MASK) >> 9);
+		knights = pos->b_knights;
+		bishops = pos->b_bishops;
+		rooks = pos->b_rooks;
+		kings = pos->b_kings;
+	}
+
+	while (knights) {
+		int from = chi_bitv2shift(chi_clear_but_least_set(knights));
+		attacked |= chi_knight_attacks[from];
+		knights = chi_clear_least_set(knights);
+	}
+
+	while (bishops) {
+		int from = chi_bitv2shift(chi_clear_but_least_set(bishops));
+		attacked |= Bmagic(from, occupancy);
+		bishops = chi_clear_least_set(bishops);
+	}
+
+	while (rooks) {
+		int from = chi_bitv2shift(chi_clear_but_least_set(rooks));
+		attacked |= Rmagic(from, occupancy);
+		rooks = chi_clear_least_set(rooks);
+	}
+
+	if (kings)
+		attacked |= chi_king_attacks[chi_bitv2shift(kings)];
+
+	return attacked;
+}
+
+bitv64
+chi_context_attacked_by(const chi_pos *pos, chi_position_context *ctx,
+                        chi_color_t color)
+{
+	if (!(ctx->attacked_valid & (1 << color))) {
+		ctx->attacked[color] = chi_attacked_by(pos, color, ctx->occupancy);
+		ctx->attacked_valid |= 1 << color;
+	}
+
+	return ctx->attacked[color];
+}
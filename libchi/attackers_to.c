@@ -0,0 +1,44 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libchi.h"
+#include "bitmasks.h"
+#include "magicmoves.h"
+
+bitv64
+chi_attackers_to(const chi_pos *pos, unsigned int square, bitv64 occupancy)
+{
+	bitv64 attackers;
+
+	attackers = chi_reverse_pawn_attacks[chi_white][square] & pos->w_pawns;
+	attackers |= chi_reverse_pawn_attacks[chi_black][square] & pos->b_pawns;
+	attackers |= chi_knight_attacks[square]
+		& (pos->w_knights | pos->b_knights);
+	attackers |= chi_king_attacks[square] & (pos->w_kings | pos->b_kings);
+	attackers |= Bmagic(square, occupancy)
+		& (pos->w_bishops | pos->b_bishops);
+	attackers |= Rmagic(square, occupancy)
+		& (pos->w_rooks | pos->b_rooks);
+
+	/* Pieces that have been removed from the occupancy are gone.  */
+	return attackers & occupancy;
+}
@@ -0,0 +1,51 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Pre-computed bit masks.  The tables are defined in bitmasks.c which
+ * is generated by genmasks.
+ */
+
+#ifndef _LIBCHI_BITMASKS_H
+# define _LIBCHI_BITMASKS_H
+
+#include <libchi.h>
+
+CHI_BEGIN_DECLS
+
+/* Fields obscured by a sliding move from F to T, i. e. the squares behind
+ * F, seen from T.
+ */
+extern const bitv64 chi_obscured_masks[64][64];
+
+/* The lower bit denotes whether the move from F to T is a bishop
+ * movement (1) or a rook movement (0), the upper bit denotes whether the
+ * obscured squares are bitwise to the left/higher (1) or to the
+ * right/lower (0) of the movement.
+ */
+extern const unsigned char chi_obscurance_directions[64][64];
+
+/* Squares from which a pawn of the given color attacks a square.  */
+extern const bitv64 chi_reverse_pawn_attacks[2][64];
+
+/* Squares attacked by a knight resp. king on a square.  */
+extern const bitv64 chi_knight_attacks[64];
+extern const bitv64 chi_king_attacks[64];
+
+CHI_END_DECLS
+
+#endif
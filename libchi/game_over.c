@@ -22,13 +22,19 @@
 
 #include "libchi.h"
 
-static inline chi_bool min2bits_set(bitv64 value);
+/* Counts of the pieces that can always mate in the material key.  */
+#define HEAVY_PIECES \
+	((((bitv64) 0xf) << CHI_MATERIAL_SHIFT(chi_white, pawn)) \
+	 | (((bitv64) 0xff) << CHI_MATERIAL_SHIFT(chi_white, rook)) \
+	 | (((bitv64) 0xf) << CHI_MATERIAL_SHIFT(chi_black, pawn)) \
+	 | (((bitv64) 0xff) << CHI_MATERIAL_SHIFT(chi_black, rook)))
 
 chi_bool
 chi_game_over(const chi_pos *pos, chi_result *result)
 {
 	chi_move moves[CHI_MAX_MOVES];
 	chi_move *end_ptr;
+	bitv64 key;
     /* White bishop is on white fields, black bishop ... */
     chi_bool wbisw, bbisw;
 
@@ -48,40 +54,29 @@ chi_game_over(const chi_pos *pos, chi_result *result)
 		return chi_true;
 	}
 
-	/* Draws by insufficient material.  First check whether there *is*
-	 * sufficient material.  Checking for rooks will automatically check
-	 * for queens as well.
+	/* Draws by insufficient material.  Pawns, rooks, and queens are
+	 * always sufficient, and that can be seen from the material key
+	 * at once.
 	 */
-	if (pos->w_rooks | pos->b_rooks | pos->w_pawns | pos->b_pawns)
+	key = chi_material_key(pos);
+	if (key & HEAVY_PIECES)
 		goto no_draw;
 
-	/* We now know that neither queens nor rooks are on the board.  That
-	 * means that the bishop bitboards are only for bishops.
-	 */
-
-	/* Two pieces on one side can always mate.  */
-	if (pos->w_bishops && pos->w_knights)
-		goto no_draw;
-	if (pos->b_bishops && pos->b_knights)
-		goto no_draw;
-	if (min2bits_set(pos->w_bishops))
+	/* Two minor pieces on one side can always mate.  */
+	if (CHI_MATERIAL_COUNT(key, chi_white, knight)
+	    + CHI_MATERIAL_COUNT(key, chi_white, bishop) > 1)
 		goto no_draw;
-	if (min2bits_set(pos->b_bishops))
-		goto no_draw;
-	if (min2bits_set(pos->w_knights))
-		goto no_draw;
-	if (min2bits_set(pos->b_knights))
+	if (CHI_MATERIAL_COUNT(key, chi_black, knight)
+	    + CHI_MATERIAL_COUNT(key, chi_black, bishop) > 1)
 		goto no_draw;
 
-	/* Neither side has queens, rooks, or pawns. And neither side has more
-	 * than one bishop or knight.
-	 */
+	/* Neither side has more than one bishop or knight.  */
 	if (!(pos->w_bishops && pos->b_bishops))
 		goto draw;
 
 	/* Both sides have exactly one bishop.  */
-    wbisw = (pos->w_bishops & CHI_WHITE_MASK) ? chi_true : chi_false;
-    bbisw = (pos->b_bishops & CHI_WHITE_MASK) ? chi_true : chi_false;
+	wbisw = (pos->w_bishops & CHI_WHITE_MASK) ? chi_true : chi_false;
+	bbisw = (pos->b_bishops & CHI_WHITE_MASK) ? chi_true : chi_false;
 
 	if (wbisw == bbisw)
 		goto draw;
@@ -96,16 +91,3 @@ draw:
 
 	return chi_true;
 }
-
-static inline chi_bool
-min2bits_set(bitv64 value)
-{
-	unsigned count = 0;
-
-	while (value) {
-		value &= (value - 1);
-		if (count++) return chi_true;
-	}
-
-	return chi_false;
-}
@@ -0,0 +1,231 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Generate the bitbase for king and pawn against king by retrograde
+ * analysis.  The result is written to standard output.
+ *
+ * Squares are shifts, 0 is h1 and 63 is a8, the pawn is white.  First,
+ * all positions are classified that can be decided without looking
+ * ahead.  Then the remaining positions are resolved from their
+ * successors until nothing changes any more.  All positions that are
+ * still unknown then are draws.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define GENKPK 1
+
+#include "kpk.c"
+
+#define INVALID 0
+#define UNKNOWN 1
+#define DRAW 2
+#define WIN 4
+
+static unsigned char results[KPK_SIZE];
+
+static int
+distance(int from, int to)
+{
+	int ranks = abs((from >> 3) - (to >> 3));
+	int files = abs((from & 0x7) - (to & 0x7));
+
+	return ranks > files ? ranks : files;
+}
+
+/* Squares attacked by the white pawn on PAWN.  */
+static int
+pawn_attacks(int pawn, int square)
+{
+	return (square >> 3) == (pawn >> 3) + 1
+		&& abs((square & 0x7) - (pawn & 0x7)) == 1;
+}
+
+/* Squares that the black king may move to.  */
+static int
+black_king_may_move(int white_king, int pawn, int black_king, int to)
+{
+	return distance(black_king, to) == 1
+		&& distance(white_king, to) > 1
+		&& !pawn_attacks(pawn, to);
+}
+
+static int
+initial_result(int white_to_move, int white_king, int pawn, int black_king)
+{
+	int queen_square = pawn + 8;
+	int to;
+
+	if (white_king == black_king || white_king == pawn
+	    || black_king == pawn || distance(white_king, black_king) <= 1)
+		return INVALID;
+
+	if (white_to_move) {
+		/* Black must not be in check.  */
+		if (pawn_attacks(pawn, black_king))
+			return INVALID;
+
+		/* A safe promotion wins.  */
+		if ((pawn >> 3) == 6
+		    && white_king != queen_square && black_king != queen_square
+		    && (distance(black_king, queen_square) > 1
+		        || distance(white_king, queen_square) == 1))
+			return WIN;
+
+		return UNKNOWN;
+	}
+
+	/* Black can take the pawn.  */
+	if (distance(black_king, pawn) == 1 && distance(white_king, pawn) > 1)
+		return DRAW;
+
+	for (to = 0; to < 64; ++to) {
+		if (to != pawn
+		    && black_king_may_move(white_king, pawn, black_king, to))
+			return UNKNOWN;
+	}
+
+	/* Mate or stalemate.  */
+	return pawn_attacks(pawn, black_king) ? WIN : DRAW;
+}
+
+/* Combine the result of a successor into the result of a white
+ * (WHITE_TO_MOVE = 1) or black position.  GOOD is the result that
+ * decides the position for the side on move, BAD is the other one.
+ */
+static int
+resolve(int white_to_move, int white_king, int pawn, int black_king)
+{
+	int good = white_to_move ? WIN : DRAW;
+	int bad = white_to_move ? DRAW : WIN;
+	int all_bad = 1;
+	int child;
+	int to;
+
+	for (to = 0; to < 64; ++to) {
+		if (white_to_move) {
+			if (distance(white_king, to) != 1 || to == pawn)
+				continue;
+			child = results[kpk_index(0, to, pawn, black_king)];
+		} else {
+			if (to == pawn
+			    || !black_king_may_move(white_king, pawn, black_king, to))
+				continue;
+			child = results[kpk_index(1, white_king, pawn, to)];
+		}
+
+		if (child == INVALID)
+			continue;
+		if (child == good)
+			return good;
+		if (child != bad)
+			all_bad = 0;
+	}
+
+	if (white_to_move && (pawn >> 3) < 6) {
+		int single = pawn + 8;
+		int twice = pawn + 16;
+
+		if (single != white_king && single != black_king) {
+			child = results[kpk_index(0, white_king, single, black_king)];
+			if (child == good)
+				return good;
+			if (child != bad)
+				all_bad = 0;
+
+			if ((pawn >> 3) == 1
+			    && twice != white_king && twice != black_king) {
+				child = results[kpk_index(0, white_king, twice,
+				                          black_king)];
+				if (child == good)
+					return good;
+				if (child != bad)
+					all_bad = 0;
+			}
+		}
+	}
+
+	return all_bad ? bad : UNKNOWN;
+}
+
+int
+main(void)
+{
+	int white_to_move, white_king, pawn, black_king;
+	int changed;
+	unsigned int i;
+
+	for (pawn = 8; pawn < 56; ++pawn) {
+		if ((pawn & 0x7) >= 4)
+			continue;
+		for (white_king = 0; white_king < 64; ++white_king)
+		for (black_king = 0; black_king < 64; ++black_king)
+		for (white_to_move = 0; white_to_move <= 1; ++white_to_move)
+			results[kpk_index(white_to_move, white_king, pawn,
+			                  black_king)] =
+				initial_result(white_to_move, white_king, pawn,
+				               black_king);
+	}
+
+	do {
+		changed = 0;
+		for (pawn = 8; pawn < 56; ++pawn) {
+			if ((pawn & 0x7) >= 4)
+				continue;
+			for (white_king = 0; white_king < 64; ++white_king)
+			for (black_king = 0; black_king < 64; ++black_king)
+			for (white_to_move = 0; white_to_move <= 1; ++white_to_move) {
+				unsigned int index = kpk_index(white_to_move, white_king,
+				                               pawn, black_king);
+
+				if (results[index] != UNKNOWN)
+					continue;
+				results[index] = resolve(white_to_move, white_king,
+				                         pawn, black_king);
+				if (results[index] != UNKNOWN)
+					changed = 1;
+			}
+		}
+	} while (changed);
+
+	printf("/* This file is generated!  Edit genkpk.c for changes.  */\n\n");
+	printf("static const unsigned int kpk_bitbase[%u] = {", KPK_SIZE / 32);
+	for (i = 0; i < KPK_SIZE / 32; ++i) {
+		unsigned int word = 0;
+		unsigned int bit;
+
+		for (bit = 0; bit < 32; ++bit) {
+			if (results[i * 32 + bit] == WIN)
+				word |= 1U << bit;
+		}
+
+		if (i % 6 == 0)
+			printf("\n\t");
+		else
+			printf(" ");
+		printf("0x%08x%s", word, i + 1 < KPK_SIZE / 32 ? "," : "");
+	}
+	printf("\n};\n");
+
+	return 0;
+}
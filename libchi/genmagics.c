@@ -0,0 +1,124 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Generate the databases for the slider attacks at build time.  Invoke
+ * the program with the argument "magic" for the databases of magicmoves.c
+ * or "pext" for the ones of pextmoves.c.  The result is written to
+ * standard output.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+/* Use the runtime initialization of the two modules.  */
+#define GENMAGICS 1
+
+#include "magicmoves.c"
+#include "pextmoves.c"
+
+static void
+dump_u64(const char *name, const U64 *db, size_t size)
+{
+	size_t i;
+
+	printf("const U64 %s[%lu] = {", name, (unsigned long) size);
+	for (i = 0; i < size; ++i) {
+		if (i % 4 == 0)
+			printf("\n\t");
+		else
+			printf(" ");
+		printf("C64(0x%016llx)%s", (unsigned long long) db[i],
+		       i + 1 < size ? "," : "");
+	}
+	printf("\n};\n\n");
+}
+
+#ifdef PEXTMOVES
+static void
+dump_u16(const char *name, const unsigned short *db, size_t size)
+{
+	size_t i;
+
+	printf("static const unsigned short %s[%lu] = {", name,
+	       (unsigned long) size);
+	for (i = 0; i < size; ++i) {
+		if (i % 8 == 0)
+			printf("\n\t");
+		else
+			printf(" ");
+		printf("0x%04x%s", db[i], i + 1 < size ? "," : "");
+	}
+	printf("\n};\n\n");
+}
+
+static void
+dump_entries(const char *name, const pextmoves_entry *entries,
+             const char *db_name, const unsigned short *db)
+{
+	int i;
+
+	printf("pextmoves_entry %s[64] = {\n", name);
+	for (i = 0; i < 64; ++i) {
+		printf("\t{ 0x%016llxULL, 0x%016llxULL, %s + %lu }%s\n",
+		       entries[i].mask, entries[i].span, db_name,
+		       (unsigned long) (entries[i].attacks - db),
+		       i < 63 ? "," : "");
+	}
+	printf("};\n\n");
+}
+#endif
+
+int
+main(int argc, char *argv[])
+{
+	if (argc != 2
+	    || (strcmp(argv[1], "magic") != 0 && strcmp(argv[1], "pext") != 0)) {
+		fprintf(stderr, "Usage: %s magic|pext\n", argv[0]);
+		return 1;
+	}
+
+	printf("/* This file is generated!  Edit genmagics.c for changes.  */\n\n");
+
+	if (strcmp(argv[1], "magic") == 0) {
+		initmagicmoves();
+		dump_u64("magicmovesbdb", magicmovesbdb,
+		         sizeof magicmovesbdb / sizeof magicmovesbdb[0]);
+		dump_u64("magicmovesrdb", magicmovesrdb,
+		         sizeof magicmovesrdb / sizeof magicmovesrdb[0]);
+	} else {
+#ifdef PEXTMOVES
+		initpextmoves();
+		dump_u16("pextmovesrdb", pextmovesrdb,
+		         sizeof pextmovesrdb / sizeof pextmovesrdb[0]);
+		dump_u16("pextmovesbdb", pextmovesbdb,
+		         sizeof pextmovesbdb / sizeof pextmovesbdb[0]);
+		dump_entries("pextmoves_r", pextmoves_r, "pextmovesrdb",
+		             pextmovesrdb);
+		dump_entries("pextmoves_b", pextmoves_b, "pextmovesbdb",
+		             pextmovesbdb);
+#else
+		printf("/* PEXT is not supported on this platform.  */\n");
+#endif
+	}
+
+	return 0;
+}
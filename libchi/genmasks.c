@@ -38,25 +38,6 @@ static void generate_reverse_pawn_attacks(void);
 static void generate_knight_masks(void);
 static void generate_king_masks(void);
 
-static void generate_rook_king_attacks(void);
-/* FIXME! Get rid of this? */
-static void generate_rook_king_intermediates(void);
-
-static void generate_bishop_king_attacks(void);
-/* FIXME! Get rid of this? */
-static void generate_bishop_king_intermediates(void);
-
-#ifdef PAWN_LOOKUP
-static void generate_wpawn_sg_steps(void);
-static void generate_bpawn_sg_steps(void);
-static void generate_wpawn_dbl_steps(void);
-static void generate_bpawn_dbl_steps(void);
-
-static void print_escaped_moves(unsigned int, const chi_move*);
-
-static void print_rank_state(unsigned char state);
-#endif
-
 static const char* coordinates[] = {
     "h1", "g1", "f1", "e1", "d1", "c1", "b1", "a1",
     "h2", "g2", "f2", "e2", "d2", "c2", "b2", "a2",
@@ -79,8 +60,12 @@ main (argc, argv)
    The attack masks for knights and kings map a bitshift value into a\n\
    bitmask of fields attacked by that piece.  */\n\
 \n\
-#ifndef _BITMASKS_C\n\
-# define _BITMASKS_C\n"); 
+#ifdef HAVE_CONFIG_H\n\
+# include <config.h>\n\
+#endif\n\
+\n\
+#include \"libchi.h\"\n\
+#include \"bitmasks.h\"\n");
 
 	generate_obscured_masks();
 
@@ -89,42 +74,9 @@ main (argc, argv)
 	generate_knight_masks ();
 	generate_king_masks ();
 
-	generate_bishop_king_attacks ();
-	generate_bishop_king_intermediates ();
-
-	generate_rook_king_attacks ();
-	generate_rook_king_intermediates ();
-
-#ifdef PAWN_LOOKUP
-    generate_wpawn_sg_steps ();
-    generate_bpawn_sg_steps ();
-    generate_wpawn_dbl_steps ();
-    generate_bpawn_dbl_steps ();
-#endif
-
-	printf("\n#endif\n");
-
     return 0;
 }
 
-#ifdef PAWN_LOOKUP
-static void
-print_rank_state(unsigned char state)
-{
-    int i;
-
-    printf ("\t/* Rank state: 0x%02x (", state);
-    for (i = 7; i >= 0; --i) {
-	if (state & (1 << i)) {
-	    fputc ('1', stdout);
-	} else {
-	    fputc ('0', stdout);
-	}
-    }
-    printf (").  */\n");
-}
-#endif
-
 static void
 bitv64_dump (bitv64 from_mask, bitv64 to_mask, int piece_char, int tabs)
 {
@@ -318,7 +270,7 @@ generate_obscured_masks()
 	}
 
 	printf("\n/* Obscured masks (fields obscured by a move from F to T).  */\n");
-	printf("static const bitv64 obscured_masks[64][64] = {\n");
+	printf("const bitv64 chi_obscured_masks[64][64] = {\n");
 
 	for (off_t from = 0; from < 64; ++from) {
 		printf("\t/* From %lld (%s).  */\n", from, shift2label(from));
@@ -349,7 +301,7 @@ generate_obscured_masks()
 	       " * whether the obscured squares are bitwise to the left/higher (1)\n"
 	       " * or to the right/lower (0) of the movement.\n"
 	       " */\n");
-	printf("static const unsigned char obscurance_directions[64][64] = {\n");
+	printf("const unsigned char chi_obscurance_directions[64][64] = {\n");
 	for (off_t from = 0; from < 64; ++from) {
 		printf("\t/* From %lld (%s).  */\n", from, shift2label(from));
 		printf("\t{\n");
@@ -410,7 +362,7 @@ generate_reverse_pawn_attacks()
 	}
 
 	printf ("\n/* Reverse pawn attack masks.  */\n");
-	printf ("static const bitv64 reverse_pawn_attacks[2][64] = {\n");
+	printf ("const bitv64 chi_reverse_pawn_attacks[2][64] = {\n");
 
 	printf("\t/* White pawns.  */\n");
 	printf("\t{\n");
@@ -474,7 +426,7 @@ generate_king_masks ()
 	}
 
 	printf("\n/* King attack masks.  */\n");
-	printf("static const bitv64 king_attacks[64] = {\n");
+	printf("const bitv64 chi_king_attacks[64] = {\n");
 
 	for (i = 0; i < 64; ++i) {
 		printf("\t/* (0x%016llx) K%s ->\n",  (bitv64) 1 << i, shift2label (i));
@@ -559,7 +511,7 @@ generate_knight_masks ()
     }
 
     printf ("\n/* Knight attack masks.  */\n");
-    printf ("static const bitv64 knight_attacks[64] = {\n");
+    printf ("const bitv64 chi_knight_attacks[64] = {\n");
 
     for (i = 0; i < 64; ++i) {
 	printf ("\t/* (0x%016llx) N%s ->\n", 
@@ -571,445 +523,3 @@ generate_knight_masks ()
 
     printf ("};\n");
 }
-
-static void
-generate_bishop_king_attacks ()
-{
-    int king_rank, king_file;
-    int shift = 0;
-
-    printf ("\n/* Bishop king attacks.  */\n");
-    printf ("static const bitv64 bishop_king_attacks[64] = {\n");
-
-    for (king_rank = CHI_RANK_1; king_rank <= CHI_RANK_8; ++king_rank) {
-	for (king_file = CHI_FILE_H; king_file >= CHI_FILE_A; --king_file) {
-	    int bishop_file, bishop_rank;
-	    bitv64 mask = 0;
-
-	    for (bishop_file = king_file - 1, bishop_rank = king_rank + 1;
-		 bishop_file >= CHI_FILE_A && bishop_rank <= CHI_RANK_8;
-		 --bishop_file, ++bishop_rank)
-		mask |= ((bitv64) 1) << chi_coords2shift (bishop_file, 
-							  bishop_rank);
-	    for (bishop_file = king_file + 1, bishop_rank = king_rank - 1;
-		 bishop_file <= CHI_FILE_H && bishop_rank >= CHI_RANK_1;
-		 ++bishop_file, --bishop_rank)
-		mask |= ((bitv64) 1) << chi_coords2shift (bishop_file, 
-							  bishop_rank);
-	    for (bishop_file = king_file + 1, bishop_rank = king_rank + 1;
-		 bishop_file <= CHI_FILE_H && bishop_rank <= CHI_RANK_8;
-		 ++bishop_file, ++bishop_rank)
-		mask |= ((bitv64) 1) << chi_coords2shift (bishop_file, 
-							  bishop_rank);
-	    for (bishop_file = king_file - 1, bishop_rank = king_rank - 1;
-		 bishop_file >= CHI_FILE_A && bishop_rank >= CHI_RANK_1;
-		 --bishop_file, --bishop_rank)
-		mask |= ((bitv64) 1) << chi_coords2shift (bishop_file, 
-							  bishop_rank);
-
-	    printf ("\t/* (0x%016llx) K%s ->\n", 
-		    (bitv64) 1 << shift, shift2label (shift));
-	    bitv64_dump ((bitv64) 1 << shift, mask, 'K', 1);
-	    printf ("\t*/\n\t(bitv64) 0x%016llx,\n", mask);
-	    
-	    ++shift;
-	}
-    }
-
-    printf ("};\n");
-}
-
-static void
-generate_bishop_king_intermediates ()
-{
-    int king_shift, bishop_shift;
-    bitv64 bishop_king_attacks[64];
-
-    int king_rank, king_file;
-    int shift = 0;
-
-    for (king_rank = CHI_RANK_1; king_rank <= CHI_RANK_8; ++king_rank) {
-	for (king_file = CHI_FILE_H; king_file >= CHI_FILE_A; --king_file) {
-	    int bishop_file, bishop_rank;
-	    bitv64 mask = 0;
-
-	    for (bishop_file = king_file - 1, bishop_rank = king_rank + 1;
-		 bishop_file >= CHI_FILE_A && bishop_rank <= CHI_RANK_8;
-		 --bishop_file, ++bishop_rank)
-		mask |= ((bitv64) 1) << chi_coords2shift (bishop_file, 
-							  bishop_rank);
-	    for (bishop_file = king_file + 1, bishop_rank = king_rank - 1;
-		 bishop_file <= CHI_FILE_H && bishop_rank >= CHI_RANK_1;
-		 ++bishop_file, --bishop_rank)
-		mask |= ((bitv64) 1) << chi_coords2shift (bishop_file, 
-							  bishop_rank);
-	    for (bishop_file = king_file + 1, bishop_rank = king_rank + 1;
-		 bishop_file <= CHI_FILE_H && bishop_rank <= CHI_RANK_8;
-		 ++bishop_file, ++bishop_rank)
-		mask |= ((bitv64) 1) << chi_coords2shift (bishop_file, 
-							  bishop_rank);
-	    for (bishop_file = king_file - 1, bishop_rank = king_rank - 1;
-		 bishop_file >= CHI_FILE_A && bishop_rank >= CHI_RANK_1;
-		 --bishop_file, --bishop_rank)
-		mask |= ((bitv64) 1) << chi_coords2shift (bishop_file, 
-							  bishop_rank);
-
-	    bishop_king_attacks[shift] = mask;
-	    ++shift;
-	}
-    }
-
-    printf ("\n/* Bishop king intermediate squares.  */\n");
-    printf ("static const bitv64 bishop_king_intermediates[64][64] = {\n");
-
-    for (king_shift = 0; king_shift < 64; ++king_shift) {
-	printf ("\t/* (0x%016llx) K%s.  */\n",
-		(bitv64) 1 << king_shift, shift2label (king_shift));
-	printf ("\t{\n");
-	for (bishop_shift = 0; bishop_shift < 64; ++bishop_shift) {
-	    bitv64 bishop_mask = (bitv64) 1 << bishop_shift;
-	    bitv64 mask = (bitv64) -1;
-
-	    if (bishop_king_attacks[king_shift] & bishop_mask) {
-		int upper, lower;
-		mask = 0;
-
-		if (bishop_shift > king_shift) {
-		    upper = bishop_shift;
-		    lower = king_shift;
-		} else {
-		    upper = king_shift;
-		    lower = bishop_shift;
-		}
-
-		if ((upper - lower) % 9 == 0) {
-		    int i;
-
-		    for (i = lower + 9; i < upper; i += 9)
-			mask |= (bitv64) 1 << i;
-		} else {
-		    int i;
-
-		    for (i = lower + 7; i < upper; i += 7)
-			mask |= (bitv64) 1 << i;
-		}
-	    }
-
-	    printf ("\t\t/* (0x%016llx) B%s -> K%s\n",
-		    (bitv64) 1 << bishop_shift, 
-		    shift2label (bishop_shift),
-		    shift2label (king_shift));
-	    bitv64_dump ((bitv64) 1 << bishop_shift, mask, 'B', 2);
-	    printf ("\t\t*/\n\t\t(bitv64) 0x%016llx,\n", mask);
-	}
-	printf ("\t},\n");
-    }
-
-    printf ("};\n");
-}
-
-static void
-generate_rook_king_attacks ()
-{
-    int king_rank, king_file;
-    int shift = 0;
-
-    printf ("\n/* Rook king attacks.  */\n");
-    printf ("static const bitv64 rook_king_attacks[64] = {\n");
-
-    for (king_rank = CHI_RANK_1; king_rank <= CHI_RANK_8; ++king_rank) {
-	for (king_file = CHI_FILE_H; king_file >= CHI_FILE_A; --king_file) {
-	    int rook_file, rook_rank;
-	    bitv64 mask = 0;
-
-	    for (rook_rank = king_rank + 1; rook_rank <= CHI_RANK_8;
-		 ++rook_rank)
-		mask |= ((bitv64) 1) << chi_coords2shift (king_file,
-							  rook_rank);
-	    for (rook_rank = king_rank - 1; rook_rank >= CHI_RANK_1;
-		 --rook_rank)
-		mask |= ((bitv64) 1) << chi_coords2shift (king_file,
-							  rook_rank);
-	    for (rook_file = king_file - 1; rook_file >= CHI_FILE_A;
-		 --rook_file)
-		mask |= ((bitv64) 1) << chi_coords2shift (rook_file,
-							  king_rank);
-	    for (rook_file = king_file + 1; rook_file <= CHI_FILE_H;
-		 ++rook_file)
-		mask |= ((bitv64) 1) << chi_coords2shift (rook_file,
-							  king_rank);
-
-	    printf ("\t/* (0x%016llx) K%s ->\n", 
-		    (bitv64) 1 << shift, shift2label (shift));
-	    bitv64_dump ((bitv64) 1 << shift, mask, 'K', 1);
-	    printf ("\t*/\n\t(bitv64) 0x%016llx,\n", mask);
-	    
-	    ++shift;
-	}
-    }
-
-    printf ("};\n");
-}
-
-static void
-generate_rook_king_intermediates ()
-{
-    int king_shift, rook_shift;
-    bitv64 rook_king_attacks[64];
-
-    int king_rank, king_file;
-    int shift = 0;
-
-    for (king_rank = CHI_RANK_1; king_rank <= CHI_RANK_8; ++king_rank) {
-	for (king_file = CHI_FILE_H; king_file >= CHI_FILE_A; --king_file) {
-	    int rook_file, rook_rank;
-	    bitv64 mask = 0;
-
-	    for (rook_rank = king_rank + 1; rook_rank <= CHI_RANK_8;
-		 ++rook_rank)
-		mask |= ((bitv64) 1) << chi_coords2shift (king_file,
-							  rook_rank);
-	    for (rook_rank = king_rank - 1; rook_rank >= CHI_RANK_1;
-		 --rook_rank)
-		mask |= ((bitv64) 1) << chi_coords2shift (king_file,
-							  rook_rank);
-	    for (rook_file = king_file - 1; rook_file >= CHI_FILE_A;
-		 --rook_file)
-		mask |= ((bitv64) 1) << chi_coords2shift (rook_file,
-							  king_rank);
-	    for (rook_file = king_file + 1; rook_file <= CHI_FILE_H;
-		 ++rook_file)
-		mask |= ((bitv64) 1) << chi_coords2shift (rook_file,
-							  king_rank);
-
-	    rook_king_attacks[shift] = mask;
-	    ++shift;
-	}
-    }
-
-    printf ("\n/* Rook king intermediate squares.  */\n");
-    printf ("static const bitv64 rook_king_intermediates[64][64] = {\n");
-
-    for (king_shift = 0; king_shift < 64; ++king_shift) {
-	printf ("\t/* (0x%016llx) K%s.  */\n",
-		(bitv64) 1 << king_shift, shift2label (king_shift));
-	printf ("\t{\n");
-	for (rook_shift = 0; rook_shift < 64; ++rook_shift) {
-	    bitv64 rook_mask = (bitv64) 1 << rook_shift;
-	    bitv64 mask = (bitv64) -1;
-
-	    if (rook_king_attacks[king_shift] & rook_mask) {
-		int upper, lower;
-		mask = 0;
-
-		if (rook_shift > king_shift) {
-		    upper = rook_shift;
-		    lower = king_shift;
-		} else {
-		    upper = king_shift;
-		    lower = rook_shift;
-		}
-
-		if ((upper / 8) == (lower / 8)) {
-		    int i;
-
-		    for (i = lower + 1; i < upper; ++i)
-			mask |= (bitv64) 1 << i;
-		} else {
-		    int i;
-
-		    for (i = lower + 8; i < upper; i += 8)
-			mask |= (bitv64) 1 << i;
-		}
-	    }
-
-	    printf ("\t\t/* (0x%016llx) R%s -> K%s\n",
-		    (bitv64) 1 << rook_shift, 
-		    shift2label (rook_shift),
-		    shift2label (king_shift));
-	    bitv64_dump ((bitv64) 1 << rook_shift, mask, 'R', 2);
-	    printf ("\t\t*/\n\t\t(bitv64) 0x%016llx,\n", mask);
-	}
-	printf ("\t},\n");
-    }
-
-    printf ("};\n");
-}
-
-#ifdef PAWN_LOOKUP
-static void
-print_escaped_moves (members, moves)
-     unsigned int members;
-     const chi_move* moves;
-{
-    int i;
-
-    printf ("\t\"\\x%02x", members * sizeof *moves);
-    for (i = 0; i < members; ++i) {
-	unsigned char* ptr = (unsigned char*) (moves + i);
-	int j;
-
-	for (j = 0; j < sizeof *moves; ++j) {
-	    printf ("\\x%02x", ptr[j]);
-	}
-    }
-    printf ("\",\n");
-}
-
-static void
-generate_wpawn_sg_steps ()
-{
-    int state;
-    chi_move moves[8];
-
-    printf ("\n\
-/* Pawn non-capturing moves from 2nd to 3rd rank.  The index into the\n\
-   array is the \"state\" of the 3rd rank.  This state is calculated by\n\
-   advancing the pawns one rank, and then ANDing it with the empty\n\
-   squares.  */\n\
-\n\
-static const unsigned char* wpawn_sg_steps[256] = {\n");
-
-    for (state = 0; state < 256; ++state) {
-	int shift;
-	unsigned int members;
-
-	members = 0;
-	
-	print_rank_state (state);
-
-	memset (moves, 0, sizeof moves);
-
-	for (shift = 7; shift >= 0; --shift) {
-	    if (state & (1 << shift)) {
-		moves[members].fields.from = chi_coords2shift (7 - shift, 
-							       CHI_RANK_2);
-		moves[members].fields.to = chi_coords2shift (7 - shift, 
-							     CHI_RANK_3);
-		++members;
-	    }
-	}
-	print_escaped_moves (members, moves);
-    }
-
-    printf ("};\n");
-}
-
-static void
-generate_bpawn_sg_steps ()
-{
-    int state;
-    chi_move moves[8];
-
-    printf ("\n\
-/* Pawn non-capturing moves from 7th to 6th rank.  The index into the\n\
-   array is the \"state\" of the 6th rank.  This state is calculated by\n\
-   advancing the pawns one rank, and then ANDing it with the empty\n\
-   squares.  */\n\
-\n\
-static const unsigned char* bpawn_sg_steps[256] = {\n");
-
-    for (state = 0; state < 256; ++state) {
-	int shift;
-	unsigned int members;
-
-	members = 0;
-	
-	print_rank_state (state);
-
-	memset (moves, 0, sizeof moves);
-
-	for (shift = 7; shift >= 0; --shift) {
-	    if (state & (1 << shift)) {
-		moves[members].fields.from = chi_coords2shift (7 - shift, 
-							       CHI_RANK_7);
-		moves[members].fields.to = chi_coords2shift (7 - shift, 
-							     CHI_RANK_6);
-		++members;
-	    }
-	}
-	print_escaped_moves (members, moves);
-    }
-
-    printf ("};\n");
-}
-
-static void
-generate_wpawn_dbl_steps ()
-{
-    int state;
-    chi_move moves[8];
-
-    printf ("\n\
-/* Pawn non-capturing moves from 2nd to 4th rank.  The index into the\n\
-   array is the \"state\" of the 4th rank.  This state is calculated by\n\
-   advancing the pawns two ranks, and then ANDing it with the empty\n\
-   squares.  */\n\
-\n\
-static const unsigned char* wpawn_dbl_steps[256] = {\n");
-
-    for (state = 0; state < 256; ++state) {
-	int shift;
-	unsigned int members;
-
-	members = 0;
-	
-	print_rank_state (state);
-
-	memset (moves, 0, sizeof moves);
-
-	for (shift = 7; shift >= 0; --shift) {
-	    if (state & (1 << shift)) {
-		moves[members].fields.from = chi_coords2shift (7 - shift, 
-							       CHI_RANK_2);
-		moves[members].fields.to = chi_coords2shift (7 - shift, 
-							     CHI_RANK_4);
-		++members;
-	    }
-	}
-	print_escaped_moves (members, moves);
-    }
-
-    printf ("};\n");
-}
-
-static void
-generate_bpawn_dbl_steps ()
-{
-    int state;
-    chi_move moves[8];
-
-    printf ("\n\
-/* Pawn non-capturing moves from 7th to 5th rank.  The index into the\n\
-   array is the \"state\" of the 5th rank.  This state is calculated by\n\
-   advancing the pawns two ranks, and then ANDing it with the empty\n\
-   squares.  */\n\
-\n\
-static const unsigned char* bpawn_dbl_steps[256] = {\n");
-
-    for (state = 0; state < 256; ++state) {
-	int shift;
-	unsigned int members;
-
-	members = 0;
-	
-	print_rank_state (state);
-
-	memset (moves, 0, sizeof moves);
-
-	for (shift = 7; shift >= 0; --shift) {
-	    if (state & (1 << shift)) {
-		moves[members].fields.from = chi_coords2shift (7 - shift, 
-							       CHI_RANK_7);
-		moves[members].fields.to = chi_coords2shift (7 - shift, 
-							     CHI_RANK_5);
-		++members;
-	    }
-	}
-	print_escaped_moves (members, moves);
-    }
-
-    printf ("};\n");
-}
-
-#endif
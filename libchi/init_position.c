@@ -68,6 +68,8 @@ chi_init_position (pos)
 	pos->irreversible[0] = 0;
 
 	chi_on_move (pos) = chi_white;
+
+	chi_update_psq (pos);
 }
 
 /*
@@ -0,0 +1,85 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Bitbase for king and pawn against king.
+ *
+ * The side with the pawn is normalized to white, and the pawn to the
+ * files e to h (shifts 0 to 3).  For every position there is one bit
+ * that is set if white wins.  The bitbase is generated at build time by
+ * genkpk, which includes this file with GENKPK defined.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef GENKPK
+# include "libchi.h"
+#endif
+
+/* 24 pawn squares, 64 squares for each king, 2 sides on move.  */
+#define KPK_SIZE (24 * 64 * 64 * 2)
+
+/* Index of a normalized position.  WHITE_KING, PAWN, and BLACK_KING are
+ * shifts, the pawn must be on ranks 2 to 7 and files e to h.
+ */
+static unsigned int
+kpk_index(int white_to_move, int white_king, int pawn, int black_king)
+{
+	int pawn_index = ((pawn >> 3) - 1) * 4 + (pawn & 0x7);
+
+	return ((pawn_index * 64 + white_king) * 64 + black_king) * 2
+		+ !white_to_move;
+}
+
+#ifndef GENKPK
+
+#include "kpkdb.c"
+
+int
+chi_kpk_probe(const chi_pos *pos)
+{
+	chi_color_t strong = pos->w_pawns ? chi_white : chi_black;
+	int white_to_move = chi_on_move(pos) == strong;
+	int white_king, pawn, black_king;
+	unsigned int index;
+
+	if (strong == chi_white) {
+		white_king = chi_bitv2shift(pos->w_kings);
+		pawn = chi_bitv2shift(pos->w_pawns);
+		black_king = chi_bitv2shift(pos->b_kings);
+	} else {
+		/* Mirror the ranks.  */
+		white_king = chi_bitv2shift(pos->b_kings) ^ 56;
+		pawn = chi_bitv2shift(pos->b_pawns) ^ 56;
+		black_king = chi_bitv2shift(pos->w_kings) ^ 56;
+	}
+
+	if ((pawn & 0x7) >= 4) {
+		/* Mirror the files.  */
+		white_king ^= 7;
+		pawn ^= 7;
+		black_king ^= 7;
+	}
+
+	index = kpk_index(white_to_move, white_king, pawn, black_king);
+
+	return (kpk_bitbase[index >> 5] >> (index & 31)) & 1;
+}
+
+#endif
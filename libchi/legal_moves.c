@@ -42,47 +42,38 @@ chi_legal_moves(const chi_pos *pos, chi_move *move_stack)
 	for (m = moves; m < move_ptr; ++m) {
 		chi_pos tmp_pos;
 
-		chi_copy_pos(&tmp_pos, pos);
-
+		/* The king must neither castle out of check nor across an
+		 * attacked square.  A sliding piece that could only attack the
+		 * crossed square through the king would already give check.
+		 */
 		if (chi_move_from(*m) == 3) {
 			bitv64 from_mask = ((bitv64) 1) << 3;
 			int to = chi_move_to(*m);
 
-		if ((to == 5 || to == 1) && from_mask & pos->w_kings) {
-			int tmp_to = (3 + to) >> 1;
+			if ((to == 5 || to == 1) && from_mask & pos->w_kings) {
+				bitv64 cross_mask = ((bitv64) 1) << ((3 + to) >> 1);
 
-		if (chi_check_check(pos))
-			continue;
+				if (chi_context_attacked_by(pos, &ctx, chi_black)
+				    & (from_mask | cross_mask))
+					continue;
+			}
+		} else if (chi_move_from(*m) == 59) {
+			bitv64 from_mask = ((bitv64) 1) << 59;
+			int to = chi_move_to(*m);
+
+			if ((to == 61 || to == 57) && from_mask & pos->b_kings) {
+				bitv64 cross_mask = ((bitv64) 1) << ((59 + to) >> 1);
+
+				if (chi_context_attacked_by(pos, &ctx, chi_white)
+				    & (from_mask | cross_mask))
+					continue;
+			}
+		}
 
-		chi_move_set_to(*m, tmp_to);
+		chi_copy_pos(&tmp_pos, pos);
 		chi_make_move(&tmp_pos, *m);
 		if (chi_check_check(&tmp_pos))
 			continue;
-		chi_copy_pos(&tmp_pos, pos);
-		chi_move_set_to(*m, to);
-		}
-	} else if (chi_move_from(*m) == 59) {
-		bitv64 from_mask = ((bitv64) 1) << 59;
-		int to = chi_move_to(*m);
-
-		if ((to == 61 || to == 57) && from_mask & pos->b_kings) {
-			int tmp_to = (59 + to) >> 1;
-
-			if (chi_check_check(pos))
-				continue;
-
-			chi_move_set_to(*m, tmp_to);
-			chi_make_move(&tmp_pos, *m);
-			if (chi_check_check(&tmp_pos))
-				continue;
-			chi_copy_pos(&tmp_pos, pos);
-			chi_move_set_to(*m, to);
-		}
-	}
-
-	chi_make_move(&tmp_pos, *m);
-	if (chi_check_check(&tmp_pos))
-		continue;
 
 		*move_stack++ = *m;
 	}
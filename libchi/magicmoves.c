@@ -27,6 +27,10 @@
  *3. This notice may not be removed or altered from any source distribution.
  */
 
+#ifdef HAVE_CONFIG_H
+	#include <config.h>
+#endif
+
 #include "magicmoves.h"
 
 #ifdef _MSC_VER
@@ -154,8 +158,14 @@ const U64 magicmoves_b_mask[64]=
 	C64(0x0028440200000000), C64(0x0050080402000000), C64(0x0020100804020000), C64(0x0040201008040200)
 };
 
+#ifdef MAGICMOVES_STATIC
+	#include "magicdb.c"
+#endif
+
 #ifdef MINIMIZE_MAGIC
+#ifndef MAGICMOVES_STATIC
 U64 magicmovesbdb[5248];
+#endif
 const U64* magicmoves_b_indices[64]=
 {
 	magicmovesbdb+4992, magicmovesbdb+2624,  magicmovesbdb+256,  magicmovesbdb+896,
@@ -185,7 +195,9 @@ const U64* magicmoves_b_indices[64]=
 #endif
 
 #ifdef MINIMIZE_MAGIC
+#ifndef MAGICMOVES_STATIC
 U64 magicmovesrdb[102400];
+#endif
 const U64* magicmoves_r_indices[64]=
 {
 	magicmovesrdb+86016, magicmovesrdb+73728, magicmovesrdb+36864, magicmovesrdb+43008,
@@ -320,6 +332,12 @@ U64 initmagicmoves_Bmoves(const int square, const U64 occ)
 */
 #endif
 
+#ifdef MAGICMOVES_STATIC
+void initmagicmoves(void)
+{
+	//the databases are already filled at compile time
+}
+#else //!MAGICMOVES_STATIC
 void initmagicmoves(void)
 {
 	int i;
@@ -461,3 +479,4 @@ void initmagicmoves(void)
 		}
 	}
 }
+#endif //MAGICMOVES_STATIC
@@ -88,6 +88,14 @@
 
 #define USE_INLINING /*the MMINLINE keyword is assumed to be available*/
 
+//lisco: use the databases generated by genmagics at build time
+#if defined(CHI_STATIC_MAGIC) && !defined(GENMAGICS)
+	#define MAGICMOVES_STATIC
+	#ifndef MINIMIZE_MAGIC
+		#error "Static magic move databases require MINIMIZE_MAGIC"
+	#endif
+#endif
+
 #ifndef __64_BIT_INTEGER_DEFINED__
 	#define __64_BIT_INTEGER_DEFINED__
 	#if defined(_MSC_VER) && _MSC_VER<1300
@@ -180,9 +188,15 @@ extern const unsigned int magicmoves_r_shift[64];
 	#endif
 #endif //PERFCT_MAGIC_HASH
 
+#include "pextmoves.h"
+
 #ifdef USE_INLINING
 	static MMINLINE U64 Bmagic(const unsigned int square,const U64 occupancy)
 	{
+		#ifdef PEXTMOVES
+			if (pextmoves_enabled)
+				return Bpext(square, occupancy);
+		#endif
 		#ifndef PERFECT_MAGIC_HASH
 			#ifdef MINIMIZE_MAGIC
 				return *(magicmoves_b_indices[square]+(((occupancy&magicmoves_b_mask[square])*magicmoves_b_magics[square])>>magicmoves_b_shift[square]));
@@ -195,6 +209,10 @@ extern const unsigned int magicmoves_r_shift[64];
 	}
 	static MMINLINE U64 Rmagic(const unsigned int square,const U64 occupancy)
 	{
+		#ifdef PEXTMOVES
+			if (pextmoves_enabled)
+				return Rpext(square, occupancy);
+		#endif
 		#ifndef PERFECT_MAGIC_HASH
 			#ifdef MINIMIZE_MAGIC
 				return *(magicmoves_r_indices[square]+(((occupancy&magicmoves_r_mask[square])*magicmoves_r_magics[square])>>magicmoves_r_shift[square]));
@@ -207,6 +225,10 @@ extern const unsigned int magicmoves_r_shift[64];
 	}
 	static MMINLINE U64 BmagicNOMASK(const unsigned int square,const U64 occupancy)
 	{
+		#ifdef PEXTMOVES
+			if (pextmoves_enabled)
+				return Bpext(square, occupancy);
+		#endif
 		#ifndef PERFECT_MAGIC_HASH
 			#ifdef MINIMIZE_MAGIC
 				return *(magicmoves_b_indices[square]+(((occupancy)*magicmoves_b_magics[square])>>magicmoves_b_shift[square]));
@@ -219,6 +241,10 @@ extern const unsigned int magicmoves_r_shift[64];
 	}
 	static MMINLINE U64 RmagicNOMASK(const unsigned int square, const U64 occupancy)
 	{
+		#ifdef PEXTMOVES
+			if (pextmoves_enabled)
+				return Rpext(square, occupancy);
+		#endif
 		#ifndef PERFECT_MAGIC_HASH
 			#ifdef MINIMIZE_MAGIC
 				return *(magicmoves_r_indices[square]+(((occupancy)*magicmoves_r_magics[square])>>magicmoves_r_shift[square]));
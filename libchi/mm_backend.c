@@ -0,0 +1,74 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libchi.h"
+#include "magicmoves.h"
+
+int
+chi_mm_set_backend(chi_mm_backend backend)
+{
+	switch (backend) {
+		case chi_mm_magic:
+#ifdef PEXTMOVES
+			pextmoves_enabled = 0;
+#endif
+			return CHI_ERR_SUCCESS;
+		case chi_mm_pext:
+#ifdef PEXTMOVES
+			if (!pextmoves_cpu_supported())
+				return CHI_ERR_NOT_SUPPORTED;
+			/* The tables may not have been filled by chi_mm_init().  */
+			if (!pextmoves_r[0].attacks)
+				initpextmoves();
+			pextmoves_enabled = 1;
+			return CHI_ERR_SUCCESS;
+#else
+			return CHI_ERR_NOT_SUPPORTED;
+#endif
+	}
+
+	return CHI_ERR_YOUR_FAULT;
+}
+
+chi_mm_backend
+chi_mm_get_backend(void)
+{
+#ifdef PEXTMOVES
+	if (pextmoves_enabled)
+		return chi_mm_pext;
+#endif
+
+	return chi_mm_magic;
+}
+
+const char *
+chi_mm_backend_name(chi_mm_backend backend)
+{
+	switch (backend) {
+		case chi_mm_magic:
+			return "magic";
+		case chi_mm_pext:
+			return "pext";
+	}
+
+	return "unknown";
+}
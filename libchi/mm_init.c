@@ -27,4 +27,11 @@ void
 chi_mm_init(void)
 {
 	initmagicmoves();
+
+#ifdef PEXTMOVES
+	if (pextmoves_cpu_supported()) {
+		initpextmoves();
+		pextmoves_enabled = 1;
+	}
+#endif
 }
\ No newline at end of file
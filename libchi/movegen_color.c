@@ -200,7 +200,7 @@ chi_generate_color_captures(const chi_pos *pos, chi_position_context *ctx,
 	while (piece_mask) {
 		unsigned int from =
 				chi_bitv2shift(chi_clear_but_least_set(piece_mask));
-		bitv64 attack_mask = king_attacks[from] & her_squares;
+		bitv64 attack_mask = chi_king_attacks[from] & her_squares;
 
 		while (attack_mask) {
 			unsigned int to =
@@ -302,7 +302,7 @@ chi_generate_color_knight_moves(const chi_pos *pos, chi_position_context *ctx,
 		while (piece_mask) {
 			unsigned int from =
 			chi_bitv2shift(chi_clear_but_least_set(piece_mask));
-			bitv64 attack_mask = knight_attacks[from]
+			bitv64 attack_mask = chi_knight_attacks[from]
 					& (ctx->empty | HER_PIECES(pos));
 
 			while (attack_mask) {
@@ -469,7 +469,7 @@ chi_generate_color_king_moves(const chi_pos *pos, chi_position_context *ctx,
 		bitv64 empty_squares = ~occ_squares;
 		unsigned int from =
 			chi_bitv2shift(chi_clear_but_least_set(piece_mask));
-		bitv64 attack_mask = king_attacks[from] & empty_squares;
+		bitv64 attack_mask = chi_king_attacks[from] & empty_squares;
 
 		while (attack_mask) {
 			unsigned int to =
@@ -516,52 +516,10 @@ chi_generate_color_non_captures(const chi_pos *pos, chi_position_context *ctx,
 int
 chi_color_check_check(const chi_pos *pos)
 {
-	bitv64 king_mask = MY_KINGS(pos);
 	register unsigned int king_shift =
-			chi_bitv2shift(chi_clear_but_least_set(king_mask));
+			chi_bitv2shift(chi_clear_but_least_set(MY_KINGS(pos)));
 	bitv64 occ_squares = pos->w_pieces | pos->b_pieces;
-	bitv64 her_bishops, her_rooks;
-
-	if (knight_attacks[king_shift] & HER_KNIGHTS(pos))
-		return 1;
-
-	if (king_attacks[king_shift] & HER_KINGS(pos))
-		return 1;
-
-	/* Pawn attacks.  */
-	if (king_mask & ~PAWN_PROMOTE_RANK_MASK) {
-		if ((king_mask & ~CHI_A_MASK)
-		    && (HER_PAWNS(pos) & (LEFT_PAWN_CAPTURE_SHIFT(king_mask))))
-			return 1;
-		if ((king_mask & ~CHI_H_MASK)
-		    && (HER_PAWNS(pos) & (RIGHT_PAWN_CAPTURE_SHIFT(king_mask))))
-			return 1;
-	}
-
-	/* Bishop attacks.  */
-	her_bishops = HER_BISHOPS(pos) & bishop_king_attacks[king_shift];
-	while (her_bishops) {
-		int bishop_shift =
-				chi_bitv2shift(chi_clear_but_least_set(her_bishops));
-
-		if (!(bishop_king_intermediates[king_shift][bishop_shift]
-		    & occ_squares))
-			return 1;
-
-		her_bishops = chi_clear_least_set(her_bishops);
-	}
-
-	/* Rook attacks.  */
-	her_rooks = HER_ROOKS(pos) & rook_king_attacks[king_shift];
-	while (her_rooks) {
-		int rook_shift =
-			chi_bitv2shift(chi_clear_but_least_set(her_rooks));
-
-		if (!(rook_king_intermediates[king_shift][rook_shift] & occ_squares))
-			return 1;
-
-		her_rooks = chi_clear_least_set(her_rooks);
-	}
 
-	return 0;
+	return (chi_attackers_to(pos, king_shift, occ_squares)
+	        & HER_PIECES(pos)) != 0;
 }
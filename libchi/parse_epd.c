@@ -143,8 +143,16 @@ chi_parse_epd (epd, epdstr)
 
 	chi_ep (pos) = 1;
 	chi_ep_file (pos) = ep_file;
+	pos->ep_files[0] = ep_file;
+	pos->double_pawn_moves[0] = pos->half_moves;
+	pos->double_pawn_move_count = 1;
     }
 
+    /* EPD has no move counters.  The history starts here, so that moves
+       can be unapplied again.  */
+    pos->irreversible[0] = pos->half_moves;
+    pos->irreversible_count = 1;
+
     while (*ptr == ' ' || *ptr == '\t')
 	++ptr;
 
@@ -162,6 +162,8 @@ chi_parse_fen_position (chi_pos *argpos, const char *fen, const char **end_ptr)
 	pos->b_pieces = pos->b_pawns | pos->b_knights | pos->b_bishops | 
 	pos->b_rooks | pos->b_kings;
 
+	chi_update_psq (pos);
+
 	*end_ptr = ptr;
 
 	*argpos = *pos;
@@ -0,0 +1,137 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "magicmoves.h"
+
+#ifdef PEXTMOVES
+
+#include <cpuid.h>
+
+/* Defined in magicmoves.c.  */
+extern U64 initmagicmoves_Rmoves(const int square, const U64 occ);
+extern U64 initmagicmoves_Bmoves(const int square, const U64 occ);
+
+#ifdef MAGICMOVES_STATIC
+# include "pextdb.c"
+#else
+/* The number of entries is the same as for the minimized magic
+ * databases.
+ */
+static unsigned short pextmovesrdb[102400];
+static unsigned short pextmovesbdb[5248];
+
+pextmoves_entry pextmoves_r[64];
+pextmoves_entry pextmoves_b[64];
+#endif
+
+int pextmoves_enabled = 0;
+
+int
+pextmoves_cpu_supported(void)
+{
+	unsigned int eax, ebx, ecx, edx;
+
+	if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+		return 0;
+
+	return (ebx & bit_BMI2) != 0;
+}
+
+#ifdef MAGICMOVES_STATIC
+void
+initpextmoves(void)
+{
+	/* The databases are already filled at compile time.  */
+}
+#else
+/* Portable versions of the instructions, only used for filling the
+ * tables.
+ */
+static U64
+soft_pext(U64 src, U64 mask)
+{
+	U64 dest = 0;
+	U64 bit = 1;
+
+	while (mask) {
+		if (src & mask & -mask)
+			dest |= bit;
+		mask &= mask - 1;
+		bit <<= 1;
+	}
+
+	return dest;
+}
+
+static U64
+soft_pdep(U64 src, U64 mask)
+{
+	U64 dest = 0;
+	U64 bit = 1;
+
+	while (mask) {
+		if (src & bit)
+			dest |= mask & -mask;
+		mask &= mask - 1;
+		bit <<= 1;
+	}
+
+	return dest;
+}
+
+static unsigned short *
+init_square(pextmoves_entry *entry, unsigned short *db, int square,
+            U64 mask, U64 (*moves)(const int, const U64))
+{
+	U64 num_entries = 1ULL << __builtin_popcountll(mask);
+	U64 i;
+
+	entry->mask = mask;
+	entry->span = moves(square, 0);
+	entry->attacks = db;
+
+	for (i = 0; i < num_entries; ++i) {
+		U64 occupancy = soft_pdep(i, mask);
+
+		db[i] = soft_pext(moves(square, occupancy), entry->span);
+	}
+
+	return db + num_entries;
+}
+
+void
+initpextmoves(void)
+{
+	unsigned short *rdb = pextmovesrdb;
+	unsigned short *bdb = pextmovesbdb;
+	int i;
+
+	for (i = 0; i < 64; ++i) {
+		rdb = init_square(pextmoves_r + i, rdb, i, magicmoves_r_mask[i],
+		                  initmagicmoves_Rmoves);
+		bdb = init_square(pextmoves_b + i, bdb, i, magicmoves_b_mask[i],
+		                  initmagicmoves_Bmoves);
+	}
+}
+#endif
+
+#endif /* PEXTMOVES */
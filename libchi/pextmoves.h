@@ -0,0 +1,107 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Slider attacks with the BMI2 instructions PEXT and PDEP.
+ *
+ * This is an alternative backend for Rmagic() and Bmagic() from
+ * magicmoves.h.  The relevant occupancy bits of a square are gathered
+ * with PEXT and directly used as an index into a dense table.  The table
+ * does not store the full attack bitboard but only the bits along the
+ * rays of the square (at most 14 for a rook), and PDEP scatters them
+ * back.  The two databases have the same number of entries as the
+ * minimized magic databases but need only a quarter of the memory
+ * (210 KB instead of 841 KB).
+ *
+ * The instructions are emitted with inline assembler, so that the rest
+ * of the library does not have to be compiled with -mbmi2.  Whether the
+ * backend is actually used, is decided at runtime by chi_mm_init().
+ */
+
+#ifndef _pextmovesh
+#define _pextmovesh
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(CHI_DISABLE_PEXT)
+# define PEXTMOVES 1
+#endif
+
+#ifdef PEXTMOVES
+
+typedef struct pextmoves_entry {
+	/* Relevant occupancy bits, the same as for the magic numbers.  */
+	unsigned long long mask;
+	/* Attacks on an empty board.  */
+	unsigned long long span;
+	/* Compressed attacks, indexed by PEXT(occupancy, mask).  */
+	const unsigned short *attacks;
+} pextmoves_entry;
+
+extern pextmoves_entry pextmoves_r[64];
+extern pextmoves_entry pextmoves_b[64];
+
+/* Non-zero if Rmagic() and Bmagic() should use PEXT.  */
+extern int pextmoves_enabled;
+
+/* Return non-zero if the CPU supports BMI2.  */
+extern int pextmoves_cpu_supported(void);
+
+/* Fill the databases.  It is safe to call this on CPUs without BMI2.  */
+extern void initpextmoves(void);
+
+static __inline__ __attribute__((always_inline)) unsigned long long
+pextmoves_pext(unsigned long long src, unsigned long long mask)
+{
+	unsigned long long dest;
+
+	__asm__("pextq %2, %1, %0" : "=r" (dest) : "r" (src), "rm" (mask));
+
+	return dest;
+}
+
+static __inline__ __attribute__((always_inline)) unsigned long long
+pextmoves_pdep(unsigned long long src, unsigned long long mask)
+{
+	unsigned long long dest;
+
+	__asm__("pdepq %2, %1, %0" : "=r" (dest) : "r" (src), "rm" (mask));
+
+	return dest;
+}
+
+static __inline__ __attribute__((always_inline)) unsigned long long
+Rpext(const unsigned int square, const unsigned long long occupancy)
+{
+	const pextmoves_entry *entry = pextmoves_r + square;
+
+	return pextmoves_pdep(
+		entry->attacks[pextmoves_pext(occupancy, entry->mask)],
+		entry->span);
+}
+
+static __inline__ __attribute__((always_inline)) unsigned long long
+Bpext(const unsigned int square, const unsigned long long occupancy)
+{
+	const pextmoves_entry *entry = pextmoves_b + square;
+
+	return pextmoves_pdep(
+		entry->attacks[pextmoves_pext(occupancy, entry->mask)],
+		entry->span);
+}
+
+#endif /* PEXTMOVES */
+
+#endif /* _pextmovesh */
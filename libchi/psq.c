@@ -0,0 +1,219 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libchi.h"
+
+/* All tables are from white's point of view, starting with h1.  Black
+ * uses the same tables with the ranks mirrored.
+ */
+static const short psq_zero[64];
+
+/* Pawns in the center are worth more in the middle game.  */
+static const short psq_pawn_mg[64] = {
+	 0,  0,  0,  0,  0,  0,  0,  0,
+	 0,  0,  0,  0,  0,  0,  0,  0,
+	 0,  0,  0,  0,  0,  0,  0,  0,
+	 0,  0,  0,  8,  8,  0,  0,  0,
+	 0,  0, 16, 20, 20, 16,  0,  0,
+	 0,  0, 16, 24, 24, 16,  0,  0,
+	 0,  0,  8, 16, 16,  8,  0,  0,
+	 0,  0,  0,  0,  0,  0,  0,  0,
+};
+
+/* The king should stay behind his pawns in the middle game ...  */
+static const short psq_king_mg[64] = {
+	-1,  0, -2, -3, -3, -2,  0, -1,
+	-1, -1, -2, -3, -3, -2, -1, -1,
+	-3, -3, -3, -3, -3, -3, -3, -3,
+	-4, -4, -4, -4, -4, -4, -4, -4,
+	-5, -5, -5, -5, -5, -5, -5, -5,
+	-6, -6, -6, -6, -6, -6, -6, -6,
+	-7, -7, -7, -7, -7, -7, -7, -7,
+	-8, -8, -8, -8, -8, -8, -8, -8,
+};
+
+/* ... and move to the center in the end game.  */
+static const short psq_king_eg[64] = {
+	-30, -20, -10, -10, -10, -10, -20, -30,
+	-20, -10,   0,   0,   0,   0, -10, -20,
+	-10,   0,  10,  10,  10,  10,   0, -10,
+	-10,   0,  10,  20,  20,  10,   0, -10,
+	-10,   0,  10,  20,  20,  10,   0, -10,
+	-10,   0,  10,  10,  10,  10,   0, -10,
+	-20, -10,   0,   0,   0,   0, -10, -20,
+	-30, -20, -10, -10, -10, -10, -20, -30,
+};
+
+static const short *const psq_tables[2][7] = {
+	{
+		psq_zero, psq_pawn_mg, psq_zero, psq_zero,
+		psq_zero, psq_zero, psq_king_mg
+	},
+	{
+		psq_zero, psq_zero, psq_zero, psq_zero,
+		psq_zero, psq_zero, psq_king_eg
+	},
+};
+
+static const short psq_material[2][7] = {
+	{ 0, 100, 300, 300, 500, 900, 0 },
+	{ 0, 100, 300, 300, 500, 900, 0 },
+};
+
+#define psq(phase, piece, square) \
+	(psq_material[phase][piece] + psq_tables[phase][piece][square])
+
+/* The change of the score of the moving side for MOVE.  FLIP is 0 for
+ * white and 56 for black, so that SQUARE ^ FLIP is the square from the
+ * perspective of the moving side.
+ */
+static int
+move_delta(int phase, chi_move move, int flip)
+{
+	int from = chi_move_from(move) ^ flip;
+	int to = chi_move_to(move) ^ flip;
+	chi_piece_t attacker = chi_move_attacker(move);
+	chi_piece_t promote = chi_move_promote(move);
+	chi_piece_t victim = chi_move_victim(move);
+	int delta = psq(phase, promote ? promote : attacker, to)
+		- psq(phase, attacker, from);
+
+	if (victim) {
+		int victim_square = chi_move_is_ep(move) ? to - 8 : to;
+
+		/* Seen from the other side, the ranks are mirrored.  */
+		delta += psq(phase, victim, victim_square ^ 56);
+	} else if (attacker == king && from == CHI_E1) {
+		if (to == CHI_G1)
+			delta += psq(phase, rook, CHI_F1)
+				- psq(phase, rook, CHI_H1);
+		else if (to == CHI_C1)
+			delta += psq(phase, rook, CHI_D1)
+				- psq(phase, rook, CHI_A1);
+	}
+
+	return delta;
+}
+
+void
+chi_psq_move(chi_pos *pos, chi_move move, chi_color_t color, int sign)
+{
+	int flip = color == chi_white ? 0 : 56;
+	int white_sign = color == chi_white ? sign : -sign;
+
+	pos->psq[0] += white_sign * move_delta(0, move, flip);
+	pos->psq[1] += white_sign * move_delta(1, move, flip);
+
+	if (chi_move_victim(move))
+		pos->material_key -= (bitv64) sign
+			<< CHI_MATERIAL_SHIFT(!color, chi_move_victim(move));
+	if (chi_move_promote(move))
+		pos->material_key += ((bitv64) sign
+			<< CHI_MATERIAL_SHIFT(color, chi_move_promote(move)))
+			- ((bitv64) sign << CHI_MATERIAL_SHIFT(color, pawn));
+}
+
+static int
+sum_pieces(int phase, chi_piece_t piece, bitv64 mask, int flip)
+{
+	int score = 0;
+
+	while (mask) {
+		int square = chi_bitv2shift(chi_clear_but_least_set(mask));
+
+		score += psq(phase, piece, square ^ flip);
+		mask = chi_clear_least_set(mask);
+	}
+
+	return score;
+}
+
+static int
+sum_color(const chi_pos *pos, int phase, chi_color_t color)
+{
+	bitv64 pawns, knights, bishops, rooks, kings;
+	int flip;
+
+	if (color == chi_white) {
+		pawns = pos->w_pawns;
+		knights = pos->w_knights;
+		bishops = pos->w_bishops;
+		rooks = pos->w_rooks;
+		kings = pos->w_kings;
+		flip = 0;
+	} else {
+		pawns = pos->b_pawns;
+		knights = pos->b_knights;
+		bishops = pos->b_bishops;
+		rooks = pos->b_rooks;
+		kings = pos->b_kings;
+		flip = 56;
+	}
+
+	return sum_pieces(phase, pawn, pawns, flip)
+		+ sum_pieces(phase, knight, knights, flip)
+		+ sum_pieces(phase, bishop, bishops & ~rooks, flip)
+		+ sum_pieces(phase, rook, rooks & ~bishops, flip)
+		+ sum_pieces(phase, queen, bishops & rooks, flip)
+		+ sum_pieces(phase, king, kings, flip);
+}
+
+static bitv64
+material_key(const chi_pos *pos, chi_color_t color)
+{
+	bitv64 pawns, knights, bishops, rooks;
+
+	if (color == chi_white) {
+		pawns = pos->w_pawns;
+		knights = pos->w_knights;
+		bishops = pos->w_bishops;
+		rooks = pos->w_rooks;
+	} else {
+		pawns = pos->b_pawns;
+		knights = pos->b_knights;
+		bishops = pos->b_bishops;
+		rooks = pos->b_rooks;
+	}
+
+	return ((bitv64) chi_popcount(pawns) << CHI_MATERIAL_SHIFT(color, pawn))
+		| ((bitv64) chi_popcount(knights)
+		   << CHI_MATERIAL_SHIFT(color, knight))
+		| ((bitv64) chi_popcount(bishops & ~rooks)
+		   << CHI_MATERIAL_SHIFT(color, bishop))
+		| ((bitv64) chi_popcount(rooks & ~bishops)
+		   << CHI_MATERIAL_SHIFT(color, rook))
+		| ((bitv64) chi_popcount(bishops & rooks)
+		   << CHI_MATERIAL_SHIFT(color, queen));
+}
+
+void
+chi_update_psq(chi_pos *pos)
+{
+	int phase;
+
+	for (phase = 0; phase < 2; ++phase)
+		pos->psq[phase] = sum_color(pos, phase, chi_white)
+			- sum_color(pos, phase, chi_black);
+
+	pos->material_key = material_key(pos, chi_white)
+		| material_key(pos, chi_black);
+}
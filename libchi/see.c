@@ -16,24 +16,20 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-/*
- * This file gets included by movegen.c so because both need the
- * bitmasks from "bitmasks.c".  Yes, this is ugly ...
- */
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
 
 #include <sys/types.h>
 
-/* This source file gets #include'd itself by movegen.c which already
- * included bitmasks.c.  But since an IDE does not know this, we include
- * it hear once more in order to shut up warnings.
- */
-#include "bitmasks.c"
-
 #include "libchi.h"
-#include "./magicmoves.h"
+#include "bitmasks.h"
+#include "magicmoves.h"
 
-static unsigned piece_values[] = {
-	CHI_SEE_NO_VALUE, CHI_SEE_PAWN_VALUE, CHI_SEE_KNIGHT_VALUE, CHI_SEE_KNIGHT_VALUE, CHI_SEE_ROOK_VALUE, CHI_SEE_QUEEN_VALUE
+static int piece_values[] = {
+	CHI_SEE_NO_VALUE, CHI_SEE_PAWN_VALUE, CHI_SEE_KNIGHT_VALUE,
+	CHI_SEE_BISHOP_VALUE, CHI_SEE_ROOK_VALUE, CHI_SEE_QUEEN_VALUE,
+	CHI_SEE_KING_VALUE
 };
 
 bitv64
@@ -88,16 +84,16 @@ chi_obvious_attackers(const chi_pos *pos, chi_move mv,
 	bitv64 occupancy = (pos->w_pieces | pos->b_pieces)
 		& ~(-((bitv64) (chi_move_is_ep(mv) >> chi_move_ep_offset))
 		    & (1ULL << (to + ep_to_offsets[chi_on_move(pos)])));
-	bitv64 bishop_mask = Bmagic(to, occupancy) & not_from_mask;
-	bitv64 rook_mask = Rmagic(to, occupancy) & not_from_mask;
-	bitv64 queen_mask = bishop_mask | rook_mask;
+	bitv64 attackers = chi_attackers_to(pos, to, occupancy) & not_from_mask;
+	bitv64 w_attackers = attackers & pos->w_pieces;
+	bitv64 b_attackers = attackers & pos->b_pieces;
 	int maybe_promote = to > CHI_A7 || to < CHI_H2;
 	int shifted_pawn_value = (maybe_promote
 		? CHI_SEE_QUEEN_VALUE - CHI_SEE_PAWN_VALUE
 		: CHI_SEE_PAWN_VALUE) << 8;
 
 	/* White pawn captures.  */
-	mask = reverse_pawn_attacks[chi_white][to] & pos->w_pawns & not_from_mask;
+	mask = w_attackers & pos->w_pawns;
 	while (mask) {
 		int from = chi_bitv2shift(chi_clear_but_least_set(mask));
 		*white_attackers++ = from | shifted_pawn_value;
@@ -105,7 +101,7 @@ chi_obvious_attackers(const chi_pos *pos, chi_move mv,
 	}
 
 	/* Black pawn captures.  */
-	mask = reverse_pawn_attacks[chi_black][to] & pos->b_pawns & not_from_mask;
+	mask = b_attackers & pos->b_pawns;
 	while (mask) {
 		int from = chi_bitv2shift(chi_clear_but_least_set(mask));
 		*black_attackers++ = from | shifted_pawn_value;
@@ -113,8 +109,7 @@ chi_obvious_attackers(const chi_pos *pos, chi_move mv,
 	}
 
 	/* White knight and bishop captures.  */
-	mask = knight_attacks[to] & pos->w_knights & not_from_mask;
-	mask |= bishop_mask & pos->w_bishops & ~pos->w_rooks;
+	mask = w_attackers & (pos->w_knights | (pos->w_bishops & ~pos->w_rooks));
 	while (mask) {
 		int from = chi_bitv2shift(chi_clear_but_least_set(mask));
 		*white_attackers++ = from | CHI_SEE_KNIGHT_VALUE << 8;
@@ -122,8 +117,7 @@ chi_obvious_attackers(const chi_pos *pos, chi_move mv,
 	}
 
 	/* Black knight and bishop captures.  */
-	mask = knight_attacks[to] & pos->b_knights & not_from_mask;
-	mask |= bishop_mask & pos->b_bishops & ~pos->b_rooks;
+	mask = b_attackers & (pos->b_knights | (pos->b_bishops & ~pos->b_rooks));
 	while (mask) {
 		int from = chi_bitv2shift(chi_clear_but_least_set(mask));
 		*black_attackers++ = from | CHI_SEE_KNIGHT_VALUE << 8;
@@ -131,7 +125,7 @@ chi_obvious_attackers(const chi_pos *pos, chi_move mv,
 	}
 
 	/* White rook captures.  */
-	mask = rook_mask & ~pos->w_bishops & pos->w_rooks;
+	mask = w_attackers & ~pos->w_bishops & pos->w_rooks;
 	while (mask) {
 		int from = chi_bitv2shift(chi_clear_but_least_set(mask));
 		*white_attackers++ = from | CHI_SEE_ROOK_VALUE << 8;
@@ -139,7 +133,7 @@ chi_obvious_attackers(const chi_pos *pos, chi_move mv,
 	}
 
 	/* Black rook captures.  */
-	mask = rook_mask & ~pos->b_bishops & pos->b_rooks;
+	mask = b_attackers & ~pos->b_bishops & pos->b_rooks;
 	while (mask) {
 		int from = chi_bitv2shift(chi_clear_but_least_set(mask));
 		*black_attackers++ = from | CHI_SEE_ROOK_VALUE << 8;
@@ -147,7 +141,7 @@ chi_obvious_attackers(const chi_pos *pos, chi_move mv,
 	}
 
 	/* White queen captures.  */
-	mask = queen_mask & pos->w_bishops & pos->w_rooks;
+	mask = w_attackers & pos->w_bishops & pos->w_rooks;
 	while (mask) {
 		int from = chi_bitv2shift(chi_clear_but_least_set(mask));
 		*white_attackers++ = from | CHI_SEE_QUEEN_VALUE << 8;
@@ -155,7 +149,7 @@ chi_obvious_attackers(const chi_pos *pos, chi_move mv,
 	}
 
 	/* Black queen captures.  */
-	mask = queen_mask & pos->b_bishops & pos->b_rooks;
+	mask = b_attackers & pos->b_bishops & pos->b_rooks;
 	while (mask) {
 		int from = chi_bitv2shift(chi_clear_but_least_set(mask));
 		*black_attackers++ = from | CHI_SEE_QUEEN_VALUE << 8;
@@ -163,14 +157,14 @@ chi_obvious_attackers(const chi_pos *pos, chi_move mv,
 	}
 
 	/* White king captures.  */
-	mask = king_attacks[to] & pos->w_kings & not_from_mask;
+	mask = w_attackers & pos->w_kings;
 	if (mask) {
 		int from = chi_bitv2shift(chi_clear_but_least_set(mask));
 		*white_attackers++ = from | CHI_SEE_KING_VALUE << 8;
 	}
 
 	/* Black king captures.  */
-	mask = king_attacks[to] & pos->b_kings & not_from_mask;
+	mask = b_attackers & pos->b_kings;
 	if (mask) {
 		int from = chi_bitv2shift(chi_clear_but_least_set(mask));
 		*black_attackers++ = from | CHI_SEE_KING_VALUE << 8;
@@ -182,7 +176,7 @@ chi_obvious_attackers(const chi_pos *pos, chi_move mv,
 	return occupancy & not_from_mask;
 }
 
-int
+static int
 max(int a, int b) {
 	int diff = a - b;
 	int dsgn = diff >> 31;
@@ -190,125 +184,233 @@ max(int a, int b) {
 	return a - (diff & dsgn);
 }
 
-int
-chi_see(const chi_pos *position, chi_move move)
+/* Return the least valuable piece in ATTACKERS as a one-bit mask and
+ * store its type in PIECE.  ATTACKERS must not be empty.
+ */
+static bitv64
+least_valuable_attacker(const chi_pos *pos, bitv64 attackers,
+                        chi_piece_t *piece)
 {
-	unsigned attackers[32];
-	int gain[32];
-	off_t depth = 0;
-	chi_color_t side_to_move = ~chi_on_move(position) & 0x1;
+	bitv64 mask;
 
-	bitv64 occupancy = chi_obvious_attackers(position, move,
-			attackers, attackers + 16);
+	if ((mask = attackers & (pos->w_pawns | pos->b_pawns))) {
+		*piece = pawn;
+	} else if ((mask = attackers & (pos->w_knights | pos->b_knights))) {
+		*piece = knight;
+	} else if ((mask = attackers & ((pos->w_bishops & ~pos->w_rooks)
+	                                | (pos->b_bishops & ~pos->b_rooks)))) {
+		*piece = bishop;
+	} else if ((mask = attackers & ((pos->w_rooks & ~pos->w_bishops)
+	                                | (pos->b_rooks & ~pos->b_bishops)))) {
+		*piece = rook;
+	} else if ((mask = attackers & ((pos->w_bishops & pos->w_rooks)
+	                                | (pos->b_bishops & pos->b_rooks)))) {
+		*piece = queen;
+	} else {
+		mask = attackers;
+		*piece = king;
+	}
 
-	gain[0] = piece_values[chi_move_victim(move)];
+	return chi_clear_but_least_set(mask);
+}
+
+/* Remove the piece in FROM_MASK from OCCUPANCY and return the attackers
+ * of TO after that.  Bishops, rooks, and queens that were hidden behind
+ * the piece join the exchange.  A knight can never hide a slider, but a
+ * king can.
+ */
+static bitv64
+remove_attacker(const chi_pos *pos, int to, bitv64 *occupancy,
+                bitv64 attackers, bitv64 from_mask, chi_piece_t piece)
+{
+	*occupancy &= ~from_mask;
+
+	if (piece == pawn || piece == bishop || piece == queen
+	    || piece == king)
+		attackers |= Bmagic(to, *occupancy)
+			& (pos->w_bishops | pos->b_bishops);
+	if (piece == rook || piece == queen || piece == king)
+		attackers |= Rmagic(to, *occupancy)
+			& (pos->w_rooks | pos->b_rooks);
 
-	unsigned attacker_value = piece_values[chi_move_attacker(move)];
+	return attackers & *occupancy;
+}
+
+/* The pieces of the opponent of SIDE in ATTACKERS.  */
+#define THEIR_ATTACKERS(pos, attackers, side) \
+	((attackers) & ((side) == chi_white ? (pos)->b_pieces : (pos)->w_pieces))
+
+/* Play out the capture sequence on the target square of MOVE, always
+ * recapturing with the least valuable piece, and store the speculative
+ * gains in GAIN.  The return value is the index of the last entry.
+ *
+ * Whenever a piece leaves the square, the sliding attacks of the target
+ * square are looked up again with the new occupancy, so that bishops,
+ * rooks, and queens that were hidden behind it take part in the exchange.
+ */
+static int
+swap_list(const chi_pos *pos, chi_move move, int *gain)
+{
+	int to = chi_move_to(move);
+	int ep_to_offsets[2] = { -8, +8 };
+	bitv64 occupancy = (pos->w_pieces | pos->b_pieces)
+		& ~(1ULL << chi_move_from(move));
+	bitv64 attackers;
+	int maybe_promote = to > CHI_A7 || to < CHI_H2;
+	chi_color_t side = !chi_on_move(pos);
+	int on_square;
+	int depth = 0;
+
+	if (chi_move_is_ep(move))
+		occupancy &= ~(1ULL << (to + ep_to_offsets[chi_on_move(pos)]));
+	attackers = chi_attackers_to(pos, to, occupancy) & occupancy;
 
-	unsigned promote = chi_move_promote(move);
-	if (promote) {
-		/* unlikely */
-		gain[0] += piece_values[promote] - piece_values[pawn];
-		attacker_value = piece_values[promote];
+	gain[0] = piece_values[chi_move_victim(move)];
+	on_square = piece_values[chi_move_attacker(move)];
+	if (chi_move_promote(move)) {
+		gain[0] += piece_values[chi_move_promote(move)]
+			- CHI_SEE_PAWN_VALUE;
+		on_square = piece_values[chi_move_promote(move)];
 	}
 
-	/* One more reason to combine bishops and rooks of both sides into
-	 * one bitboard each.
-	 */
-	bitv64 sliding_mask = position->w_bishops | position->w_rooks
-			| position->b_bishops | position->b_rooks;
-	bitv64 sliding_bishops_mask = position->w_bishops | position->b_bishops;
-	bitv64 sliding_rooks_mask = position->w_rooks | position->b_rooks;
-	unsigned to = chi_move_to(move);
-	unsigned from = chi_move_from(move);
-
-	/*
-	 * These two pointers get incremented in turn.  If an x-ray attack is
-	 * detected, the currently moving piece gets replaced with the piece
-	 * that had been obscured, and the obscured piece is moved to its
-	 * correct position by continuous swaps.
-	 */
-	unsigned *attackers_ptr[2] = { attackers, attackers + 16 };
+	while (1) {
+		bitv64 my_attackers = attackers
+			& (side == chi_white ? pos->w_pieces : pos->b_pieces);
+		bitv64 from_mask;
+		chi_piece_t piece;
+
+		if (!my_attackers)
+			break;
+
+		from_mask = least_valuable_attacker(pos, my_attackers, &piece);
+		attackers = remove_attacker(pos, to, &occupancy, attackers,
+		                            from_mask, piece);
+
+		/* The king cannot capture into a defended square.  */
+		if (piece == king && THEIR_ATTACKERS(pos, attackers, side))
+			break;
 
-	while(1) {
 		++depth;
+		gain[depth] = on_square - gain[depth - 1];
+		on_square = piece_values[piece];
+		if (piece == pawn && maybe_promote) {
+			gain[depth] += CHI_SEE_QUEEN_VALUE - CHI_SEE_PAWN_VALUE;
+			on_square = CHI_SEE_QUEEN_VALUE;
+		}
 
-		gain[depth] = attacker_value - gain[depth - 1];
-
-		/* Add x-ray attackers.  */
-		bitv64 obscured_mask = obscured_masks[from][to];
-		if (sliding_mask & obscured_mask) {
-			/* This is now the slow but unlikely part.  */
-			unsigned direction = obscurance_directions[from][to];
-			unsigned is_bishop = direction & 1;
-			direction >>= 1;
-			bitv64 mask = 0, piece_mask = 0;
-			chi_color_t color = chi_white;
-			chi_piece_t piece = bishop;
-
-			if (is_bishop
-			    && (obscured_mask & sliding_bishops_mask)) {
-				mask = sliding_bishops_mask & Bmagic(to, occupancy);
-			} else if (!is_bishop
-			           && (obscured_mask & sliding_rooks_mask)) {
-				mask = sliding_rooks_mask & Rmagic(to, occupancy);
-				piece = rook;
-			}
-			if (obscured_mask & mask) {
-				if (direction == 0) {
-					/* Right/lower.  Most significant bit.  */
-					piece_mask = chi_clear_but_most_set(obscured_mask & mask);
-				} else {
-					/* Left/higher.  Least significant bit.  */
-					piece_mask = chi_clear_but_least_set(obscured_mask & mask);
-				}
-				if (piece_mask) {
-					if (piece_mask & position->b_pieces) {
-						color = chi_black;
-						if (piece_mask & position->b_bishops & position->b_rooks) {
-							piece = queen;
-						}
-					} else {
-						if (piece_mask & position->w_bishops & position->w_rooks) {
-							piece = queen;
-						}
-					}
-
-					/* Now insert the x-ray attacker into the list.  Since the
-					* piece is encoded in the upper bytes, we can do a simple,
-					* unmasked comparison.
-					*/
-#define swap(a, b) ((((a) -= (b)), ((b) += (a)), ((a) = (b) - (a))))
-					unsigned *ptr = --attackers_ptr[color];
-					*ptr = piece_values[piece] << 8 | chi_bitv2shift(piece_mask);
-					while (*++ptr) {
-						if (ptr[0] < ptr[-1]) {
-							swap(ptr[-1], ptr[0]);
-						}
-					}
-				}
-			}
+		/* GAIN[DEPTH] is an upper bound for this capture because the
+		 * opponent can always stop the exchange.  If not capturing is
+		 * at least as good, the rest of the sequence does not matter.
+		 */
+		if (gain[depth] <= -gain[depth - 1]) {
+			--depth;
+			break;
 		}
 
-		unsigned attacker_def = *(attackers_ptr[side_to_move]++);
-		if (!attacker_def) break;
+		side = !side;
+	}
 
-		// FIXME! Maybe cast attacker_def to an array of two shorts.
-		attacker_value = attacker_def >> 8;
-		from = attacker_def & 0xff;
+	return depth;
+}
 
-		/* Can we prune? */
-		if (max(-gain[depth - 1], gain[depth]) < 0)
-			break;
+int
+chi_see(const chi_pos *position, chi_move move)
+{
+	/* There are only 32 pieces on the board.  */
+	int gain[32];
+	int depth = swap_list(position, move, gain);
+
+	while (depth) {
+		gain[depth - 1] = -max(-gain[depth - 1], gain[depth]);
+		--depth;
+	}
 
-		occupancy &= ~(1ULL << from);
+	return gain[0];
+}
 
-		side_to_move = ~side_to_move & 0x1;
+int
+chi_see_ge(const chi_pos *pos, chi_move move, int threshold)
+{
+	int to = chi_move_to(move);
+	int ep_to_offsets[2] = { -8, +8 };
+	int maybe_promote = to > CHI_A7 || to < CHI_H2;
+	chi_color_t mover = chi_on_move(pos);
+	chi_color_t side;
+	bitv64 occupancy, attackers;
+	int balance, on_square, need;
+	/* A pawn that recaptures on the last rank also gains a queen.  */
+	int promotion = maybe_promote
+		? CHI_SEE_QUEEN_VALUE - CHI_SEE_PAWN_VALUE : 0;
+
+	/* BALANCE is the result of the exchange so far minus THRESHOLD,
+	 * from the point of view of SIDE.  The side on move reaches the
+	 * threshold with a balance of at least 0, the opponent defeats it
+	 * with a balance of at least 1.
+	 */
+	balance = piece_values[chi_move_victim(move)] - threshold;
+	on_square = piece_values[chi_move_attacker(move)];
+	if (chi_move_promote(move)) {
+		balance += piece_values[chi_move_promote(move)]
+			- CHI_SEE_PAWN_VALUE;
+		on_square = piece_values[chi_move_promote(move)];
 	}
 
-	while (--depth) {
-		gain[depth - 1]= -max(-gain[depth - 1], gain[depth]);
+	/* Even if the opponent does not recapture, the gain is too low.  */
+	if (balance < 0)
+		return 0;
+
+	/* Even if the moving piece is lost, the threshold is reached,
+	 * because the side on move can always stop exchanging.
+	 */
+	if (balance - on_square - promotion >= 0)
+		return 1;
+
+	occupancy = (pos->w_pieces | pos->b_pieces)
+		& ~(1ULL << chi_move_from(move));
+	if (chi_move_is_ep(move))
+		occupancy &= ~(1ULL << (to + ep_to_offsets[mover]));
+	attackers = chi_attackers_to(pos, to, occupancy) & occupancy;
+
+	side = !mover;
+	balance = -balance;
+	while (1) {
+		bitv64 my_attackers = attackers
+			& (side == chi_white ? pos->w_pieces : pos->b_pieces);
+		bitv64 from_mask;
+		chi_piece_t piece;
+
+		need = side == mover ? 0 : 1;
+
+		/* Stopping the exchange is good enough.  */
+		if (balance >= need)
+			break;
+
+		/* Otherwise, SIDE has to capture, or loses.  */
+		if (!my_attackers)
+			return side != mover;
+
+		from_mask = least_valuable_attacker(pos, my_attackers, &piece);
+		attackers = remove_attacker(pos, to, &occupancy, attackers,
+		                            from_mask, piece);
+
+		/* The king cannot capture into a defended square.  */
+		if (piece == king && THEIR_ATTACKERS(pos, attackers, side))
+			return side != mover;
+
+		balance += on_square;
+		on_square = piece_values[piece];
+		if (piece == pawn && maybe_promote) {
+			balance += promotion;
+			on_square = CHI_SEE_QUEEN_VALUE;
+		}
+
+		/* Even if the capturing piece is lost, SIDE is ahead.  */
+		if (balance - on_square - promotion >= need)
+			break;
+
+		balance = -balance;
+		side = !side;
 	}
 
-	return gain[0];
+	return side == mover;
 }
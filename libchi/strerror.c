@@ -35,7 +35,8 @@ static const char* error_strings[] = {
     "illegal castling state",
     "cannot parse EPD string",
     "illegal library usage",
-	"ambiguous move"
+	"ambiguous move",
+	"not supported"
 };
 
 const char*
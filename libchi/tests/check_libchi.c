@@ -34,6 +34,10 @@ extern Suite *fen_suite();
 extern Suite *coordinate_notation_suite();
 extern Suite *legal_moves_suite();
 extern Suite *see_suite();
+extern Suite *mm_backend_suite();
+extern Suite *psq_suite();
+extern Suite *zobrist_suite();
+extern Suite *kpk_suite();
 
 int
 main(int argc, char *argv[])
@@ -52,6 +56,10 @@ main(int argc, char *argv[])
 //	srunner_add_suite(runner, coordinate_notation_suite());
 //	srunner_add_suite(runner, legal_moves_suite());
 	srunner_add_suite(runner, see_suite());
+	srunner_add_suite(runner, mm_backend_suite());
+	srunner_add_suite(runner, psq_suite());
+	srunner_add_suite(runner, zobrist_suite());
+	srunner_add_suite(runner, kpk_suite());
 
 	srunner_run_all(runner, CK_NORMAL);
 	failed = srunner_ntests_failed(runner);
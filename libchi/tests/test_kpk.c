@@ -0,0 +1,87 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <check.h>
+
+#include "libchi.h"
+
+struct kpk_test {
+	const char *fen;
+	int win;
+};
+
+static const struct kpk_test kpk_tests[] = {
+	/* King on the sixth rank in front of the pawn.  */
+	{ "4k3/8/4K3/4P3/8/8/8/8 w - - 0 1", 1 },
+	{ "4k3/8/4K3/4P3/8/8/8/8 b - - 0 1", 1 },
+	/* Opposition decides.  */
+	{ "4k3/8/8/4K3/4P3/8/8/8 w - - 0 1", 1 },
+	{ "8/4k3/8/4K3/4P3/8/8/8 w - - 0 1", 0 },
+	{ "8/4k3/8/4K3/4P3/8/8/8 b - - 0 1", 1 },
+	/* Defending king in front of the pawn.  */
+	{ "8/8/8/8/8/4k3/4P3/4K3 w - - 0 1", 0 },
+	{ "4k3/8/8/8/8/8/4P3/4K3 w - - 0 1", 1 },
+	/* The rook pawn cannot win against a king in the corner.  */
+	{ "k7/8/K7/P7/8/8/8/8 w - - 0 1", 0 },
+	{ "7k/8/7K/7P/8/8/8/8 b - - 0 1", 0 },
+	/* Stalemate.  */
+	{ "k7/P7/1K6/8/8/8/8/8 b - - 0 1", 0 },
+	/* The pawn runs away.  */
+	{ "8/1P6/8/8/8/8/7k/K7 w - - 0 1", 1 },
+	{ "7k/8/8/8/8/8/P7/K7 b - - 0 1", 1 },
+	{ "2k5/8/8/8/8/8/P7/K7 b - - 0 1", 0 },
+	/* Black pawns, mirrored from above.  */
+	{ "8/8/8/8/4p3/4k3/8/4K3 b - - 0 1", 1 },
+	{ "8/8/8/4p3/4k3/8/4K3/8 b - - 0 1", 0 },
+	{ "4k3/4p3/4K3/8/8/8/8/8 b - - 0 1", 0 },
+	{ "8/8/8/8/p7/k7/8/K7 w - - 0 1", 0 },
+};
+
+START_TEST(test_kpk)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof kpk_tests / sizeof kpk_tests[0]; ++i) {
+		chi_pos pos;
+
+		ck_assert_int_eq(chi_set_position(&pos, kpk_tests[i].fen), 0);
+		ck_assert_msg(chi_kpk_probe(&pos) == kpk_tests[i].win,
+		              "%s: expected %s", kpk_tests[i].fen,
+		              kpk_tests[i].win ? "win" : "draw");
+	}
+}
+END_TEST
+
+Suite *
+kpk_suite(void)
+{
+	Suite *suite;
+	TCase *tc_kpk;
+
+	suite = suite_create("KPK Bitbase");
+
+	tc_kpk = tcase_create("Known positions");
+	tcase_add_test(tc_kpk, test_kpk);
+	suite_add_tcase(suite, tc_kpk);
+
+	return suite;
+}
@@ -0,0 +1,95 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <check.h>
+
+#include "libchi.h"
+#include "../magicmoves.h"
+
+/* Simple xorshift generator so that the test is reproducible.  */
+static bitv64
+next_random(bitv64 *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+
+	return *state;
+}
+
+START_TEST(test_mm_backend_names)
+{
+	ck_assert_str_eq(chi_mm_backend_name(chi_mm_magic), "magic");
+	ck_assert_str_eq(chi_mm_backend_name(chi_mm_pext), "pext");
+	ck_assert_int_eq(chi_mm_set_backend(chi_mm_magic), CHI_ERR_SUCCESS);
+	ck_assert_int_eq(chi_mm_get_backend(), chi_mm_magic);
+}
+END_TEST
+
+START_TEST(test_mm_backends_agree)
+{
+	chi_mm_backend saved = chi_mm_get_backend();
+	bitv64 state = 0x2545f4914f6cdd1dULL;
+	unsigned int square;
+	int i;
+
+	if (chi_mm_set_backend(chi_mm_pext) == CHI_ERR_NOT_SUPPORTED)
+		return;
+
+	for (square = 0; square < 64; ++square) {
+		for (i = 0; i < 1000; ++i) {
+			bitv64 occupancy = next_random(&state) & next_random(&state);
+			bitv64 rook, bishop;
+
+			/* Sparse and dense boards.  */
+			if (i & 1)
+				occupancy |= next_random(&state);
+
+			ck_assert_int_eq(chi_mm_set_backend(chi_mm_magic), 0);
+			rook = Rmagic(square, occupancy);
+			bishop = Bmagic(square, occupancy);
+
+			ck_assert_int_eq(chi_mm_set_backend(chi_mm_pext), 0);
+			ck_assert_uint_eq(Rmagic(square, occupancy), rook);
+			ck_assert_uint_eq(Bmagic(square, occupancy), bishop);
+		}
+	}
+
+	ck_assert_int_eq(chi_mm_set_backend(saved), 0);
+}
+END_TEST
+
+Suite *
+mm_backend_suite(void)
+{
+	Suite *suite;
+	TCase *tc_backend;
+
+	suite = suite_create("Slider Attack Backends");
+
+	tc_backend = tcase_create("Backends");
+	tcase_add_test(tc_backend, test_mm_backend_names);
+	tcase_add_test(tc_backend, test_mm_backends_agree);
+	suite_add_tcase(suite, tc_backend);
+
+	return suite;
+}
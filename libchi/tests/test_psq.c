@@ -0,0 +1,123 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <check.h>
+
+#include "libchi.h"
+
+/*
+ * Walk the tree of a position and check that the incrementally updated
+ * piece-square scores and material key always match the values computed
+ * from scratch.
+ */
+static void
+check_psq_tree(chi_pos *pos, int depth)
+{
+	chi_move moves[CHI_MAX_MOVES];
+	chi_move *end = chi_legal_moves(pos, moves);
+	chi_move *mv;
+	int mg = chi_psq_mg(pos);
+	int eg = chi_psq_eg(pos);
+	bitv64 key = chi_material_key(pos);
+
+	for (mv = moves; mv < end; ++mv) {
+		chi_pos fresh;
+
+		ck_assert_int_eq(chi_apply_move(pos, *mv), 0);
+
+		chi_copy_pos(&fresh, pos);
+		chi_update_psq(&fresh);
+		ck_assert_int_eq(chi_psq_mg(pos), chi_psq_mg(&fresh));
+		ck_assert_int_eq(chi_psq_eg(pos), chi_psq_eg(&fresh));
+		ck_assert_uint_eq(chi_material_key(pos), chi_material_key(&fresh));
+
+		if (depth > 1)
+			check_psq_tree(pos, depth - 1);
+
+		ck_assert_int_eq(chi_unapply_move(pos, *mv), 0);
+		ck_assert_int_eq(chi_psq_mg(pos), mg);
+		ck_assert_int_eq(chi_psq_eg(pos), eg);
+		ck_assert_uint_eq(chi_material_key(pos), key);
+	}
+}
+
+START_TEST(test_psq_initial)
+{
+	chi_pos pos;
+
+	/* The tables are symmetric.  */
+	chi_init_position(&pos);
+	ck_assert_int_eq(chi_psq_mg(&pos), 0);
+	ck_assert_int_eq(chi_psq_eg(&pos), 0);
+	ck_assert_uint_eq(CHI_MATERIAL_COUNT(chi_material_key(&pos),
+	                                     chi_black, pawn), 8);
+	ck_assert_uint_eq(CHI_MATERIAL_COUNT(chi_material_key(&pos),
+	                                     chi_white, queen), 1);
+
+	ck_assert_int_eq(chi_set_position(&pos, "4k3/8/8/8/8/8/8/R3K3 w - - 0 1"),
+	                 0);
+	ck_assert_int_eq(chi_psq_mg(&pos), 500);
+	ck_assert_int_eq(chi_psq_eg(&pos), 500);
+	ck_assert_uint_eq(CHI_MATERIAL_COUNT(chi_material_key(&pos),
+	                                     chi_white, rook), 1);
+	ck_assert_uint_eq(chi_material_key(&pos),
+	                  (bitv64) 1 << CHI_MATERIAL_SHIFT(chi_white, rook));
+}
+END_TEST
+
+START_TEST(test_psq_incremental)
+{
+	const char *fens[] = {
+		/* Captures and castlings for both sides.  */
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b KQkq - 0 1",
+		/* Promotions for both sides.  */
+		"n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+		/* En passant.  */
+		"8/8/8/2k5/3Pp3/8/8/4K3 b - d3 0 1",
+	};
+	size_t i;
+
+	for (i = 0; i < sizeof fens / sizeof fens[0]; ++i) {
+		chi_pos pos;
+
+		ck_assert_int_eq(chi_set_position(&pos, fens[i]), 0);
+		check_psq_tree(&pos, 3);
+	}
+}
+END_TEST
+
+Suite *
+psq_suite(void)
+{
+	Suite *suite;
+	TCase *tc_psq;
+
+	suite = suite_create("Piece-Square Scores");
+
+	tc_psq = tcase_create("Incremental Update");
+	tcase_add_test(tc_psq, test_psq_initial);
+	tcase_add_test(tc_psq, test_psq_incremental);
+	suite_add_tcase(suite, tc_psq);
+
+	return suite;
+}
@@ -183,7 +183,7 @@ static SEETest tests[] = {
 		__LINE__,
 		"2r5/1P4pk/p2p1b1p/5b1n/BB3p2/2R2p2/P1P2P2/4RK2 w - -",
 		"Rxc8",
-		CHI_SEE_BISHOP_VALUE  // Was originally CHI_SEE_ROOK_VALUE.
+		CHI_SEE_ROOK_VALUE
 	},
 	{
 		__FILE__,
@@ -258,6 +258,15 @@ START_TEST(test_see_positions)
 			report_failure(test, 0, "Expected score %d, got score %d.\n",
 					test->score, score);
 		}
+
+		if (!chi_see_ge(&position, move, test->score)) {
+			report_failure(test, 0, "SEE should be >= %d.\n",
+					test->score);
+		}
+		if (chi_see_ge(&position, move, test->score + 1)) {
+			report_failure(test, 0, "SEE should be < %d.\n",
+					test->score + 1);
+		}
 	}
 }
 END_TEST
@@ -655,6 +664,37 @@ START_TEST(test_see_x_ray_attacks)
 	ck_assert_int_eq(score, -200);
 }
 
+/* The threshold version must agree with the full evaluation for all
+ * captures in the test positions.
+ */
+START_TEST(test_see_ge_all_captures)
+{
+	size_t num_tests = sizeof tests / sizeof tests[0];
+	chi_move moves[CHI_MAX_MOVES];
+	chi_move *end;
+	chi_move *move;
+	chi_pos position;
+	int score, threshold;
+	size_t i;
+
+	for (i = 0; i < num_tests; ++i) {
+		ck_assert_int_eq(chi_set_position(&position, tests[i].fen), 0);
+		end = chi_legal_moves(&position, moves);
+		for (move = moves; move < end; ++move) {
+			if (!chi_move_victim(*move) && !chi_move_promote(*move))
+				continue;
+			score = chi_see(&position, *move);
+			for (threshold = -1500; threshold <= 1500; threshold += 50) {
+				ck_assert_int_eq(chi_see_ge(&position, *move, threshold),
+				                 score >= threshold);
+			}
+			ck_assert(chi_see_ge(&position, *move, score));
+			ck_assert(!chi_see_ge(&position, *move, score + 1));
+		}
+	}
+}
+END_TEST
+
 Suite *
 see_suite(void)
 {
@@ -675,6 +715,7 @@ see_suite(void)
 	tcase_add_test(tc_see, test_see_queen_hits_defended_pawn);
 	tcase_add_test(tc_see, test_see_x_ray_attacks);
 	tcase_add_test(tc_see, test_see_positions);
+	tcase_add_test(tc_see, test_see_ge_all_captures);
 	suite_add_tcase(suite, tc_see);
 
 	return suite;
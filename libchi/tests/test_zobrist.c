@@ -0,0 +1,153 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <check.h>
+
+#include "libchi.h"
+
+/*
+ * Walk the tree of a position and check that the incrementally updated
+ * signatures always match the signatures computed from scratch.
+ */
+static void
+check_signature_tree(chi_zk_handle zk_handle, chi_pos *pos,
+                     bitv64 signature, bitv64 pawn_signature, int depth)
+{
+	chi_move moves[CHI_MAX_MOVES];
+	chi_move *end = chi_legal_moves(pos, moves);
+	chi_move *mv;
+
+	for (mv = moves; mv < end; ++mv) {
+		chi_color_t color = chi_on_move(pos);
+		bitv64 new_signature = chi_zk_update_signature(zk_handle,
+			signature, *mv, color);
+		bitv64 new_pawn_signature = chi_zk_update_pawn_signature(
+			zk_handle, pawn_signature, *mv, color);
+
+		ck_assert_int_eq(chi_apply_move(pos, *mv), 0);
+
+		ck_assert_uint_eq(new_signature,
+		                  chi_zk_signature(zk_handle, pos));
+		ck_assert_uint_eq(new_pawn_signature,
+		                  chi_zk_pawn_signature(zk_handle, pos));
+
+		if (depth > 1)
+			check_signature_tree(zk_handle, pos, new_signature,
+			                     new_pawn_signature, depth - 1);
+
+		ck_assert_int_eq(chi_unapply_move(pos, *mv), 0);
+	}
+}
+
+START_TEST(test_zk_incremental)
+{
+	const char *fens[] = {
+		/* Captures and castlings for both sides.  */
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b KQkq - 0 1",
+		/* Promotions for both sides.  */
+		"n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+		/* En passant.  */
+		"8/8/8/2k5/3Pp3/8/8/4K3 b - d3 0 1",
+	};
+	chi_zk_handle zk_handle;
+	size_t i;
+
+	ck_assert_int_eq(chi_zk_init(&zk_handle), 0);
+
+	for (i = 0; i < sizeof fens / sizeof fens[0]; ++i) {
+		chi_pos pos;
+
+		ck_assert_int_eq(chi_set_position(&pos, fens[i]), 0);
+		check_signature_tree(zk_handle, &pos,
+		                     chi_zk_signature(zk_handle, &pos),
+		                     chi_zk_pawn_signature(zk_handle, &pos), 3);
+	}
+
+	chi_zk_finish(zk_handle);
+}
+END_TEST
+
+START_TEST(test_zk_pawn_signature)
+{
+	chi_zk_handle zk_handle;
+	chi_pos pos1, pos2;
+
+	ck_assert_int_eq(chi_zk_init(&zk_handle), 0);
+
+	/* Same pawns, different pieces.  */
+	ck_assert_int_eq(chi_set_position(&pos1,
+		"4k3/pp6/8/8/8/8/5PPP/4K3 w - - 0 1"), 0);
+	ck_assert_int_eq(chi_set_position(&pos2,
+		"r3k3/pp6/8/8/8/8/5PPP/1N2K3 b - - 0 1"), 0);
+	ck_assert_uint_eq(chi_zk_pawn_signature(zk_handle, &pos1),
+	                  chi_zk_pawn_signature(zk_handle, &pos2));
+
+	/* A white pawn and a black pawn on the same rank two files apart
+	 * used to cancel each other out.
+	 */
+	ck_assert_int_eq(chi_set_position(&pos2,
+		"4k3/pp6/8/8/3P1p2/8/5PPP/4K3 w - - 0 1"), 0);
+	ck_assert_uint_ne(chi_zk_pawn_signature(zk_handle, &pos1),
+	                  chi_zk_pawn_signature(zk_handle, &pos2));
+
+	chi_zk_finish(zk_handle);
+}
+END_TEST
+
+START_TEST(test_zk_stable)
+{
+	chi_zk_handle zk_handle1, zk_handle2;
+	chi_pos pos;
+
+	/* Signatures are stored in files and must not change between
+	 * processes.
+	 */
+	ck_assert_int_eq(chi_zk_init(&zk_handle1), 0);
+	ck_assert_int_eq(chi_zk_init(&zk_handle2), 0);
+
+	chi_init_position(&pos);
+	ck_assert_uint_eq(chi_zk_signature(zk_handle1, &pos),
+	                  chi_zk_signature(zk_handle2, &pos));
+	ck_assert_uint_ne(chi_zk_signature(zk_handle1, &pos), 0);
+
+	chi_zk_finish(zk_handle2);
+	chi_zk_finish(zk_handle1);
+}
+END_TEST
+
+Suite *
+zobrist_suite(void)
+{
+	Suite *suite;
+	TCase *tc_zobrist;
+
+	suite = suite_create("Zobrist Keys");
+
+	tc_zobrist = tcase_create("Signatures");
+	tcase_add_test(tc_zobrist, test_zk_incremental);
+	tcase_add_test(tc_zobrist, test_zk_pawn_signature);
+	tcase_add_test(tc_zobrist, test_zk_stable);
+	suite_add_tcase(suite, tc_zobrist);
+
+	return suite;
+}
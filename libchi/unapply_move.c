@@ -76,6 +76,7 @@ chi_unapply_move(chi_pos *pos, chi_move move)
 	} else {
 		chi_material(pos) -= chi_move_material(move);
 	}
+	chi_psq_move(pos, move, chi_on_move(pos), -1);
 
 	if (pos->lost_wk_castle == pos->half_moves)
 		chi_wk_castle(pos) = 1;
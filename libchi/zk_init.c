@@ -21,25 +21,33 @@
 #endif
 
 #include <stdlib.h>
-#include <string.h>
-#include <time.h>
-
-#include <sys/types.h>
-#include <fcntl.h>
-#include <unistd.h>
 
 #include <libchi.h>
 
 #define ZK_ARRAY_SIZE (((king + 1) * 2 * 64) + 1)
 
+/* Seed for the keys of CHI_ZK_VERSION.  */
+#define ZK_SEED 0x6c6973636f7a6b31ULL
+
+/* The SplitMix64 generator.  */
+static bitv64
+zk_next (state)
+     bitv64* state;
+{
+    bitv64 z = (*state += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
 int
 chi_zk_init (result)
      chi_zk_handle* result;
 {
-    int fd;
-    int seeded = 0;
+    bitv64 state = ZK_SEED;
     int i;
-    int dev_urandom = 0;
 
     chi_zk_handle zk_handle = 
 	malloc (ZK_ARRAY_SIZE * sizeof *zk_handle);
@@ -49,52 +57,11 @@ chi_zk_init (result)
     if (!zk_handle)
 	return CHI_ERR_ENOMEM;
 
-    /* Fill the array with random bits.  FIXME: Why does this has to
-       be random?  It should be sufficient to generate the random data
-       once at compile-time and reuse it every time the library is
-       invoked? */
-    fd = open ("/dev/urandom", O_RDONLY);
-    if (fd != -1) {
-	char* ptr = (char*) zk_handle;
-	size_t bytes_read = 0;
-	size_t wanted = ZK_ARRAY_SIZE * sizeof *zk_handle;
-
-	while (bytes_read < wanted) {
-	    int bytes_here = read (fd, ptr + bytes_read, wanted - bytes_read);
-	    
-	    if (bytes_here == -1)
-		break;
-
-	    bytes_read += bytes_here;
-	}
-
-	dev_urandom = 1;
-	close (fd);
-    }
-
-    if (dev_urandom)
-	return 0;
-
-    if (!seeded) {
-	srandom (time (NULL));
-	seeded = 1;
-    }
-    
-    for (i = 0; i < ZK_ARRAY_SIZE; ++i) {
-	bitv64 number = (bitv64) random ();
-	
-	/* Not perfectly random, since we will never generate 
-	   numbers that have the upper 8 bits unset but this
-	       takes into account that random () might return only
-	       16 bits or whatever.  */
-#define ZK_UPPER_8 (((bitv64) 0xff) << 56)
-	
-	while (!(number & ZK_UPPER_8)) {
-	    number <<= 8;
-	    number ^= random ();
-	}
-	zk_handle[i] = number;
-    }
+    /* The keys are the same in every process, so that signatures can be
+       stored in files.  Increment CHI_ZK_VERSION whenever they
+       change.  */
+    for (i = 0; i < ZK_ARRAY_SIZE; ++i)
+	zk_handle[i] = zk_next (&state);
 
     return 0;
 }
@@ -0,0 +1,60 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <libchi.h>
+
+bitv64
+chi_zk_pawn_signature (chi_zk_handle zk_handle, chi_pos* pos)
+{
+    bitv64 sig = (bitv64) 0;
+    bitv64 piece_mask;
+
+    piece_mask = pos->w_pawns;
+    while (piece_mask) {
+	unsigned int shift = 
+	    chi_bitv2shift (chi_clear_but_least_set (piece_mask));
+	
+	sig ^= chi_zk_lookup (zk_handle, pawn, chi_white, shift);
+
+	piece_mask = chi_clear_least_set (piece_mask);
+    }
+    
+    piece_mask = pos->b_pawns;
+    while (piece_mask) {
+	unsigned int shift = 
+	    chi_bitv2shift (chi_clear_but_least_set (piece_mask));
+	
+	sig ^= chi_zk_lookup (zk_handle, pawn, chi_black, shift);
+
+	piece_mask = chi_clear_least_set (piece_mask);
+    }
+
+    return sig;
+}
+
+/*
+Local Variables:
+mode: c
+c-style: K&R
+c-basic-shift: 8
+End:
+*/
@@ -0,0 +1,63 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <libchi.h>
+
+bitv64
+chi_zk_update_pawn_signature (chi_zk_handle zk_handle, bitv64 signature,
+                              chi_move move, chi_color_t color)
+{
+    chi_piece_t attacker = chi_move_attacker (move);
+    chi_piece_t victim = chi_move_victim (move);
+    int to = chi_move_to (move);
+
+    if (color != chi_white)
+	color = chi_black;
+
+    if (attacker == pawn) {
+	signature ^= chi_zk_lookup (zk_handle, pawn, color,
+				    chi_move_from (move));
+	/* A promoted pawn disappears from the pawn structure.  */
+	if (!chi_move_promote (move))
+	    signature ^= chi_zk_lookup (zk_handle, pawn, color, to);
+    }
+
+    if (victim == pawn) {
+	if (chi_move_is_ep (move)) {
+	    if (color == chi_white)
+		to -= 8;
+	    else
+		to += 8;
+	}
+	signature ^= chi_zk_lookup (zk_handle, pawn, !color, to);
+    }
+
+    return signature;
+}
+
+/*
+Local Variables:
+mode: c
+c-style: K&R
+c-basic-shift: 8
+End:
+*/
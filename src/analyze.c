@@ -0,0 +1,454 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Batch analysis of EPD and FEN files, "lisco analyze FILE".
+ *
+ * The lines of the file are handed out to a pool of worker threads.
+ * Every worker runs one search at a time with its own hash tables and
+ * writes the result as one line of JSON, in the order in which the
+ * searches finish.  The field "index" is the line number.
+ *
+ * The limits from the command line can be overridden for a single
+ * position with the EPD opcodes acd (depth), acn (nodes) and acs
+ * (seconds).  If the line has a bm or am opcode, the result also tells
+ * whether the position was solved, and when.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <error.h>
+#include <progname.h>
+#include <xalloc.h>
+#include <xstrndup.h>
+
+#include <libchi.h>
+
+#include "lisco.h"
+
+typedef struct Analysis {
+	FILE *in;
+	FILE *out;
+	/* Limits for positions without acd, acn or acs.  */
+	const SearchParams *limits;
+	/* Protects IN and LINES.  */
+	pthread_mutex_t mutex;
+	unsigned long lines;
+} Analysis;
+
+static void
+usage(int status)
+{
+	if (status != EXIT_SUCCESS) {
+		fprintf(stderr, "Try '%s analyze -h' for more information.\n",
+		        program_name);
+		exit(status);
+	}
+
+	printf("Usage: %s analyze [OPTION]... [FILE]\n", program_name);
+	printf("Analyze the EPD or FEN positions in FILE, one per line, and"
+	       " print the results\nas JSON lines.  With no FILE, or when"
+	       " FILE is -, read standard input.\n\n");
+	printf("  -d DEPTH      search every position to DEPTH plies\n");
+	printf("  -n NODES      stop every search after NODES nodes\n");
+	printf("  -t MSECS      search every position for MSECS"
+	       " milliseconds\n");
+	printf("  -H MEGABYTES  size of the transposition table of each"
+	       " thread (default: %d)\n", LISCO_DEFAULT_TT_SIZE);
+	printf("  -j THREADS    use THREADS threads (default: all cores)\n");
+	printf("  -h            display this help and exit\n");
+	printf("\nWithout a limit, every position is searched for 30"
+	       " seconds.\n");
+
+	exit(status);
+}
+
+static unsigned long long
+parse_number(const char *arg, unsigned long long max, const char *what)
+{
+	char *endptr;
+	unsigned long long value;
+
+	errno = 0;
+	value = strtoull(arg, &endptr, 10);
+	if (errno || endptr == arg || *endptr || value < 1 || value > max)
+		error(EXIT_FAILURE, 0, "invalid %s '%s'", what, arg);
+
+	return value;
+}
+
+/* Look up the numeric operand of OPCODE in the EPD string LINE.
+ * Returns non-zero if it is present.
+ */
+static int
+epd_operand(const char *line, const char *opcode, unsigned long long *value)
+{
+	size_t length = strlen(opcode);
+	const char *ptr = line;
+	char *endptr;
+
+	while ((ptr = strstr(ptr, opcode)) != NULL) {
+		if ((ptr == line || ptr[-1] == ' ' || ptr[-1] == '\t'
+		     || ptr[-1] == ';')
+		    && (ptr[length] == ' ' || ptr[length] == '\t')) {
+			*value = strtoull(ptr + length, &endptr, 10);
+			if (endptr != ptr + length
+			    && (!*endptr || *endptr == ';' || *endptr == ' '
+			        || *endptr == '\t'))
+				return 1;
+		}
+		ptr += length;
+	}
+
+	return 0;
+}
+
+/* Set POS from a FEN string, or from an EPD string without bm and am
+ * that chi_parse_epd() does not accept.
+ */
+static int
+parse_position(chi_pos *pos, const char *line)
+{
+	const char *endptr;
+	const char *ptr = line;
+	char *fen;
+	int errnum, i;
+
+	if (chi_extract_position(pos, line, &endptr) == 0)
+		return 0;
+
+	/* Cut off the operations after the four fields of the position.  */
+	for (i = 0; i < 4; ++i) {
+		ptr += strspn(ptr, " \t");
+		ptr += strcspn(ptr, " \t");
+	}
+	fen = xstrndup(line, ptr - line);
+	errnum = chi_set_position(pos, fen);
+	free(fen);
+
+	return errnum;
+}
+
+static void
+write_string(FILE *out, const char *str)
+{
+	fputc('"', out);
+	for (; *str; ++str) {
+		if (*str == '"' || *str == '\\')
+			fprintf(out, "\\%c", *str);
+		else if ((unsigned char) *str < 0x20)
+			fprintf(out, "\\u%04x", (unsigned char) *str);
+		else
+			fputc(*str, out);
+	}
+	fputc('"', out);
+}
+
+static void
+write_move(FILE *out, chi_move move, chi_color_t on_move)
+{
+	char *buf = NULL;
+	unsigned int bufsize;
+
+	chi_coordinate_notation(move, on_move, &buf, &bufsize);
+	fprintf(out, "\"%s\"", buf);
+	free(buf);
+}
+
+static int
+same_move(chi_move a, chi_move b)
+{
+	return chi_move_from(a) == chi_move_from(b)
+		&& chi_move_to(a) == chi_move_to(b)
+		&& chi_move_promote(a) == chi_move_promote(b);
+}
+
+/* Find the first iteration from which on the best move was the solution
+ * of EPD in every iteration.  Returns its depth or 0, and its time in
+ * TIME.
+ */
+static int
+solve_depth(const Tree *tree, const chi_epd_pos *epd, long long int *time)
+{
+	const SearchStats *stats = &tree->stats;
+	long long int elapsed = 0;
+	int depth, solved = 0;
+
+	for (depth = 1; depth <= stats->iterations; ++depth) {
+		chi_move move = stats->iteration_moves[depth];
+
+		elapsed += stats->iteration_time[depth];
+		if (same_move(move, epd->solution) == !epd->avoid) {
+			if (!solved) {
+				solved = depth;
+				*time = elapsed;
+			}
+		} else {
+			solved = 0;
+		}
+	}
+
+	return solved;
+}
+
+static void
+write_result(FILE *out, const Tree *tree, const chi_epd_pos *epd)
+{
+	const Line *pv = &tree->multipv_lines[0];
+	chi_color_t on_move = chi_on_move(&epd->pos);
+	long long int time = 0;
+	unsigned int i;
+	int depth;
+
+	if (tree->bestmove) {
+		fputs(",\"bestmove\":", out);
+		write_move(out, tree->bestmove, on_move);
+	} else {
+		fputs(",\"bestmove\":null", out);
+	}
+	fprintf(out, ",\"score\":%d,\"depth\":%d,\"seldepth\":%d"
+	        ",\"nodes\":%llu,\"time\":%lld,\"pv\":[",
+	        tree->multipv_scores[0], tree->stats.iterations,
+	        tree->stats.seldepth, tree->nodes + tree->stats.qnodes,
+	        tc_elapsed(tree));
+	for (i = 0; i < pv->num_moves; ++i) {
+		if (i)
+			fputc(',', out);
+		write_move(out, pv->moves[i], on_move);
+		on_move = !on_move;
+	}
+	fputc(']', out);
+
+	if (!epd->solution)
+		return;
+
+	fputs(epd->avoid ? ",\"am\":" : ",\"bm\":", out);
+	write_move(out, epd->solution, chi_on_move(&epd->pos));
+	if (tree->bestmove
+	    && same_move(tree->bestmove, epd->solution) == !epd->avoid) {
+		depth = solve_depth(tree, epd, &time);
+		if (!depth)
+			time = tc_elapsed(tree);
+		fprintf(out, ",\"solved\":true,\"solve_depth\":%d"
+		        ",\"solve_time\":%lld", depth, time);
+	} else {
+		fputs(",\"solved\":false", out);
+	}
+}
+
+static void
+analyze_line(Analysis *analysis, Tree *tree, char *line,
+             unsigned long index)
+{
+	FILE *out = analysis->out;
+	SearchParams params;
+	chi_epd_pos epd;
+	unsigned long long value;
+	const char *message = NULL;
+	int errnum;
+
+	line[strcspn(line, "\r\n")] = '\0';
+	line += strspn(line, " \t");
+	if (!*line || *line == '#')
+		return;
+
+	errnum = chi_parse_epd(&epd, line);
+	if (errnum) {
+		memset(&epd, 0, sizeof epd);
+		if (parse_position(&epd.pos, line) != 0)
+			message = chi_strerror(errnum);
+	}
+
+	memset(&params, 0, sizeof params);
+	params.depth = analysis->limits->depth;
+	params.nodes = analysis->limits->nodes;
+	params.movetime = analysis->limits->movetime;
+	if (epd_operand(line, "acd", &value) && value)
+		params.depth = value;
+	if (epd_operand(line, "acn", &value) && value)
+		params.nodes = value;
+	if (epd_operand(line, "acs", &value) && value) {
+		epd.fixed_time = 100 * value;
+		params.movetime = 10 * epd.fixed_time;
+	}
+
+	if (!message) {
+		memset(tree, 0, sizeof *tree);
+		process_search_params(tree, &params);
+		tt_clear();
+		if (search_position(tree, &epd.pos) != 0)
+			message = "game over";
+	}
+
+	flockfile(out);
+	fprintf(out, "{\"index\":%lu", index);
+	if (epd.id) {
+		fputs(",\"id\":", out);
+		write_string(out, epd.id);
+	}
+	if (message) {
+		fputs(",\"error\":", out);
+		write_string(out, message);
+	} else {
+		write_result(out, tree, &epd);
+	}
+	fputs("}\n", out);
+	fflush(out);
+	funlockfile(out);
+
+	chi_free_epd(&epd);
+}
+
+static void *
+worker_main(void *closure)
+{
+	Analysis *analysis = closure;
+	Tree *tree = xmalloc(sizeof *tree);
+	char *line = NULL;
+	size_t size = 0;
+	ssize_t length;
+	unsigned long index;
+
+	lisco_thread_init();
+
+	for (;;) {
+		pthread_mutex_lock(&analysis->mutex);
+		length = getline(&line, &size, analysis->in);
+		index = ++analysis->lines;
+		pthread_mutex_unlock(&analysis->mutex);
+
+		if (length < 0)
+			break;
+
+		analyze_line(analysis, tree, line, index);
+	}
+
+	lisco_thread_done();
+	free(line);
+	free(tree);
+
+	return NULL;
+}
+
+int
+analyze(FILE *in, FILE *out, const SearchParams *limits, int threads)
+{
+	Analysis analysis;
+	pthread_t *workers;
+	int i, errnum;
+
+	memset(&analysis, 0, sizeof analysis);
+	analysis.in = in;
+	analysis.out = out;
+	analysis.limits = limits;
+	pthread_mutex_init(&analysis.mutex, NULL);
+
+	workers = xmalloc(threads * sizeof *workers);
+	for (i = 0; i < threads; ++i) {
+		errnum = pthread_create(workers + i, NULL, worker_main,
+		                        &analysis);
+		if (errnum)
+			error(EXIT_FAILURE, errnum, "cannot create thread");
+	}
+	for (i = 0; i < threads; ++i)
+		pthread_join(workers[i], NULL);
+	free(workers);
+
+	pthread_mutex_destroy(&analysis.mutex);
+
+	return ferror(in) ? -1 : 0;
+}
+
+int
+analyze_main(int argc, char *argv[])
+{
+	SearchParams limits;
+	const char *filename = "-";
+	long threads = sysconf(_SC_NPROCESSORS_ONLN);
+	FILE *in;
+	int opt;
+
+	memset(&limits, 0, sizeof limits);
+
+	while ((opt = getopt(argc, argv, "d:n:t:H:j:h")) != -1) {
+		switch (opt) {
+			case 'd':
+				limits.depth = parse_number(optarg, MAX_PLY,
+				                            "depth");
+				break;
+			case 'n':
+				limits.nodes = parse_number(optarg, ~0ULL,
+				                            "number of nodes");
+				break;
+			case 't':
+				limits.movetime = parse_number(optarg, ~0UL,
+				                               "time");
+				break;
+			case 'H':
+				lisco.uci.hash_size = parse_number(
+					optarg, LISCO_MAX_HASH_SIZE, "hash size");
+				break;
+			case 'j':
+				threads = parse_number(optarg, 1024,
+				                       "number of threads");
+				break;
+			case 'h':
+				usage(EXIT_SUCCESS);
+				break;
+			default:
+				usage(EXIT_FAILURE);
+		}
+	}
+	if (threads < 1)
+		threads = 1;
+
+	if (optind < argc)
+		filename = argv[optind++];
+	if (optind < argc)
+		usage(EXIT_FAILURE);
+
+	if (strcmp(filename, "-") == 0) {
+		in = stdin;
+	} else {
+		in = fopen(filename, "r");
+		if (!in)
+			error(EXIT_FAILURE, errno, "%s", filename);
+	}
+
+	/* The main thread only waits for the workers.  They clear their
+	 * transposition table for every position, and that should not
+	 * start more threads.
+	 */
+	lisco_thread_done();
+	lisco.uci.option_threads = 1;
+
+	if (analyze(in, stdout, &limits, threads) != 0)
+		error(EXIT_FAILURE, 0, "%s: read error", filename);
+	if (in != stdin)
+		fclose(in);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,286 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Recognizers for endings with known results.
+ *
+ * The endings are looked up by a material key that holds the number of
+ * pieces of each type and color.  A recognizer either knows the exact
+ * result, and the search does not have to look any further, or it
+ * returns a score that makes the search drive towards the known win.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+
+#include <libchi.h>
+
+#include "lisco.h"
+
+typedef struct Endgame {
+	/* The pieces of the strong side first, for example "KBNK".  */
+	const char *code;
+	EndgameFunction function;
+	int result;
+} Endgame;
+
+typedef struct EndgameKey {
+	bitv64 material_key;
+	chi_color_t strong;
+	const Endgame *endgame;
+} EndgameKey;
+
+static int endgame_kpk(const chi_pos *pos, chi_color_t strong);
+static int endgame_kbnk(const chi_pos *pos, chi_color_t strong);
+static int endgame_draw(const chi_pos *pos, chi_color_t strong);
+static int endgame_kxk(const chi_pos *pos, chi_color_t strong);
+
+static const Endgame endgames[] = {
+	{ "KPK", endgame_kpk, ENDGAME_EXACT },
+	{ "KBNK", endgame_kbnk, ENDGAME_SCALED },
+	{ "KNNK", endgame_draw, ENDGAME_EXACT },
+};
+
+#define NUM_ENDGAMES (sizeof endgames / sizeof endgames[0])
+
+static EndgameKey endgame_keys[2 * NUM_ENDGAMES];
+
+static const Endgame endgame_generic_kxk = {
+	"KXK", endgame_kxk, ENDGAME_SCALED
+};
+
+/* Material key for CODE with the first side having color STRONG.  */
+static bitv64
+code_material_key(const char *code, chi_color_t strong)
+{
+	chi_color_t color = !strong;
+	bitv64 key = 0;
+
+	for (; *code; ++code) {
+		switch (*code) {
+			case 'K':
+				color = !color;
+				break;
+			case 'P':
+				key += (bitv64) 1 << CHI_MATERIAL_SHIFT(color, pawn);
+				break;
+			case 'N':
+				key += (bitv64) 1 << CHI_MATERIAL_SHIFT(color, knight);
+				break;
+			case 'B':
+				key += (bitv64) 1 << CHI_MATERIAL_SHIFT(color, bishop);
+				break;
+			case 'R':
+				key += (bitv64) 1 << CHI_MATERIAL_SHIFT(color, rook);
+				break;
+			case 'Q':
+				key += (bitv64) 1 << CHI_MATERIAL_SHIFT(color, queen);
+				break;
+		}
+	}
+
+	return key;
+}
+
+void
+init_endgames(void)
+{
+	size_t i;
+
+	for (i = 0; i < NUM_ENDGAMES; ++i) {
+		endgame_keys[2 * i].material_key =
+			code_material_key(endgames[i].code, chi_white);
+		endgame_keys[2 * i].strong = chi_white;
+		endgame_keys[2 * i].endgame = endgames + i;
+		endgame_keys[2 * i + 1].material_key =
+			code_material_key(endgames[i].code, chi_black);
+		endgame_keys[2 * i + 1].strong = chi_black;
+		endgame_keys[2 * i + 1].endgame = endgames + i;
+	}
+}
+
+EndgameFunction
+find_endgame(bitv64 key, chi_color_t *strong, int *result)
+{
+	const Endgame *endgame = NULL;
+	chi_color_t color;
+	size_t i;
+
+	for (i = 0; i < 2 * NUM_ENDGAMES; ++i) {
+		if (endgame_keys[i].material_key == key) {
+			endgame = endgame_keys[i].endgame;
+			*strong = endgame_keys[i].strong;
+			break;
+		}
+	}
+
+	/* A lone king against enough material to mate.  */
+	for (color = chi_white; !endgame && color <= chi_black; ++color) {
+		bitv64 weak_mask = (((bitv64) 1 << 20) - 1)
+			<< CHI_MATERIAL_SHIFT(!color, pawn);
+
+		if (!(key & weak_mask)
+		    && (CHI_MATERIAL_COUNT(key, color, rook)
+		        || CHI_MATERIAL_COUNT(key, color, queen)
+		        || CHI_MATERIAL_COUNT(key, color, bishop) >= 2)) {
+			endgame = &endgame_generic_kxk;
+			*strong = color;
+		}
+	}
+
+	if (!endgame)
+		return NULL;
+
+	*result = endgame->result;
+
+	return endgame->function;
+}
+
+int
+evaluate_endgame(const MaterialEntry *material, const chi_pos *pos,
+                 int *score)
+{
+	if (!material->endgame)
+		return ENDGAME_UNKNOWN;
+
+	*score = material->endgame(pos, material->strong);
+	if (chi_on_move(pos) != material->strong)
+		*score = -*score;
+
+	return material->endgame_result;
+}
+
+int
+recognize_endgame(const chi_pos *pos, int *score)
+{
+	return evaluate_endgame(material_probe(pos), pos, score);
+}
+
+static int
+distance(int from, int to)
+{
+	int ranks = abs((from >> 3) - (to >> 3));
+	int files = abs((from & 0x7) - (to & 0x7));
+
+	return ranks > files ? ranks : files;
+}
+
+/* Distance of SQUARE to the nearest edge of the board.  */
+static int
+edge_distance(int square)
+{
+	int rank = square >> 3;
+	int file = square & 0x7;
+	int rank_distance = rank < 4 ? rank : 7 - rank;
+	int file_distance = file < 4 ? file : 7 - file;
+
+	return rank_distance < file_distance ? rank_distance : file_distance;
+}
+
+static int
+endgame_draw(const chi_pos *pos, chi_color_t strong)
+{
+	return 0;
+}
+
+static int
+endgame_kpk(const chi_pos *pos, chi_color_t strong)
+{
+	int pawn_square;
+
+	if (!chi_kpk_probe(pos))
+		return 0;
+
+	/* Prefer wins that advance the pawn.  */
+	if (strong == chi_white) {
+		pawn_square = chi_bitv2shift(pos->w_pawns);
+		return KNOWN_WIN + 10 * (pawn_square >> 3);
+	} else {
+		pawn_square = chi_bitv2shift(pos->b_pawns);
+		return KNOWN_WIN + 10 * (7 - (pawn_square >> 3));
+	}
+}
+
+static int
+side_material(bitv64 pawns, bitv64 knights, bitv64 bishops, bitv64 rooks)
+{
+	return 100 * chi_popcount(pawns)
+		+ 300 * chi_popcount(knights)
+		+ 300 * chi_popcount(bishops & ~rooks)
+		+ 500 * chi_popcount(rooks & ~bishops)
+		+ 900 * chi_popcount(bishops & rooks);
+}
+
+/* Drive the lone king to the edge and bring the strong king close.  */
+static int
+endgame_kxk(const chi_pos *pos, chi_color_t strong)
+{
+	int strong_king, weak_king, material;
+
+	if (strong == chi_white) {
+		strong_king = chi_bitv2shift(pos->w_kings);
+		weak_king = chi_bitv2shift(pos->b_kings);
+		material = side_material(pos->w_pawns, pos->w_knights,
+		                         pos->w_bishops, pos->w_rooks);
+	} else {
+		strong_king = chi_bitv2shift(pos->b_kings);
+		weak_king = chi_bitv2shift(pos->w_kings);
+		material = side_material(pos->b_pawns, pos->b_knights,
+		                         pos->b_bishops, pos->b_rooks);
+	}
+
+	return KNOWN_WIN + material + 20 * (3 - edge_distance(weak_king))
+		+ 10 * (7 - distance(strong_king, weak_king));
+}
+
+/* The lone king has to be driven into a corner of the color of the
+ * bishop.
+ */
+static int
+endgame_kbnk(const chi_pos *pos, chi_color_t strong)
+{
+	int strong_king, weak_king, bishop, corner_distance;
+
+	if (strong == chi_white) {
+		strong_king = chi_bitv2shift(pos->w_kings);
+		weak_king = chi_bitv2shift(pos->b_kings);
+		bishop = chi_bitv2shift(pos->w_bishops);
+	} else {
+		strong_king = chi_bitv2shift(pos->b_kings);
+		weak_king = chi_bitv2shift(pos->w_kings);
+		bishop = chi_bitv2shift(pos->b_bishops);
+	}
+
+	/* Dark squares have an odd sum of rank and shift, the dark corners
+	 * are a1 and h8.
+	 */
+	if (((bishop >> 3) + (bishop & 0x7)) & 1) {
+		corner_distance = distance(weak_king, CHI_A1);
+		if (distance(weak_king, CHI_H8) < corner_distance)
+			corner_distance = distance(weak_king, CHI_H8);
+	} else {
+		corner_distance = distance(weak_king, CHI_H1);
+		if (distance(weak_king, CHI_A8) < corner_distance)
+			corner_distance = distance(weak_king, CHI_A8);
+	}
+
+	return KNOWN_WIN + 20 * (7 - corner_distance)
+		+ 10 * (7 - distance(strong_king, weak_king));
+}
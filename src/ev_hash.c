@@ -21,12 +21,14 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <libchi.h>
 
 #include "xalloc.h"
 #include "lisco.h"
+#include "util.h"
 
 #define MIN_EV_SIZE (sizeof (EV_Entry) * 100000)
 
@@ -35,10 +37,12 @@ typedef struct ev_entry {
 	short int score;
 } EV_Entry;
 
-EV_Entry* ev = NULL;
+/* Every searching thread has its own cache.  */
+static __thread EV_Entry* ev = NULL;
+static __thread size_t ev_mapped = 0;
 
-static unsigned long int ev_size = 0;
-static unsigned long int half_ev_size = 0;
+static __thread unsigned long int ev_size = 0;
+static __thread unsigned long int half_ev_size = 0;
 
 void
 init_ev_hash(size_t memuse)
@@ -49,19 +53,40 @@ init_ev_hash(size_t memuse)
     half_ev_size = chi_closest_prime ((memuse / sizeof *ev) / 2);
 
     ev_size = half_ev_size << 1;
-    ev = xrealloc (ev, ev_size * sizeof *ev);
-    fprintf (stdout, 
-	     "\
-Allocated %lu bytes (%lu entries) for evaluation cache.\n",
-	     ev_size * sizeof *ev, ev_size);
-
-    clear_ev_hash();
+    free_huge(ev, ev_mapped);
+    ev = xmalloc_huge(ev_size * sizeof *ev, &ev_mapped);
 }
 
 void
 clear_ev_hash(void)
 {
-	memset (ev, 0, ev_size * sizeof *ev);
+	clear_memory (ev, ev_size * sizeof *ev, lisco.uci.option_threads);
+}
+
+void
+free_ev_hash(void)
+{
+	free_huge(ev, ev_mapped);
+	ev = NULL;
+	ev_mapped = 0;
+	ev_size = half_ev_size = 0;
+}
+
+int
+ev_hashfull(void)
+{
+	unsigned long int i, sample = ev_size < 1000 ? ev_size : 1000;
+	int used = 0;
+
+	/* Sample both halves.  */
+	for (i = 0; i < sample / 2; ++i) {
+		if (ev[i].signature)
+			++used;
+		if (ev[half_ev_size + i].signature)
+			++used;
+	}
+
+	return sample ? used * 1000 / (sample / 2 * 2) : 0;
 }
 
 int
@@ -25,6 +25,8 @@
 #include <libchi.h>
 
 #include "lisco.h"
+#include "profile.h"
+#include "bitmasks.h"
 #include "magicmoves.h"
 
 #ifdef abs
@@ -40,37 +42,34 @@
 #define EVAL_NOT_CASTLED (24)
 #define EVAL_LOST_CASTLE (10)
 
-#define DRAW 20
-#define MAX_POS_SCORE 99999
-
-#include <libchi/bitmasks.c>
-
-static int evaluate_dev_white(Tree *tree, int ply);
-static int evaluate_dev_black(Tree *tree, int ply);
-static int evaluate_mobility(Tree *tree);
+#define EVAL_ISOLATED_PAWN_MG (10)
+#define EVAL_ISOLATED_PAWN_EG (15)
+#define EVAL_DOUBLED_PAWN_MG (10)
+#define EVAL_DOUBLED_PAWN_EG (20)
+#define EVAL_BACKWARD_PAWN_MG (8)
+#define EVAL_BACKWARD_PAWN_EG (12)
 
-#if defined(__GNUC__)  // GCC, Clang, ICC
-# define popcount(b) __builtin_popcount(b)
-#else
-# define M1 ((bitv64) 0x5555555555555555)
-# define M2 ((bitv64) 0x3333333333333333)
+/* Blend a middle game and an end game score according to the game
+ * phase.
+ */
+#define taper(mg, eg, phase) \
+	((eg) + ((mg) - (eg)) * (phase) / CHI_PHASE_MAX)
 
-static unsigned int
-popcount(bitv64 b)
-{
-	unsigned int n;
+/* The same with the end game score scaled down for drawish material.  */
+#define blend(mg, eg, material) \
+	taper(mg, (eg) * (material)->scale[(eg) < 0] / MATERIAL_SCALE_NORMAL, \
+	      (material)->phase)
 
-	bitv64 a = b - ((b >> 1) & M1);
-	bitv64 c = (a & M2) + ((a >> 2) & M2);
+/* Margins for the lazy evaluation.  Each is an estimate of how much the
+ * terms that have not been evaluated yet can change the score.
+ */
+#define LAZY_MARGIN_PSQ (400)
+#define LAZY_MARGIN_PAWNS (200)
+#define LAZY_MARGIN_KING (100)
 
-	n = ((unsigned int) c) + ((unsigned int) (c >> 32));
-	n = (n & 0x0f0f0f0f) + ((n >> 4) & 0x0f0f0f0f);
-	n = (n & 0xffff) + (n >> 16);
-	n = (n & 0xff) + (n >> 8);
+#define DRAW 20
 
-	return n;    
-}
-#endif
+static const PawnEntry *evaluate_pawns(Tree *tree, int ply);
 
 #if 0
 /* FIXME! What was that for? */
@@ -86,71 +85,154 @@ static const int square_values[64] = {
 };
 #endif
 
-static const int white_outposts[64] = {
-	0,  0,  0,  0,  0,  0,  0,  0,
-	0,  0,  0,  0,  0,  0,  0,  0,
-	0,  0,  0,  0,  0,  0,  0,  0,
-	0,  0,  0,  4,  4,  0,  0,  0,
-	0,  0,  8, 10, 10,  8,  0,  0,
-	0,  0,  8, 12, 12,  8,  0,  0,
-	0,  0,  4,  8,  8,  4,  0,  0,
-	0,  0,  0,  0,  0,  0,  0,  0,
-};
-
-static const int black_outposts[64] = {
-	0,  0,  0,  0,  0,  0,  0,  0,
-	0,  0,  4,  8,  8,  4,  0,  0,
-	0,  0,  8, 12, 12,  8,  0,  0,
-	0,  0,  8, 10, 10,  8,  0,  0,
-	0,  0,  0,  4,  4,  0,  0,  0,
-	0,  0,  0,  0,  0,  0,  0,  0,
-	0,  0,  0,  0,  0,  0,  0,  0,
-	0,  0,  0,  0,  0,  0,  0,  0,
+/* Bonus for passed pawns by rank, seen from the side of the pawn.  */
+static const int passed_pawn_bonus[8] = {
+	0, 0, 12, 24, 48, 100, 200, 0
 };
 
-static const int white_pawn_advances[64] = {
-	  0,   0,   0,   0,   0,   0,   0,   0,
-	  0,   0,   0,   0,   0,   0,   0,   0,
-	 12,  12,  12,  12,  12,  12,  12,  12,
-	 24,  24,  24,  24,  24,  24,  24,  24,
-	 48,  48,  48,  48,  48,  48,  48,  48,
-	100, 100, 100, 100, 100, 100, 100, 100,
-	200, 200, 200, 200, 200, 200, 200, 200,
-	  0,   0,   0,   0,   0,   0,   0,   0,
-};
-
-static const int black_pawn_advances[64] = {
-	  0,   0,   0,   0,   0,   0,   0,   0,
-	200, 200, 200, 200, 200, 200, 200, 200,
-	100, 100, 100, 100, 100, 100, 100, 100,
-	 48,  48,  48,  48,  48,  48,  48,  48,
-	 24,  24,  24,  24,  24,  24,  24,  24,
-	 12,  12,  12,  12,  12,  12,  12,  12,
-	  0,   0,   0,   0,   0,   0,   0,   0,
-	  0,   0,   0,   0,   0,   0,   0,   0,
-};
+/* Check whether the evaluation can stop after stage STAGE.  SCORE is the
+ * score so far from white's point of view, and MARGIN is the maximum
+ * the remaining terms can change it.  If the score cannot get back into
+ * the window ALPHA, BETA, store it from the point of view of the side on
+ * move in RESULT, store MARGIN in the tree, and return non-zero.  Such
+ * a score is only a bound and must not go into the evaluation cache.
+ */
+static int
+lazy_exit(Tree *tree, int stage, int score, int alpha, int beta,
+          int margin, int *result)
+{
+	if (chi_on_move(&tree->position) != chi_white)
+		score = -score;
+
+	if (score + margin <= alpha || score - margin >= beta) {
+		++tree->stats.lazy_exits[stage];
+		tree->lazy_margin = margin;
+		*result = score;
+		return 1;
+	}
 
-int white_king_heat[64] = { 
-	1, 0, 2, 3, 3, 2, 0, 1,
-	1, 1, 2, 3, 3, 2, 1, 1,
-	3, 3, 3, 3, 3, 3, 3, 3,
-	4, 4, 4, 4, 4, 4, 4, 4,
-	5, 5, 5, 5, 5, 5, 5, 5,
-	6, 6, 6, 6, 6, 6, 6, 6,
-	7, 7, 7, 7, 7, 7, 7, 7,
-	8, 8, 8, 8, 8, 8, 8, 8,
-};
+	return 0;
+}
 
-int black_king_heat[64] = {
-	8, 8, 8, 8, 8, 8, 8, 8,
-	7, 7, 7, 7, 7, 7, 7, 7,
-	6, 6, 6, 6, 6, 6, 6, 6,
-	5, 5, 5, 5, 5, 5, 5, 5,
-	4, 4, 4, 4, 4, 4, 4, 4,
-	3, 3, 3, 3, 3, 3, 3, 3,
-	1, 1, 2, 3, 3, 2, 1, 1,
-	1, 0, 2, 3, 3, 2, 0, 1,
-};
+#define MY_COLOR chi_white
+#define MY_PIECES(p) ((p)->w_pieces)
+#define HER_PIECES(p) ((p)->b_pieces)
+#define MY_PAWNS(p) ((p)->w_pawns)
+#define HER_PAWNS(p) ((p)->b_pawns)
+#define MY_KNIGHTS(p) ((p)->w_knights)
+#define MY_BISHOPS(p) ((p)->w_bishops)
+#define MY_ROOKS(p) ((p)->w_rooks)
+#define MY_KINGS(p) ((p)->w_kings)
+#define HER_PAWN_ATTACKS(b) \
+	((((b) & ~CHI_A_MASK) >> 7) | (((b) & ~CHI_H_MASK) >> 9))
+#define MY_PAWN_ATTACKS(b) \
+	((((b) & ~CHI_A_MASK) << 9) | (((b) & ~CHI_H_MASK) << 7))
+#define FORWARD(b) ((b) << 8)
+#define AHEAD(rank) (~((((bitv64) 1) << (((rank) + 1) << 3)) - 1))
+#define RELATIVE_RANK(rank) (rank)
+#define FIRST_RANK CHI_1_MASK
+#define SECOND_RANK CHI_2_MASK
+#define THIRD_RANK CHI_3_MASK
+#define FOURTH_RANK CHI_4_MASK
+#define KING_CASTLE(p) chi_wk_castle(p)
+#define QUEEN_CASTLE(p) chi_wq_castle(p)
+#define LOST_KING_CASTLE(p) ((p)->lost_wk_castle)
+#define LOST_QUEEN_CASTLE(p) ((p)->lost_wq_castle)
+#define CASTLED(p) chi_w_castled(p)
+#define evaluate_color_dev evaluate_white_dev
+#define evaluate_color_king evaluate_white_king
+#define evaluate_color_pawns evaluate_white_pawns
+#define evaluate_color_mobility evaluate_white_mobility
+
+#include "evaluate_color.c"
+
+#undef MY_COLOR
+#undef MY_PIECES
+#undef HER_PIECES
+#undef MY_PAWNS
+#undef HER_PAWNS
+#undef MY_KNIGHTS
+#undef MY_BISHOPS
+#undef MY_ROOKS
+#undef MY_KINGS
+#undef HER_PAWN_ATTACKS
+#undef MY_PAWN_ATTACKS
+#undef FORWARD
+#undef AHEAD
+#undef RELATIVE_RANK
+#undef FIRST_RANK
+#undef SECOND_RANK
+#undef THIRD_RANK
+#undef FOURTH_RANK
+#undef KING_CASTLE
+#undef QUEEN_CASTLE
+#undef LOST_KING_CASTLE
+#undef LOST_QUEEN_CASTLE
+#undef CASTLED
+#undef evaluate_color_dev
+#undef evaluate_color_king
+#undef evaluate_color_pawns
+#undef evaluate_color_mobility
+
+#define MY_COLOR chi_black
+#define MY_PIECES(p) ((p)->b_pieces)
+#define HER_PIECES(p) ((p)->w_pieces)
+#define MY_PAWNS(p) ((p)->b_pawns)
+#define HER_PAWNS(p) ((p)->w_pawns)
+#define MY_KNIGHTS(p) ((p)->b_knights)
+#define MY_BISHOPS(p) ((p)->b_bishops)
+#define MY_ROOKS(p) ((p)->b_rooks)
+#define MY_KINGS(p) ((p)->b_kings)
+#define HER_PAWN_ATTACKS(b) \
+	((((b) & ~CHI_A_MASK) << 9) | (((b) & ~CHI_H_MASK) << 7))
+#define MY_PAWN_ATTACKS(b) \
+	((((b) & ~CHI_A_MASK) >> 7) | (((b) & ~CHI_H_MASK) >> 9))
+#define FORWARD(b) ((b) >> 8)
+#define AHEAD(rank) ((((bitv64) 1) << ((rank) << 3)) - 1)
+#define RELATIVE_RANK(rank) (7 - (rank))
+#define FIRST_RANK CHI_8_MASK
+#define SECOND_RANK CHI_7_MASK
+#define THIRD_RANK CHI_6_MASK
+#define FOURTH_RANK CHI_5_MASK
+#define KING_CASTLE(p) chi_bk_castle(p)
+#define QUEEN_CASTLE(p) chi_bq_castle(p)
+#define LOST_KING_CASTLE(p) ((p)->lost_bk_castle)
+#define LOST_QUEEN_CASTLE(p) ((p)->lost_bq_castle)
+#define CASTLED(p) chi_b_castled(p)
+#define evaluate_color_dev evaluate_black_dev
+#define evaluate_color_king evaluate_black_king
+#define evaluate_color_pawns evaluate_black_pawns
+#define evaluate_color_mobility evaluate_black_mobility
+
+#include "evaluate_color.c"
+
+#undef MY_COLOR
+#undef MY_PIECES
+#undef HER_PIECES
+#undef MY_PAWNS
+#undef HER_PAWNS
+#undef MY_KNIGHTS
+#undef MY_BISHOPS
+#undef MY_ROOKS
+#undef MY_KINGS
+#undef HER_PAWN_ATTACKS
+#undef MY_PAWN_ATTACKS
+#undef FORWARD
+#undef AHEAD
+#undef RELATIVE_RANK
+#undef FIRST_RANK
+#undef SECOND_RANK
+#undef THIRD_RANK
+#undef FOURTH_RANK
+#undef KING_CASTLE
+#undef QUEEN_CASTLE
+#undef LOST_KING_CASTLE
+#undef LOST_QUEEN_CASTLE
+#undef CASTLED
+#undef evaluate_color_dev
+#undef evaluate_color_king
+#undef evaluate_color_pawns
+#undef evaluate_color_mobility
 
 int
 evaluate(Tree *tree, int ply, int alpha, int beta)
@@ -158,13 +240,19 @@ evaluate(Tree *tree, int ply, int alpha, int beta)
 	chi_pos* pos = &tree->position;
 	bitv64 signature = tree->signatures[ply];
 	int score;
-	int total_white_pieces, total_black_pieces;
+	int mg, eg, mobility;
+	const MaterialEntry *material;
+	const PawnEntry *pawns;
 
-	++tree->evals;
+	++tree->stats.evals;
+	tree->lazy_margin = 0;
 
 	/* Check for a cache hit first.  */
-	if (probe_ev(pos, signature, &score)) {
-		++tree->ev_hits;
+	PROFILE_BEGIN(PROFILE_PROBE_EV);
+	int cached = probe_ev(pos, signature, &score);
+	PROFILE_END(PROFILE_PROBE_EV);
+	if (cached) {
+		++tree->stats.ev_hits;
 		return score;
 	}
 
@@ -172,7 +260,9 @@ evaluate(Tree *tree, int ply, int alpha, int beta)
 		chi_move moves[CHI_MAX_MOVES];
 		chi_move* mv = moves;
 
+		PROFILE_BEGIN(PROFILE_LEGAL_MOVES);
 		mv = chi_legal_moves (pos, moves);
+		PROFILE_END(PROFILE_LEGAL_MOVES);
 		if (mv - moves == 0) {
 			store_ev_entry (pos, signature, MATE - ply);
 			return MATE - ply;
@@ -186,373 +276,90 @@ evaluate(Tree *tree, int ply, int alpha, int beta)
 		return DRAW;
 	}
 
-	total_white_pieces = popcount(pos->w_pieces);
-	total_black_pieces = popcount(pos->b_pieces);
-
-	if (!pos->w_pawns && !pos->b_pawns) {
-		/* Check for draw by lack of material.  */
-		if (!pos->w_rooks && !pos->b_rooks && 
-		    !pos->w_bishops && !pos->b_bishops) {
-			store_ev_entry (pos, signature, DRAW);
-			return DRAW;
-		} else if (!pos->w_rooks && !pos->b_rooks) {
-			/* Only bishops and knights left.  We report two knights
-			   as not sufficient.  */
-			int white_bishops = popcount(pos->w_bishops);
-			int black_bishops = popcount(pos->b_bishops);
-			int white_knights = popcount(pos->w_knights);
-			int black_knights = popcount(pos->b_knights);
-
-			if ((white_bishops < 2 && !white_knights)
-			    || (black_bishops < 2 && !black_knights))
-				store_ev_entry (pos, signature, DRAW);
-			return DRAW;
-		}
-    }
-
-	score = 100 * chi_material (pos);
-
-    if ((abs (score - alpha) > MAX_POS_SCORE)
-	    && (abs (score - beta) > MAX_POS_SCORE)) {
-		++tree->lazy_evals;
-		if (chi_on_move (pos) == chi_white)
-			return score;
-		else
-	    	return -score;
-    } else if (total_white_pieces > 10 && total_black_pieces > 10) {
-		if (!(pos->lost_wk_castle && pos->lost_bk_castle
-		      && pos->lost_wq_castle && pos->lost_bq_castle)) {
-			score += evaluate_dev_white(tree, ply);
-			score += evaluate_dev_black(tree, ply);
-		}
-	}
-
-	score += evaluate_mobility (tree);
-
-    if (total_black_pieces > 10
-	    || ((total_white_pieces + total_black_pieces) > 20)) {
-		int king_shift = 
-			chi_bitv2shift (chi_clear_but_least_set (pos->w_kings));
-		bitv64 king_wall;
-
-		for (king_wall = pos->w_pawns & ((bitv64) 0x7) << (king_shift + 7);
-		     king_wall;
-		     score += 2, king_wall &= king_wall - 1);
-		for (king_wall = pos->w_pieces & ((bitv64) 0x7) << (king_shift + 7);
-		     king_wall;
-		     score += 2, king_wall &= king_wall - 1);
-
-		score -= white_king_heat[king_shift];
+	/* Endings with a known result and draws by lack of material.  */
+	material = material_probe(pos);
+	if (evaluate_endgame(material, pos, &score) != ENDGAME_UNKNOWN) {
+		store_ev_entry (pos, signature, score);
+		return score;
 	}
-
-	if (total_white_pieces > 10
-	    || ((total_white_pieces + total_black_pieces) > 20)) {
-		int king_shift = 
-			chi_bitv2shift (chi_clear_but_least_set (pos->b_kings));
-		bitv64 king_wall;
-
-		for (king_wall = pos->b_pawns & ((bitv64) 0x7) << (king_shift - 9);
-			king_wall;
-			score -= 2, king_wall &= king_wall - 1);
-		for (king_wall = pos->b_pieces & ((bitv64) 0x7) << (king_shift - 9);
-			king_wall;
-			score -= 2, king_wall &= king_wall - 1);
-
-		score += black_king_heat[king_shift];
-    }
-
-    if (total_white_pieces + total_black_pieces <= 20) {
-		/* Preliminary pawn evaluation.  */
-		bitv64 piece_mask = pos->w_pawns;
-		while (piece_mask) {
-			int square = chi_bitv2shift (chi_clear_but_least_set (piece_mask));
-			int rank = square >> 3;
-			int file = square & 0x7;  /* Really file - 7.  */
-			bitv64 front = (((bitv64) 1) << ((rank + 1) << 3)) - 1;
-			bitv64 rear = (((bitv64) 1) << ((rank - 1) << 3)) - 1;
-			bitv64 ahead_mask = front & (CHI_H_MASK << file);
-			bitv64 rear_mask = rear & (CHI_H_MASK << file);
-			bitv64 left_mask = (bitv64) 0;
-			bitv64 right_mask = (bitv64) 0;
-			int pawn_score = white_pawn_advances[square];
-			bitv64 rel_mask;
-
-			if (file > 0) left_mask = CHI_H_MASK << (file + 1);
-			if (file < 7) right_mask = CHI_H_MASK << (file - 1);
-
-			/* Penalty for foes ahead.  */
-			for (rel_mask = ahead_mask & pos->b_pawns; 
-				rel_mask;
-				rel_mask = chi_clear_least_set (rel_mask), 
-				           pawn_score -= (pawn_score >> 1));
-			/* Penalty for foes left or right ahead.  */
-			for (rel_mask = ahead_mask & pos->b_pawns & (left_mask | right_mask);
-				rel_mask;
-				rel_mask = chi_clear_least_set (rel_mask),
-				           pawn_score -= (pawn_score >> 2));
-			/* Bonus for friends left and right behind.  */
-			for (rel_mask = rear_mask & pos->w_pawns & (left_mask | right_mask);
-				rel_mask;
-				rel_mask = chi_clear_least_set (rel_mask),
-				           pawn_score += (pawn_score >> 2));
-
-			/* Never give a penalty for bad pawns.  */
-			if (score > 0)
-				score += pawn_score;
-
-			piece_mask = chi_clear_least_set (piece_mask);
-		}
-
-		piece_mask = pos->b_pawns;
-		while (piece_mask) {
-			int square = chi_bitv2shift (chi_clear_but_least_set (piece_mask));
-			int rank = square >> 3;
-			int file = square & 0x7;  /* Really file - 7.  */
-			bitv64 rear = (((bitv64) 1) << ((rank + 1) << 3)) - 1;
-			bitv64 front = (((bitv64) 1) << ((rank - 1) << 3)) - 1;
-			bitv64 ahead_mask = front & (CHI_H_MASK << file);
-			bitv64 rear_mask = rear & (CHI_H_MASK << file);
-			bitv64 left_mask = (bitv64) 0;
-			bitv64 right_mask = (bitv64) 0;
-			int pawn_score = black_pawn_advances[square];
-			bitv64 rel_mask;
-
-			if (file > 0) left_mask = CHI_H_MASK << (file + 1);
-			if (file < 7) right_mask = CHI_H_MASK << (file - 1);
-
-			/* Penalty for foes ahead.  */
-			for (rel_mask = ahead_mask & pos->w_pawns; 
-				rel_mask;
-				rel_mask = chi_clear_least_set (rel_mask), 
-				           pawn_score -= (pawn_score >> 1));
-			/* Penalty for foes left or right ahead.  */
-			for (rel_mask = ahead_mask & pos->w_pawns & (left_mask | right_mask);
-				rel_mask;
-				rel_mask = chi_clear_least_set (rel_mask),
-				           pawn_score -= (pawn_score >> 2));
-			/* Bonus for friends left and right behind.  */
-			for (rel_mask = rear_mask & pos->b_pawns & (left_mask | right_mask);
-				rel_mask;
-				rel_mask = chi_clear_least_set (rel_mask),
-				           pawn_score += (pawn_score >> 2));
-
-			/* Never give a penalty for bad pawns.  */
-			if (score > 0) score -= pawn_score;
-
-			piece_mask = chi_clear_least_set (piece_mask);
-		}
+	if (material->draw) {
+		store_ev_entry (pos, signature, DRAW);
+		return DRAW;
 	}
 
-    if (chi_on_move (pos) != chi_white) score = -score;
-
-	store_ev_entry (pos, signature, score);
-
-	return score;
-}
-
-static int
-evaluate_dev_white(Tree *tree, int ply)
-{
-	int score = 0;
-	chi_pos* pos = &tree->position;
-	bitv64 w_pawns = pos->w_pawns;
-	bitv64 w_bishops = pos->w_bishops & ~pos->w_rooks;
-	bitv64 center_pawns = w_pawns & (CHI_D_MASK | CHI_E_MASK);
-	bitv64 w_queens = pos->w_bishops & pos->w_rooks;
-
-	// FIXME: We can precompute the relevant mask.
-	while (w_pawns) {
-		unsigned int from = 
-			chi_bitv2shift (chi_clear_but_least_set (w_pawns));
-		score += white_outposts[from] << 1;
-		w_pawns = chi_clear_least_set (w_pawns);
+	/* The network replaces all hand-written terms.  */
+	if (tree->nnue) {
+		score = nnue_evaluate(&tree->accumulators[ply], chi_on_move(pos));
+		store_ev_entry (pos, signature, score);
+		return score;
 	}
 
-	/* Penalty for premature queen moves.  */
-	if (!(w_queens & CHI_D_MASK & CHI_1_MASK)
-	    && (!(pos->lost_wk_castle && pos->lost_wq_castle)
-		    || (pos->w_knights & (CHI_B_MASK | CHI_G_MASK) & CHI_1_MASK)
-			|| (w_bishops & (CHI_C_MASK | CHI_F_MASK) & CHI_1_MASK)))
-		score -= EVAL_PREMATURE_QUEEN_MOVE;
-
-	/* Do not block c pawn in queen pawn openings.  */
-	if (!((w_pawns & CHI_D_MASK & CHI_4_MASK)
-		&& (w_pawns & CHI_E_MASK & CHI_4_MASK))) {
-		if ((w_pawns & CHI_C_MASK & CHI_2_MASK) &&
-			((w_bishops | pos->w_knights) & CHI_C_MASK & CHI_3_MASK))
-			score -= EVAL_BLOCKED_C_PAWN;
-		}
-
-		/* Penalty for blocked center pawns.  */
-		if ((center_pawns << 8) & (pos->w_pieces | pos->b_pieces))
-			score -= EVAL_BLOCKED_CENTER_PAWN;
-
-		if (!(pos->lost_wk_castle && pos->lost_wq_castle) && !chi_w_castled(pos)) {
-			/* Penalty for not having castled.  */
-			score -= EVAL_NOT_CASTLED;
-
-		if (!chi_wk_castle(pos)) score -= EVAL_LOST_CASTLE;
-
-		if (!chi_wq_castle(pos)) score -= EVAL_LOST_CASTLE;
-	}
+	/* Every term has a middle game and an end game value.  They are
+	 * blended according to the game phase only once at the end.
+	 */
+
+	/* Material and piece-square scores are updated incrementally, the
+	 * phase and the imbalance come from the material table.
+	 */
+	mg = chi_psq_mg(pos) + material->imbalance;
+	eg = chi_psq_eg(pos) + material->imbalance;
+	if (lazy_exit(tree, EVAL_STAGE_PSQ, blend(mg, eg, material),
+	              alpha, beta, LAZY_MARGIN_PSQ, &score))
+		return score;
 
-	return score;
-}
+	pawns = evaluate_pawns(tree, ply);
+	mg += pawns->score[0];
+	eg += pawns->score[1];
+	if (lazy_exit(tree, EVAL_STAGE_PAWNS, blend(mg, eg, material),
+	              alpha, beta, LAZY_MARGIN_PAWNS, &score))
+		return score;
 
-static int
-evaluate_dev_black(Tree *tree, int ply)
-{
-	int score = 0;
-	chi_pos* pos = &tree->position;
-	bitv64 b_pawns = pos->b_pawns;
-	bitv64 b_bishops = pos->b_bishops & ~pos->b_rooks;
-	bitv64 center_pawns = b_pawns & (CHI_D_MASK | CHI_E_MASK);
-	bitv64 b_queens = pos->b_bishops & pos->b_rooks;
-
-	while (b_pawns) {
-		unsigned int from = 
-			chi_bitv2shift (chi_clear_but_least_set (b_pawns));
-		score -= black_outposts[from] << 1;
-		b_pawns = chi_clear_least_set (b_pawns);
+	/* Development only matters in the middle game.  */
+	if (!(pos->lost_wk_castle && pos->lost_bk_castle
+	      && pos->lost_wq_castle && pos->lost_bq_castle)) {
+		mg += evaluate_white_dev(pos);
+		mg -= evaluate_black_dev(pos);
 	}
 
-	/* Penalty for premature queen moves.  */
-	if (!(b_queens & CHI_D_MASK & CHI_8_MASK)
-	    && (!chi_b_castled (pos)
-		    || (pos->b_knights & (CHI_B_MASK | CHI_G_MASK) & CHI_8_MASK)
-			|| (b_bishops & (CHI_C_MASK | CHI_F_MASK) & CHI_8_MASK)))
-		score += EVAL_PREMATURE_QUEEN_MOVE;
+	/* King safety, middle game only.  */
+	mg += evaluate_white_king(pos, pawns);
+	mg -= evaluate_black_king(pos, pawns);
 
-	/* Do not block c pawn in queen pawn openings.  */
-    if (!((b_pawns & CHI_D_MASK & CHI_5_MASK) &&
-	  (b_pawns & CHI_E_MASK & CHI_5_MASK))) {
-		if ((b_pawns & CHI_C_MASK & CHI_7_MASK)
-		    && ((b_bishops | pos->b_knights) & CHI_C_MASK & CHI_6_MASK))
-			score += EVAL_BLOCKED_C_PAWN;
-    	}
+	if (lazy_exit(tree, EVAL_STAGE_KING, blend(mg, eg, material),
+	              alpha, beta, LAZY_MARGIN_KING, &score))
+		return score;
 
-	/* Penalty for blocked center pawns.  */
-	if ((center_pawns >> 8) & (pos->w_pieces | pos->b_pieces))
-		score += EVAL_BLOCKED_CENTER_PAWN;
+	mobility = evaluate_white_mobility(pos) - evaluate_black_mobility(pos);
+	mg += mobility;
+	eg += mobility;
 
-	if (!(pos->lost_bk_castle && pos->lost_bq_castle) && !chi_b_castled(pos)) {
-		/* Penalty for not having castled.  */
-		score += EVAL_NOT_CASTLED;
+	score = blend(mg, eg, material);
 
-		if (!chi_bk_castle(pos)) score += EVAL_LOST_CASTLE;
+    if (chi_on_move (pos) != chi_white) score = -score;
 
-		if (!chi_bq_castle(pos)) score += EVAL_LOST_CASTLE;
-	}
+	store_ev_entry (pos, signature, score);
 
 	return score;
 }
 
-static int 
-evaluate_mobility(Tree *tree)
+/* Look up the pawn structure in the pawn hash and evaluate it on a miss.  */
+static const PawnEntry *
+evaluate_pawns(Tree *tree, int ply)
 {
-	chi_pos* pos = &tree->position;
-	int score = 0;
-	bitv64 occ_squares = pos->w_pieces | pos->b_pieces;
-	bitv64 empty_squares = ~occ_squares;
-	register bitv64 piece_mask;
-
-	/* Pawn mobility.  */
-	/* Double steps.  */
-	piece_mask = pos->w_pawns & CHI_2_MASK;
-	piece_mask <<= 8;
-	piece_mask &= empty_squares;
-	piece_mask <<= 8;
-	piece_mask &= empty_squares;
-	for (; piece_mask; ++score, piece_mask &= piece_mask - 1);
-
-	piece_mask = pos->b_pawns & CHI_7_MASK;
-	piece_mask >>= 8;
-	piece_mask &= empty_squares;
-	piece_mask >>= 8;
-	piece_mask &= empty_squares;
-	for (; piece_mask; --score, piece_mask &= piece_mask - 1);
-
-	/* Single steps.  */
-	piece_mask = (pos->w_pawns << 8) & empty_squares;
-	for (; piece_mask; ++score, piece_mask &= piece_mask - 1);
-	piece_mask = (pos->b_pawns >> 8) & empty_squares;
-	for (; piece_mask; --score, piece_mask &= piece_mask - 1);
-    
-	/* Pawn captures.  */
-	piece_mask = ((pos->w_pawns & ~CHI_H_MASK) << 7) & occ_squares;
-	for (; piece_mask; ++score, piece_mask &= piece_mask - 1);
-	piece_mask = ((pos->b_pawns & ~CHI_H_MASK) >> 9) & occ_squares;
-	for (; piece_mask; --score, piece_mask &= piece_mask - 1);
-	piece_mask = ((pos->w_pawns & ~CHI_A_MASK) << 9) & occ_squares;
-	for (; piece_mask; ++score, piece_mask &= piece_mask - 1);
-	piece_mask = ((pos->b_pawns & ~CHI_A_MASK) >> 7) & occ_squares;
-	for (; piece_mask; --score, piece_mask &= piece_mask - 1);
-
-	/* Knight moves, captures, and defenses.  */
-	piece_mask = pos->w_knights;
-	while (piece_mask) {
-		unsigned int from = 
-			chi_bitv2shift (chi_clear_but_least_set(piece_mask));
-		bitv64 attack_mask = knight_attacks[from];
-		for (; attack_mask; ++score, attack_mask &= attack_mask - 1);
-		piece_mask = chi_clear_least_set(piece_mask);	
-	}
-
-    piece_mask = pos->b_knights;
-    while (piece_mask) {
-		unsigned int from = 
-			chi_bitv2shift (chi_clear_but_least_set(piece_mask));
-		bitv64 attack_mask = knight_attacks[from];
-		for (; attack_mask; --score, attack_mask &= attack_mask - 1);
-		piece_mask = chi_clear_least_set(piece_mask);	
-	}
-
-	bitv64 occupancy = pos->w_pieces | pos->b_pieces;
-	bitv64 empty_mask = ~occupancy;
-
-	piece_mask = pos->w_rooks;
-	while(piece_mask) {
-		int from = chi_bitv2shift(chi_clear_but_least_set(piece_mask));
-		bitv64 attack_mask = Rmagic(from, occupancy);
-		bitv64 reachable_mask = attack_mask && (empty_mask | pos->b_pieces);
-
-		score += popcount(reachable_mask);
-
-		piece_mask = chi_clear_least_set(piece_mask);
-	}
-
-	piece_mask = pos->b_rooks;
-	while(piece_mask) {
-		int from = chi_bitv2shift(chi_clear_but_least_set(piece_mask));
-		bitv64 attack_mask = Rmagic(from, occupancy);
-		bitv64 reachable_mask = attack_mask && (empty_mask | pos->w_pieces);
-
-		score -= popcount(reachable_mask);
-
-		piece_mask = chi_clear_least_set(piece_mask);
-	}
+	bitv64 signature = tree->pawn_signatures[ply];
+	PawnEntry *entry = pawn_hash_slot(signature);
+	int white_mg, white_eg, black_mg, black_eg;
 
-	piece_mask = pos->w_rooks;
-	while(piece_mask) {
-		int from = chi_bitv2shift(chi_clear_but_least_set(piece_mask));
-		bitv64 attack_mask = Rmagic(from, occupancy);
-		bitv64 reachable_mask = attack_mask && (empty_mask | pos->b_pieces);
-
-		score += popcount(reachable_mask);
-
-		piece_mask = chi_clear_least_set(piece_mask);
+	if (entry->signature == signature) {
+		++tree->stats.pawn_hits;
+		return entry;
 	}
 
-	piece_mask = pos->b_rooks;
-	while(piece_mask) {
-		int from = chi_bitv2shift(chi_clear_but_least_set(piece_mask));
-		bitv64 attack_mask = Rmagic(from, occupancy);
-		bitv64 reachable_mask = attack_mask && (empty_mask | pos->w_pieces);
-
-		score -= popcount(reachable_mask);
-
-		piece_mask = chi_clear_least_set(piece_mask);
-	}
+	entry->signature = signature;
+	evaluate_white_pawns(&tree->position, entry, &white_mg, &white_eg);
+	evaluate_black_pawns(&tree->position, entry, &black_mg, &black_eg);
+	entry->score[0] = white_mg - black_mg;
+	entry->score[1] = white_eg - black_eg;
 
-    return score;
+	return entry;
 }
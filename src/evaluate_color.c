@@ -0,0 +1,207 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* This is a code fragment, that gets included by evaluate.c once for
+   every color.  Do not use it directly!  All scores are from the point
+   of view of the color MY_COLOR.  */
+
+/* Development in the opening.  */
+static int
+evaluate_color_dev(const chi_pos *pos)
+{
+	int score = 0;
+	bitv64 pawns = MY_PAWNS(pos);
+	bitv64 bishops = MY_BISHOPS(pos) & ~MY_ROOKS(pos);
+	bitv64 queens = MY_BISHOPS(pos) & MY_ROOKS(pos);
+	bitv64 center_pawns = pawns & (CHI_D_MASK | CHI_E_MASK);
+
+	/* Penalty for premature queen moves.  */
+	if (!(queens & CHI_D_MASK & FIRST_RANK)
+	    && (!(LOST_KING_CASTLE(pos) && LOST_QUEEN_CASTLE(pos))
+	        || (MY_KNIGHTS(pos) & (CHI_B_MASK | CHI_G_MASK) & FIRST_RANK)
+	        || (bishops & (CHI_C_MASK | CHI_F_MASK) & FIRST_RANK)))
+		score -= EVAL_PREMATURE_QUEEN_MOVE;
+
+	/* Do not block c pawn in queen pawn openings.  */
+	if (!((pawns & CHI_D_MASK & FOURTH_RANK)
+	      && (pawns & CHI_E_MASK & FOURTH_RANK))
+	    && (pawns & CHI_C_MASK & SECOND_RANK)
+	    && ((bishops | MY_KNIGHTS(pos)) & CHI_C_MASK & THIRD_RANK))
+		score -= EVAL_BLOCKED_C_PAWN;
+
+	/* Penalty for blocked center pawns.  */
+	if (FORWARD(center_pawns) & (pos->w_pieces | pos->b_pieces))
+		score -= EVAL_BLOCKED_CENTER_PAWN;
+
+	if (!(LOST_KING_CASTLE(pos) && LOST_QUEEN_CASTLE(pos))
+	    && !CASTLED(pos)) {
+		/* Penalty for not having castled.  */
+		score -= EVAL_NOT_CASTLED;
+
+		if (!KING_CASTLE(pos)) score -= EVAL_LOST_CASTLE;
+
+		if (!QUEEN_CASTLE(pos)) score -= EVAL_LOST_CASTLE;
+	}
+
+	return score;
+}
+
+/* Pawn shelter and other pieces in front of the king.  */
+static int
+evaluate_color_king(const chi_pos *pos, const PawnEntry *pawns)
+{
+	bitv64 king_mask = MY_KINGS(pos);
+	int king_shift = chi_bitv2shift(chi_clear_but_least_set(king_mask));
+	bitv64 king_wall;
+	int score = 0;
+
+	if (king_mask & FIRST_RANK)
+		score += pawns->shelter[MY_COLOR][king_shift & 0x7];
+
+	/* The three squares in front of the king.  */
+	king_wall = FORWARD(king_mask
+	                    | ((king_mask & ~CHI_A_MASK) << 1)
+	                    | ((king_mask & ~CHI_H_MASK) >> 1));
+	for (king_wall &= MY_PIECES(pos);
+	     king_wall;
+	     score += 2, king_wall &= king_wall - 1);
+
+	return score;
+}
+
+/* Passed, isolated, backward, and doubled pawns, and the shelter for
+ * every file of the king.
+ */
+static void
+evaluate_color_pawns(const chi_pos *pos, PawnEntry *entry, int *mg, int *eg)
+{
+	bitv64 mine = MY_PAWNS(pos);
+	bitv64 theirs = HER_PAWNS(pos);
+	bitv64 their_attacks = HER_PAWN_ATTACKS(theirs);
+	bitv64 piece_mask;
+	int king_file;
+
+	*mg = *eg = 0;
+	entry->passed[MY_COLOR] = 0;
+
+	piece_mask = mine;
+	while (piece_mask) {
+		bitv64 pawn_mask = chi_clear_but_least_set(piece_mask);
+		int square = chi_bitv2shift(pawn_mask);
+		int rank = square >> 3;
+		int file = square & 0x7;  /* Really 7 - file.  */
+		bitv64 file_mask = CHI_H_MASK << file;
+		bitv64 neighbours = 0;
+		bitv64 ahead = AHEAD(rank);
+
+		if (file > 0) neighbours |= CHI_H_MASK << (file - 1);
+		if (file < 7) neighbours |= CHI_H_MASK << (file + 1);
+
+		if (!(theirs & ahead & (file_mask | neighbours))) {
+			entry->passed[MY_COLOR] |= pawn_mask;
+			*mg += passed_pawn_bonus[RELATIVE_RANK(rank)] >> 1;
+			*eg += passed_pawn_bonus[RELATIVE_RANK(rank)];
+		}
+
+		if (!(mine & neighbours)) {
+			*mg -= EVAL_ISOLATED_PAWN_MG;
+			*eg -= EVAL_ISOLATED_PAWN_EG;
+		} else if (!(mine & neighbours & ~ahead)
+		           && (their_attacks & FORWARD(pawn_mask))) {
+			/* All neighbours are ahead, and the pawn cannot advance
+			 * safely.
+			 */
+			*mg -= EVAL_BACKWARD_PAWN_MG;
+			*eg -= EVAL_BACKWARD_PAWN_EG;
+		}
+
+		if (mine & ahead & file_mask) {
+			*mg -= EVAL_DOUBLED_PAWN_MG;
+			*eg -= EVAL_DOUBLED_PAWN_EG;
+		}
+
+		piece_mask = chi_clear_least_set(piece_mask);
+	}
+
+	for (king_file = 0; king_file < 8; ++king_file) {
+		bitv64 zone = CHI_H_MASK << king_file;
+		bitv64 shelter_mask;
+		int shelter = 0;
+
+		if (king_file > 0) zone |= CHI_H_MASK << (king_file - 1);
+		if (king_file < 7) zone |= CHI_H_MASK << (king_file + 1);
+
+		for (shelter_mask = mine & zone & SECOND_RANK;
+		     shelter_mask;
+		     shelter += 2, shelter_mask &= shelter_mask - 1);
+		for (shelter_mask = mine & zone & THIRD_RANK;
+		     shelter_mask;
+		     ++shelter, shelter_mask &= shelter_mask - 1);
+
+		entry->shelter[MY_COLOR][king_file] = shelter;
+	}
+}
+
+/* The number of squares that the pieces can move to.  Queens count as
+ * a bishop and a rook.
+ *
+ * The attack map of chi_context_attacked_by() cannot be used here.  It
+ * is the union of all attacks, and squares attacked by more than one
+ * piece would only be counted once.  Nothing else in the evaluation
+ * needs the attacks of the pieces, so there is no lookup to share.
+ */
+static int
+evaluate_color_mobility(const chi_pos *pos)
+{
+	bitv64 occupancy = pos->w_pieces | pos->b_pieces;
+	bitv64 empty = ~occupancy;
+	bitv64 targets = ~MY_PIECES(pos);
+	bitv64 pawns = MY_PAWNS(pos);
+	bitv64 single_steps = FORWARD(pawns) & empty;
+	bitv64 knights = MY_KNIGHTS(pos);
+	bitv64 bishops = MY_BISHOPS(pos);
+	bitv64 rooks = MY_ROOKS(pos);
+	int score;
+
+	score = chi_popcount(single_steps)
+		+ chi_popcount(FORWARD(single_steps & THIRD_RANK) & empty)
+		+ chi_popcount(MY_PAWN_ATTACKS(pawns) & HER_PIECES(pos));
+
+	while (knights) {
+		int from = chi_bitv2shift(chi_clear_but_least_set(knights));
+
+		score += chi_popcount(chi_knight_attacks[from] & targets);
+		knights = chi_clear_least_set(knights);
+	}
+
+	while (bishops) {
+		int from = chi_bitv2shift(chi_clear_but_least_set(bishops));
+
+		score += chi_popcount(Bmagic(from, occupancy) & targets);
+		bishops = chi_clear_least_set(bishops);
+	}
+
+	while (rooks) {
+		int from = chi_bitv2shift(chi_clear_but_least_set(rooks));
+
+		score += chi_popcount(Rmagic(from, occupancy) & targets);
+		rooks = chi_clear_least_set(rooks);
+	}
+
+	return score;
+}
@@ -51,8 +51,9 @@ lisco_initialize(const char *program_name)
 	uci_init(&lisco.uci, stdin, "[standard input]",
 			stdout, "[standard output]");
 	chi_mm_init();
-	tt_init(LISCO_DEFAULT_TT_SIZE * 1 << 20);
-	init_ev_hash(1024 * 1024 * 100);
+	nnue_init();
+	init_endgames();
+	lisco_thread_init();
 	errnum = chi_zk_init(&lisco.zk_handle);
 	if (errnum) {
 		error (EXIT_FAILURE, 0,
@@ -60,3 +61,21 @@ lisco_initialize(const char *program_name)
 		       chi_strerror (errnum));
 	}
 }
+
+void
+lisco_thread_init(void)
+{
+	tt_init((size_t) lisco.uci.hash_size << 20);
+	init_ev_hash((size_t) lisco.uci.ev_size << 20);
+	init_pawn_hash((size_t) lisco.uci.pawn_size << 20);
+	init_material();
+}
+
+void
+lisco_thread_done(void)
+{
+	tt_destroy();
+	free_ev_hash();
+	free_pawn_hash();
+	free_material();
+}
@@ -0,0 +1,208 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/* Generate endgame tables for the engine.
+ *
+ * Tables that already exist in the output directory are loaded instead
+ * of generated, and so are the smaller tables that captures and
+ * promotions lead to.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <closeout.h>
+#include <error.h>
+#include <progname.h>
+#include <xalloc.h>
+
+#include <libchi.h>
+
+#include "lisco.h"
+
+/* All tables with three and four pieces.  */
+static const char *all_tables[] = {
+	"KQvK", "KRvK", "KBvK", "KNvK", "KPvK",
+	"KQQvK", "KQRvK", "KQBvK", "KQNvK", "KQPvK", "KRRvK", "KRBvK",
+	"KRNvK", "KRPvK", "KBBvK", "KBNvK", "KBPvK", "KNNvK", "KNPvK",
+	"KPPvK",
+	"KQvKQ", "KQvKR", "KQvKB", "KQvKN", "KQvKP", "KRvKR", "KRvKB",
+	"KRvKN", "KRvKP", "KBvKB", "KBvKN", "KBvKP", "KNvKN", "KNvKP",
+	"KPvKP",
+};
+
+#define NUM_TABLES (sizeof all_tables / sizeof all_tables[0])
+
+/* The tables to generate, smaller ones first.  */
+static Tablebase tables[NUM_TABLES];
+static size_t num_tables;
+
+static void add_table(const char *name);
+
+static void
+usage(int status)
+{
+	if (status != EXIT_SUCCESS) {
+		fprintf(stderr, "Try '%s -h' for more information.\n",
+		        program_name);
+		exit(status);
+	}
+
+	printf("Usage: %s [OPTION]... [TABLE]...\n", program_name);
+	printf("Generate endgame tables like KRvKP, by default all tables with"
+	       " three and four\npieces.\n\n");
+	printf("  -d DIRECTORY  read and write the tables in DIRECTORY"
+	       " (default: .)\n");
+	printf("  -j THREADS    use THREADS threads (default: all cores)\n");
+	printf("  -h            display this help and exit\n");
+
+	exit(status);
+}
+
+/* Add the table without piece SKIP, and with REPLACE instead of piece
+ * PROMOTE.
+ */
+static void
+add_subtable(const Tablebase *tb, int skip, int promote, chi_piece_t replace)
+{
+	static const char piece_letters[] = " PNBRQK";
+	char name[sizeof tb->name];
+	char *ptr = name;
+	chi_color_t color;
+	int i;
+
+	for (color = chi_white; color <= chi_black; ++color) {
+		if (color == chi_black)
+			*ptr++ = 'v';
+		*ptr++ = 'K';
+		for (i = 0; i < tb->num_pieces; ++i) {
+			if (i == skip || tb->colors[i] != color)
+				continue;
+			*ptr++ = piece_letters[i == promote ? replace : tb->pieces[i]];
+		}
+	}
+	*ptr = '\0';
+
+	if (strcmp(name, "KvK") != 0)
+		add_table(name);
+}
+
+static void
+add_table(const char *name)
+{
+	Tablebase tb;
+	chi_piece_t piece;
+	size_t i;
+
+	if (tb_parse_name(&tb, name) != 0)
+		error(EXIT_FAILURE, 0, "invalid table '%s'", name);
+
+	for (i = 0; i < num_tables; ++i) {
+		if (strcmp(tables[i].name, tb.name) == 0)
+			return;
+	}
+
+	for (i = 0; i < tb.num_pieces; ++i) {
+		add_subtable(&tb, i, -1, empty);
+		if (tb.pieces[i] == pawn) {
+			for (piece = knight; piece <= queen; ++piece)
+				add_subtable(&tb, -1, i, piece);
+		}
+	}
+
+	tables[num_tables++] = tb;
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *directory = ".";
+	long threads = sysconf(_SC_NPROCESSORS_ONLN);
+	char *path;
+	char *endptr;
+	size_t i;
+	int opt;
+
+	set_program_name(argv[0]);
+	atexit(close_stdout);
+
+	while ((opt = getopt(argc, argv, "d:j:h")) != -1) {
+		switch (opt) {
+			case 'd':
+				directory = optarg;
+				break;
+			case 'j':
+				threads = strtol(optarg, &endptr, 10);
+				if (*endptr || threads < 1)
+					error(EXIT_FAILURE, 0,
+					      "invalid number of threads '%s'", optarg);
+				break;
+			case 'h':
+				usage(EXIT_SUCCESS);
+				break;
+			default:
+				usage(EXIT_FAILURE);
+		}
+	}
+	if (threads < 1)
+		threads = 1;
+
+	if (optind == argc) {
+		for (i = 0; i < NUM_TABLES; ++i)
+			add_table(all_tables[i]);
+	} else {
+		for (; optind < argc; ++optind)
+			add_table(argv[optind]);
+	}
+
+	chi_mm_init();
+
+	for (i = 0; i < num_tables; ++i) {
+		Tablebase *tb = tables + i;
+		struct timeval start = rtime();
+
+		path = xmalloc(strlen(directory) + strlen(tb->name) + 6);
+		sprintf(path, "%s/%s.ltb", directory, tb->name);
+
+		if (tb_load(path) == 0) {
+			printf("%s: loaded from %s\n", tb->name, path);
+			free(path);
+			continue;
+		}
+		if (errno != ENOENT)
+			error(EXIT_FAILURE, errno, "%s", path);
+
+		tb_generate(tb, threads);
+		if (tb_write(tb, path) != 0)
+			error(EXIT_FAILURE, errno, "%s", path);
+		tb_register(tb);
+
+		printf("%s: %lu positions, longest mate %u plies, %.1f s\n",
+		       tb->name, tb->size, tb->longest,
+		       rdifftime(rtime(), start) / 1000.0);
+		free(path);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -22,6 +22,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <basename.h>
 #include <closeout.h>
@@ -47,6 +48,11 @@ main (int argc, char *argv[])
 
 	atexit(close_stdout);
 
+	if (argc > 1 && strcmp(argv[1], "analyze") == 0) {
+		lisco_initialize(argv[0]);
+		return analyze_main(argc - 1, argv + 1);
+	}
+
 	setvbuf(stdin, (char *) NULL, _IONBF, 0);
 	setvbuf(stdout, (char *) NULL, _IONBF, 0);
 	setvbuf(stderr, (char *) NULL, _IONBF, 0);
@@ -23,16 +23,94 @@
 # include <config.h>
 #endif
 
+#include <pthread.h>
+#include <stdio.h>
+
 #include <libchi.h>
 
 #include "uci-engine.h"
 
+/* Default sizes of the hash tables in MB.  */
 #define LISCO_DEFAULT_TT_SIZE 16
+#define LISCO_DEFAULT_EV_SIZE 100
+#define LISCO_DEFAULT_PAWN_SIZE 4
+#define LISCO_MAX_HASH_SIZE 65536
 
 #define MATE -10000
 #define INF ((-(MATE)) << 1)
 #define MAX_PLY 512
 
+/* Base score for positions that are known to be won.  */
+#define KNOWN_WIN 5000
+
+/* Results of recognize_endgame().  */
+#define ENDGAME_UNKNOWN 0
+#define ENDGAME_SCALED 1
+#define ENDGAME_EXACT 2
+
+/* Endgame tables exist for at most that many pieces, including the
+ * kings.
+ */
+#define TB_MAX_PIECES 4
+
+/* Values in the endgame tables, from the point of view of the side on
+ * move.  Wins and losses store the number of moves until mate.
+ */
+#define TB_DRAW 0
+#define TB_ILLEGAL 127
+#define TB_LOSS 128
+#define TB_IS_WIN(v) ((v) > TB_DRAW && (v) < TB_ILLEGAL)
+#define TB_IS_LOSS(v) ((v) >= TB_LOSS)
+/* Distance to mate in plies.  */
+#define TB_PLIES(v) (TB_IS_WIN(v) ? 2 * (v) - 1 : 2 * ((v) - TB_LOSS))
+
+/* Evaluation of an ending with known material for the STRONG side,
+ * see endgame.c.
+ */
+typedef int (*EndgameFunction)(const chi_pos *pos, chi_color_t strong);
+
+/* The end game score is multiplied by MaterialEntry.scale and divided
+ * by this.
+ */
+#define MATERIAL_SCALE_NORMAL 64
+
+/* Everything in the evaluation that only depends on the material.  The
+ * entries are looked up by the material key of the position.
+ */
+typedef struct MaterialEntry {
+	bitv64 key;
+	/* Bonus for the mix of pieces from white's point of view.  */
+	short int imbalance;
+	/* The game phase, at most CHI_PHASE_MAX.  */
+	unsigned char phase;
+	/* Non-zero if neither side has enough material to mate.  */
+	unsigned char draw;
+	/* Scale for end game scores in favor of white and black.  */
+	unsigned char scale[2];
+	/* ENDGAME_EXACT or ENDGAME_SCALED if there is a recognizer.  */
+	unsigned char endgame_result;
+	chi_color_t strong;
+	EndgameFunction endgame;
+} MaterialEntry;
+
+/* One endgame table.  The pieces other than the kings are listed with
+ * the white ones first, and white is always the stronger side.
+ */
+typedef struct Tablebase {
+	char name[16];
+	int num_pieces;
+	chi_piece_t pieces[TB_MAX_PIECES - 2];
+	chi_color_t colors[TB_MAX_PIECES - 2];
+	int pawns;
+	/* Number of positions.  */
+	unsigned long size;
+	/* Longest distance to mate in plies.  */
+	unsigned int longest;
+	unsigned char *values;
+	void *map;
+	size_t map_size;
+} Tablebase;
+
 typedef struct MoveList {
 	chi_move *moves;
 	size_t num_moves;
@@ -50,6 +128,8 @@ typedef struct SearchParams {
 	unsigned long depth;
 	MoveList searchmoves;
 	unsigned long long nodes;
+	/* Time lost per move for communication with the GUI.  */
+	unsigned long overhead;
 } SearchParams;
 
 typedef struct Lisco {
@@ -59,6 +139,18 @@ typedef struct Lisco {
 	// The current position.
 	chi_pos position;
 
+	// How the game started, "startpos" or the FEN string from the last
+	// "position" command, or NULL if the position is not known to
+	// result from it.
+	char *game_start;
+
+	// The moves played since the start of the game.
+	MoveList game_moves;
+
+	// The signatures of all positions of the game for the detection of
+	// repetitions, one more than the number of moves.
+	bitv64 *game_signatures;
+
 	// The move found.
 	chi_move bestmove;
 
@@ -74,39 +166,155 @@ typedef struct Lisco {
 	chi_zk_handle zk_handle;
 } Lisco;
 
+/* Principal variations are cut off after that many moves.  */
+#define MAX_PV 64
+
 typedef struct Line {
-	chi_move moves[MAX_PLY];
+	chi_move moves[MAX_PV];
 	unsigned int num_moves;
 } Line;
 
+/* Dimensions of the evaluation network, see nnue.c.  */
+#define NNUE_INPUTS (2 * 6 * 64)
+#define NNUE_HIDDEN 256
+#define NNUE_L1 32
+
+/* The first layer of the network, seen from white and from black.  */
+typedef struct NNUEAccumulator {
+	short int values[2][NNUE_HIDDEN];
+} NNUEAccumulator;
+
+typedef enum NNUEKernel {
+	NNUE_KERNEL_SCALAR = 0,
+	NNUE_KERNEL_SSE41,
+	NNUE_KERNEL_AVX2
+} NNUEKernel;
+
+/* Stages of the evaluation after which it can stop early.  */
+enum {
+	EVAL_STAGE_PSQ = 0,
+	EVAL_STAGE_PAWNS,
+	EVAL_STAGE_KING,
+	EVAL_STAGES
+};
+
+/* Counters for tuning, see statistics.c.  */
+typedef struct SearchStats {
+	unsigned long long qnodes;
+	unsigned long long evals;
+	unsigned long long ev_hits;
+	unsigned long long pawn_hits;
+	/* How often the lazy evaluation stopped after each stage.  */
+	unsigned long long lazy_exits[EVAL_STAGES];
+	unsigned long long tt_probes;
+	unsigned long long tt_hits;
+	unsigned long long tb_hits;
+	/* Beta cutoffs in the main search, and how many of them were caused
+	 * by the first move searched.
+	 */
+	unsigned long long cutoffs;
+	unsigned long long first_move_cutoffs;
+	/* The deepest ply reached in the current iteration.  */
+	int seldepth;
+	/* Nodes (main and quiescence) and milliseconds of each completed
+	 * iteration, indexed by depth.
+	 */
+	int iterations;
+	unsigned long long iteration_nodes[MAX_PLY + 1];
+	long long int iteration_time[MAX_PLY + 1];
+	/* The best move after each completed iteration.  */
+	chi_move iteration_moves[MAX_PLY + 1];
+} SearchStats;
+
 typedef struct Tree {
 	bitv64 signatures[MAX_PLY + 1];
+	bitv64 pawn_signatures[MAX_PLY + 1];
 
 	chi_pos position;
 	chi_move bestmove;
 	int score;
 	int depth;
 	int max_depth;
+
+	/* Number of lines to search, the number of lines found so far in
+	 * the current iteration, and their root moves and scores for the
+	 * side to move, the best first.
+	 */
+	int multipv;
+	int pv_count;
+	Line multipv_lines[UCI_ENGINE_MAX_MULTIPV];
+	int multipv_scores[UCI_ENGINE_MAX_MULTIPV];
+
+	/* Nodes of the main search, the quiescence search is counted in
+	 * the statistics.
+	 */
 	unsigned long long nodes;
-	unsigned long long evals;
 
 	MoveList searchmoves;
 
-	Line line;
-
-	struct timeval start_time;
-	unsigned long long int nodes_to_tc;
-	long long int fixed_time;
-	int move_now;
+	/* Principal variations.  PV[PLY] is the best line found so far
+	 * from the node at PLY.  It is built from PV[PLY + 1], whenever alpha
+	 * improves.
+	 */
+	Line pv[MAX_PLY + 1];
+
+	/* Time management, see time-control.c.  All times are in
+	 * milliseconds on the monotonic clock.  The soft limit is the
+	 * budget for the move, scaled after each iteration if FLEXIBLE_TIME
+	 * is set.  No new iteration is started after it.  The hard limit
+	 * aborts the search, 0 means no limit.
+	 */
+	long long int start_time;
+	long long int soft_limit;
+	long long int hard_limit;
+	int flexible_time;
+	unsigned long long int max_nodes;
+	/* Set by the timer thread, when the search has to stop.  */
+	volatile int move_now;
+	/* Best move and score of the previous iteration, and a decaying
+	 * count of the changes of the best move.
+	 */
+	chi_move last_bestmove;
+	int last_score;
+	double bestmove_changes;
+	/* The timer thread that sets MOVE_NOW at the hard limit.  */
+	pthread_t timer_thread;
+	pthread_mutex_t timer_mutex;
+	pthread_cond_t timer_cond;
+	int timer_running;
+	int timer_cancelled;
+
+	/* Where the principal variations are printed, or NULL.  */
+	FILE *out;
 
 	chi_move hash_move[MAX_PLY];
 
-	unsigned long long tt_probes;
-	unsigned long long tt_hits;
-	unsigned long long ev_hits;
-	unsigned long long lazy_evals;
+	SearchStats stats;
+
+	/* How far the score of the last call to evaluate() can be off,
+	 * because the evaluation stopped early.  0 if it is exact.
+	 */
+	int lazy_margin;
+
+	/* Non-zero if the network evaluates the positions.  */
+	int nnue;
+	NNUEAccumulator accumulators[MAX_PLY + 1];
 } Tree;
 
+/* Everything in the evaluation that only depends on the pawns.  Scores
+ * are from white's point of view, for the middle game and the end game.
+ */
+typedef struct PawnEntry {
+	bitv64 signature;
+	/* Passed pawns of white and black.  */
+	bitv64 passed[2];
+	short int score[2];
+	/* Shelter for a king on its back rank, indexed by color and file
+	 * (shift & 7).
+	 */
+	unsigned char shelter[2][8];
+} PawnEntry;
+
 typedef struct MoveSelector {
 	chi_move moves[CHI_MAX_MOVES];
 	size_t num_moves;
@@ -122,10 +330,43 @@ extern Lisco lisco;
 
 extern void lisco_initialize(const char *progname);
 
+/* Allocate the hash tables and caches of the calling thread with the
+ * sizes from the UCI options, and free them again.  Every thread that
+ * searches has its own.
+ */
+extern void lisco_thread_init(void);
+extern void lisco_thread_done(void);
+
 extern int process_search_params(Tree *tree, SearchParams *params);
 
+/* Start the clock for TREE and the timer thread that enforces the hard
+ * limit.
+ */
+extern void tc_start(Tree *tree);
+
+/* Stop the timer thread of TREE.  */
+extern void tc_stop(Tree *tree);
+
+/* Milliseconds since tc_start().  */
+extern long long int tc_elapsed(const Tree *tree);
+
+/* Update the soft limit of TREE after an iteration that found BESTMOVE
+ * with SCORE for the side to move.  Returns non-zero if another
+ * iteration should be started.
+ */
+extern int tc_next_iteration(Tree *tree, chi_move bestmove, int score);
+
+/* Search the current position of the engine and report to the UCI
+ * output.
+ */
 extern void think(Tree *tree);
 
+/* Search POS with the limits set up in TREE.  The progress is printed
+ * to TREE->OUT unless it is NULL.  Returns 0 or -1 if the game is over
+ * in POS.
+ */
+extern int search_position(Tree *tree, const chi_pos *pos);
+
 // Main transposition table.
 
 /* Create a new transposition table of approximatel SIZE bytes and destroy
@@ -139,6 +380,21 @@ extern void tt_clear(void);
 /* Completely destroy the transposition table.  */
 extern void tt_destroy(void);
 
+/* Used entries of the transposition table per mille.  */
+extern int tt_hashfull(void);
+
+/* Write the transposition table to FILENAME.  Returns 0 for success,
+ * or -1 and sets errno.
+ */
+extern int tt_save(const char *filename);
+
+/* Replace the transposition table with the one saved in FILENAME.  The
+ * file is mapped into memory, and the table has the size of the saved
+ * one.  Returns 0 for success, or -1 and sets errno.  Files that do not
+ * match this build or the zobrist keys fail with EINVAL.
+ */
+extern int tt_load(const char *filename);
+
 /* Initialize a fresh, empty move list.  */
 extern void move_list_init(MoveList *self);
 
@@ -158,35 +414,202 @@ void move_selector_init(MoveSelector *self, const Tree *tree, chi_move bestmove)
 
 /* Initialize a move selector from a search tree TREE for the quiescence
  * search.  That only produces good captures and promotions.  Good captures
- * and promotions are moves with a positive SEE value.
+ * and promotions are moves whose static exchange evaluation is at least
+ * THRESHOLD.  With a THRESHOLD of 0, these are the moves that do not lose
+ * material.
  */
-void move_selector_quiescence_init(MoveSelector *self, const Tree *tree);
+void move_selector_quiescence_init(MoveSelector *self, const Tree *tree,
+                                   int threshold);
 
 /* Get the next move from the pool or 0 if there are no more moves.  */
 chi_move move_selector_next(MoveSelector *self);
 
 /* Evaluate the position in a search tree. Returns positive results for an
- * advantage for the side on move.
+ * advantage for the side on move.  If the score is outside of the window
+ * ALPHA, BETA, the evaluation may stop early and return a bound, see
+ * the member lazy_margin of Tree.
  */
 extern int evaluate(Tree *tree, int ply, int alpha, int beta);
 
+/* Set up the table of recognized endings.  */
+extern void init_endgames(void);
+
+/* Find the recognizer for the material KEY.  Returns NULL if there is
+ * none.  Otherwise STRONG is set to the side that the recognizer is
+ * for, and RESULT to ENDGAME_EXACT or ENDGAME_SCALED.
+ */
+extern EndgameFunction find_endgame(bitv64 key, chi_color_t *strong,
+                                    int *result);
+
+/* Check whether POS is an ending with a known result.  Returns
+ * ENDGAME_EXACT if SCORE is the exact result, ENDGAME_SCALED if SCORE is
+ * only a guide for the search, or ENDGAME_UNKNOWN.  SCORE is from the
+ * point of view of the side on move.
+ */
+extern int recognize_endgame(const chi_pos *pos, int *score);
+
+/* The same for the material entry MATERIAL of POS.  */
+extern int evaluate_endgame(const MaterialEntry *material, const chi_pos *pos,
+                            int *score);
+
+/* Allocate the material table if necessary and invalidate all
+ * entries.
+ */
+extern void init_material(void);
+
+/* Free the material table.  */
+extern void free_material(void);
+
+/* Look up the material of POS and fill the entry on a miss.  */
+extern const MaterialEntry *material_probe(const chi_pos *pos);
+
+/* Fill TB for the material NAME, for example "KRvKN".  The sides are
+ * swapped if the weaker side comes first.  Returns 0 for success or -1.
+ */
+extern int tb_parse_name(Tablebase *tb, const char *name);
+
+/* Index of the position with the pieces on SQUARES, the white king
+ * first, then the black king, then the other pieces of TB in order.
+ * The kings must not stand next to each other, and pawns not on the
+ * first or last rank.
+ */
+extern unsigned long tb_index(const Tablebase *tb, chi_color_t on_move,
+                              const int *squares);
+
+/* Set up POS for position INDEX of TB.  Returns 0 if the position is
+ * legal, -1 otherwise.
+ */
+extern int tb_position(const Tablebase *tb, unsigned long index,
+                       chi_pos *pos);
+
+/* Index of POS in TB.  POS must have exactly the material of TB.  */
+extern unsigned long tb_pos_index(const Tablebase *tb, const chi_pos *pos);
+
+/* Look up POS in the registered tables.  Returns the value or -1 if
+ * there is no table for the material.  Castling and en passant are
+ * ignored.
+ */
+extern int tb_lookup(const chi_pos *pos);
+
+/* Like tb_lookup() but give up for positions that the tables do not
+ * cover.  On success, SCORE is set to a mate score for PLY, and
+ * non-zero is returned.
+ */
+extern int tb_probe(const chi_pos *pos, int ply, int *score);
+
+/* Make TB available for lookups.  The table is owned by the caller.  */
+extern void tb_register(Tablebase *tb);
+
+/* Forget all tables and unmap the ones that were loaded.  */
+extern void tb_clear(void);
+
+/* Map the table FILENAME into memory and register it.  Returns 0 for
+ * success, or -1 and sets errno.
+ */
+extern int tb_load(const char *filename);
+
+/* Load all tables in DIRECTORY and return their number or -1.  */
+extern int tb_init(const char *directory);
+
+/* Write TB to FILENAME.  Returns 0 for success, or -1 and sets errno.  */
+extern int tb_write(const Tablebase *tb, const char *filename);
+
+/* The number of pieces of the largest registered table or 0.  */
+extern int tb_max_pieces(void);
+
+/* Generate TB by retrograde analysis with THREADS threads.  All tables
+ * that captures and promotions lead to must already be registered.
+ */
+extern void tb_generate(Tablebase *tb, int threads);
+
+/* Start and finish an iteration of TREE.  */
+extern void stats_start_iteration(Tree *tree);
+extern void stats_end_iteration(Tree *tree);
+
+/* Effective branching factor of iteration DEPTH or 0.  */
+extern double stats_branching_factor(const Tree *tree, int depth);
+
+/* Report the statistics of TREE as UCI "info string" lines to OUT.  */
+extern void stats_print(const Tree *tree, FILE *out);
+
+/* Write the statistics of TREE as one line of JSON to OUT.  */
+extern void stats_write_json(const Tree *tree, FILE *out);
+
 /* Quiescence search.  */
 extern int quiesce(Tree *tree, int ply, int alpha, int beta);
 
+extern void init_pawn_hash(size_t memuse);
+extern void clear_pawn_hash(void);
+extern void free_pawn_hash(void);
+
+/* Return the slot for pawn signature SIGNATURE.  The caller has to check
+ * whether the slot actually belongs to it.
+ */
+extern PawnEntry *pawn_hash_slot(bitv64 signature);
+
+/* Map the network in FILENAME into memory and replace the current one.
+ * Returns 0 for success, or -1 and sets errno.
+ */
+extern int nnue_load(const char *filename);
+
+/* Non-zero if a network has been loaded.  */
+extern int nnue_loaded(void);
+
+/* Select the fastest kernel that the CPU supports.  */
+extern void nnue_init(void);
+
+/* Compute the accumulator for POS from scratch.  */
+extern void nnue_refresh(NNUEAccumulator *acc, const chi_pos *pos);
+
+/* Compute the accumulator TO after MOVE by MOVER from the accumulator
+ * FROM before the move.
+ */
+extern void nnue_update(const NNUEAccumulator *from, NNUEAccumulator *to,
+                        chi_move move, chi_color_t mover);
+
+/* Evaluate ACC for the side ON_MOVE with the selected kernel or with
+ * the scalar reference implementation.
+ */
+extern int nnue_evaluate(const NNUEAccumulator *acc, chi_color_t on_move);
+extern int nnue_evaluate_scalar(const NNUEAccumulator *acc,
+                                chi_color_t on_move);
+
+extern int nnue_kernel_supported(NNUEKernel kernel);
+extern int nnue_select_kernel(NNUEKernel kernel);
+extern NNUEKernel nnue_get_kernel(void);
+extern const char *nnue_kernel_name(NNUEKernel kernel);
+
 extern void init_ev_hash(size_t memuse);
 extern void clear_ev_hash(void);
+extern void free_ev_hash(void);
+/* Used entries of the evaluation cache per mille.  */
+extern int ev_hashfull(void);
 extern int probe_ev (chi_pos *pos, bitv64 signature, int *score);
 extern void store_ev_entry (chi_pos *pos, bitv64 signature, int score);
 
 extern unsigned long long perft(chi_pos *position, unsigned int depth,
         unsigned long long *counts, FILE *out);
 
+/* Analyze the EPD or FEN positions in IN, one per line, with THREADS
+ * threads and write the results as JSON lines to OUT.  LIMITS are
+ * the depth, nodes and movetime for positions that do not specify
+ * their own.  Returns 0 or -1 for a read error.
+ */
+extern int analyze(FILE *in, FILE *out, const SearchParams *limits,
+                   int threads);
+
+/* Entry point of "lisco analyze".  ARGV[0] is the command name.  */
+extern int analyze_main(int argc, char *argv[]);
+
 /* Current date and time.  */
 extern struct timeval rtime(void);
 
 /* Difference in microseconds.  */
 extern long long int rdifftime(struct timeval end, struct timeval start);
 
+/* Milliseconds on the monotonic clock.  */
+extern long long int rclock(void);
+
 #ifdef __cplusplus
 extern }
 #endif
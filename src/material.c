@@ -0,0 +1,169 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/* The material table.
+ *
+ * The entries are computed from the material key alone, the first time
+ * that a material configuration occurs.  Promotions make far too many
+ * keys possible to compute all of them in advance, but only a few of
+ * them occur in one game.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+
+#include <libchi.h>
+
+#include "xalloc.h"
+#include "lisco.h"
+
+/* A prime.  */
+#define MATERIAL_TABLE_SIZE 8191
+
+#define MATERIAL_BISHOP_PAIR 30
+/* Knights get better and rooks get worse with more pawns.  */
+#define MATERIAL_KNIGHT_PAWN 6
+#define MATERIAL_ROOK_PAWN 12
+
+/* Material of the pieces other than pawns in centipawns.  */
+#define MATERIAL_MINOR 300
+#define MATERIAL_ROOK 500
+
+/* Every searching thread has its own table.  */
+static __thread MaterialEntry *material_table = NULL;
+
+static const int piece_values[6] = { 0, 100, 300, 300, 500, 900 };
+
+/* Contribution of each piece to the game phase.  */
+static const int phase_weights[6] = { 0, 0, 1, 1, 2, 4 };
+
+#define count(key, color, piece) \
+	((int) CHI_MATERIAL_COUNT(key, color, piece))
+
+static int
+imbalance(bitv64 key, chi_color_t color)
+{
+	int pawns = count(key, color, pawn);
+	int score = 0;
+
+	if (count(key, color, bishop) >= 2)
+		score += MATERIAL_BISHOP_PAIR;
+
+	score += count(key, color, knight) * MATERIAL_KNIGHT_PAWN * (pawns - 5);
+	score -= count(key, color, rook) * MATERIAL_ROOK_PAWN * (pawns - 5);
+
+	return score;
+}
+
+static int
+non_pawn_material(bitv64 key, chi_color_t color)
+{
+	chi_piece_t piece;
+	int material = 0;
+
+	for (piece = knight; piece <= queen; ++piece)
+		material += count(key, color, piece) * piece_values[piece];
+
+	return material;
+}
+
+static int
+can_mate(bitv64 key, chi_color_t color)
+{
+	return count(key, color, pawn) || count(key, color, rook)
+		|| count(key, color, queen) || count(key, color, bishop) >= 2
+		|| (count(key, color, bishop) && count(key, color, knight));
+}
+
+/* Without pawns, a small advantage in pieces is usually not enough to
+ * win.
+ */
+static int
+scale(bitv64 key, chi_color_t strong)
+{
+	int strong_material = non_pawn_material(key, strong);
+	int weak_material = non_pawn_material(key, !strong);
+
+	if (count(key, strong, pawn)
+	    || strong_material - weak_material > MATERIAL_MINOR)
+		return MATERIAL_SCALE_NORMAL;
+
+	if (strong_material < MATERIAL_ROOK)
+		return 0;
+
+	return weak_material <= MATERIAL_MINOR ? 4 : 14;
+}
+
+static void
+compute_entry(MaterialEntry *entry, bitv64 key)
+{
+	chi_color_t color;
+	chi_piece_t piece;
+	int phase = 0;
+	int result;
+
+	for (color = chi_white; color <= chi_black; ++color) {
+		for (piece = knight; piece <= queen; ++piece)
+			phase += count(key, color, piece) * phase_weights[piece];
+	}
+
+	entry->key = key;
+	entry->imbalance = imbalance(key, chi_white) - imbalance(key, chi_black);
+	entry->phase = phase < CHI_PHASE_MAX ? phase : CHI_PHASE_MAX;
+	entry->draw = !can_mate(key, chi_white) && !can_mate(key, chi_black);
+	entry->scale[chi_white] = scale(key, chi_white);
+	entry->scale[chi_black] = scale(key, chi_black);
+	entry->strong = chi_white;
+	entry->endgame = find_endgame(key, &entry->strong, &result);
+	entry->endgame_result = entry->endgame ? result : ENDGAME_UNKNOWN;
+}
+
+void
+init_material(void)
+{
+	size_t i;
+
+	if (!material_table)
+		material_table = xmalloc(MATERIAL_TABLE_SIZE
+		                         * sizeof *material_table);
+
+	/* No position has that key.  */
+	for (i = 0; i < MATERIAL_TABLE_SIZE; ++i)
+		material_table[i].key = ~(bitv64) 0;
+}
+
+void
+free_material(void)
+{
+	free(material_table);
+	material_table = NULL;
+}
+
+const MaterialEntry *
+material_probe(const chi_pos *pos)
+{
+	bitv64 key = chi_material_key(pos);
+	MaterialEntry *entry = material_table + key % MATERIAL_TABLE_SIZE;
+
+	if (entry->key != key)
+		compute_entry(entry, key);
+
+	return entry;
+}
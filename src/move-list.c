@@ -45,7 +45,8 @@ move_list_destroy(MoveList *self)
 void
 move_list_add(MoveList *self, chi_move move)
 {
-	self->moves = xrealloc((void *) self->moves, ++self->num_moves);
+	self->moves = xrealloc((void *) self->moves,
+	                       ++self->num_moves * sizeof *self->moves);
 	self->moves[self->num_moves - 1] = move;
 }
 
@@ -25,11 +25,14 @@
 #include <libchi.h>
 
 #include "lisco.h"
+#include "profile.h"
 
 void
 move_selector_init(MoveSelector *self, const Tree *tree, chi_move bestmove)
 {
+	PROFILE_BEGIN(PROFILE_LEGAL_MOVES);
 	chi_move *move_ptr = chi_legal_moves(&tree->position, self->moves);
+	PROFILE_END(PROFILE_LEGAL_MOVES);
 	self->num_moves = move_ptr - self->moves;
 	self->selected = 0;
 	chi_move *sorted = self->moves;
@@ -62,7 +65,7 @@ move_selector_init(MoveSelector *self, const Tree *tree, chi_move bestmove)
 		chi_move key = sorted[step];
 		int j = step - 1;
 
-		while (key > sorted[j] && j >= 0) {
+		while (j >= 0 && key > sorted[j]) {
 			sorted[j + 1] = sorted[j];
 			--j;
 		}
@@ -70,11 +73,13 @@ move_selector_init(MoveSelector *self, const Tree *tree, chi_move bestmove)
 	}
 }
 
-#include <stdio.h>
 void
-move_selector_quiescence_init(MoveSelector *self, const Tree *tree)
+move_selector_quiescence_init(MoveSelector *self, const Tree *tree,
+                              int threshold)
 {
+	PROFILE_BEGIN(PROFILE_LEGAL_MOVES);
 	chi_move *move_ptr = chi_legal_moves(&tree->position, self->moves);
+	PROFILE_END(PROFILE_LEGAL_MOVES);
 	size_t size = move_ptr - self->moves;
 	self->selected = 0;
 	chi_move *sorted = self->moves;
@@ -82,21 +87,23 @@ move_selector_quiescence_init(MoveSelector *self, const Tree *tree)
 	const chi_pos *position = &tree->position;
 
 	/* First prune all non-captures, non-promotions and bad captures.  */
-	for (int i = 0; i < size; ++i) {
+	for (size_t i = 0; i < size; ++i) {
 		chi_move move = sorted[i];
-		bitv64 see;
-		if ((chi_move_victim(move) || chi_move_promote(move))
-		    && (see = chi_see(position, move) > 0)) {
-			sorted[num_moves++] = move | see << 32;
+		if (chi_move_victim(move) || chi_move_promote(move)) {
+			PROFILE_BEGIN(PROFILE_SEE);
+			int good = chi_see_ge(position, move, threshold);
+			PROFILE_END(PROFILE_SEE);
+			if (good)
+				sorted[num_moves++] = move;
 		}
 	}
 	self->num_moves = num_moves;
 
-	for (size_t step = 1; step < size; ++step) {
+	for (size_t step = 1; step < num_moves; ++step) {
 		chi_move key = sorted[step];
 		int j = step - 1;
 
-		while (key > sorted[j] && j >= 0) {
+		while (j >= 0 && key > sorted[j]) {
 			sorted[j + 1] = sorted[j];
 			--j;
 		}
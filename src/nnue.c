@@ -0,0 +1,536 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* An efficiently updatable neural network for the evaluation.
+ *
+ * The input layer has one feature for every combination of color, piece
+ * and square, seen from both sides.  Its output, the accumulator, is a
+ * plain sum of weight columns and is updated incrementally while moves
+ * are made.  Its clipped values for the side on move and the other side
+ * go into a small dense layer with 8 bit weights, and from there into
+ * a single output neuron.
+ *
+ * The weights are mapped into memory from a file:
+ *
+ *	magic		8 bytes "LISCONN1"
+ *	hidden		uint32, must be NNUE_HIDDEN
+ *	l1		uint32, must be NNUE_L1
+ *	ft_biases	int16[NNUE_HIDDEN]
+ *	ft_weights	int16[NNUE_INPUTS][NNUE_HIDDEN]
+ *	l1_biases	int32[NNUE_L1]
+ *	out_bias	int32
+ *	l1_weights	int8[NNUE_L1][2 * NNUE_HIDDEN]
+ *	out_weights	int8[NNUE_L1]
+ *
+ * All numbers are little-endian.  Big-endian machines cannot load
+ * networks.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libchi.h>
+
+#include "lisco.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define NNUE_X86 1
+# include <immintrin.h>
+#endif
+
+#define NNUE_MAGIC "LISCONN1"
+#define NNUE_HEADER_SIZE 16
+
+/* Activations are clipped to 0 .. NNUE_CLIP.  */
+#define NNUE_CLIP 127
+
+/* The dense layer is scaled down by 2 ** NNUE_L1_SHIFT, the output by
+ * NNUE_OUTPUT_SCALE to get centipawns.
+ */
+#define NNUE_L1_SHIFT 6
+#define NNUE_OUTPUT_SCALE 16
+
+#define NNUE_FILE_SIZE (NNUE_HEADER_SIZE \
+	+ NNUE_HIDDEN * sizeof(short int) \
+	+ NNUE_INPUTS * NNUE_HIDDEN * sizeof(short int) \
+	+ NNUE_L1 * sizeof(int) \
+	+ sizeof(int) \
+	+ NNUE_L1 * 2 * NNUE_HIDDEN \
+	+ NNUE_L1)
+
+typedef struct Network {
+	void *map;
+	size_t map_size;
+
+	const short int *ft_biases;
+	const short int *ft_weights;
+	const int *l1_biases;
+	const int *out_bias;
+	const signed char *l1_weights;
+	const signed char *out_weights;
+} Network;
+
+typedef void (*Affine)(const unsigned char *input, int *output);
+
+static Network network;
+
+static void affine_scalar(const unsigned char *input, int *output);
+
+static Affine affine = affine_scalar;
+static NNUEKernel kernel = NNUE_KERNEL_SCALAR;
+
+static unsigned int
+read_u32(const unsigned char *bytes)
+{
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16)
+		| ((unsigned int) bytes[3] << 24);
+}
+
+int
+nnue_load(const char *filename)
+{
+	struct stat st;
+	unsigned char *map;
+	const unsigned char *ptr;
+	int fd;
+
+#ifdef WORDS_BIGENDIAN
+	errno = ENOTSUP;
+	return -1;
+#endif
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return -1;
+	}
+
+	if (st.st_size != NNUE_FILE_SIZE) {
+		close(fd);
+		errno = EINVAL;
+		return -1;
+	}
+
+	map = mmap(NULL, NNUE_FILE_SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return -1;
+
+	if (memcmp(map, NNUE_MAGIC, 8) != 0
+	    || read_u32(map + 8) != NNUE_HIDDEN
+	    || read_u32(map + 12) != NNUE_L1) {
+		munmap(map, NNUE_FILE_SIZE);
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (network.map)
+		munmap(network.map, network.map_size);
+
+	network.map = map;
+	network.map_size = NNUE_FILE_SIZE;
+
+	ptr = map + NNUE_HEADER_SIZE;
+	network.ft_biases = (const short int *) ptr;
+	ptr += NNUE_HIDDEN * sizeof(short int);
+	network.ft_weights = (const short int *) ptr;
+	ptr += NNUE_INPUTS * NNUE_HIDDEN * sizeof(short int);
+	network.l1_biases = (const int *) ptr;
+	ptr += NNUE_L1 * sizeof(int);
+	network.out_bias = (const int *) ptr;
+	ptr += sizeof(int);
+	network.l1_weights = (const signed char *) ptr;
+	ptr += NNUE_L1 * 2 * NNUE_HIDDEN;
+	network.out_weights = (const signed char *) ptr;
+
+	return 0;
+}
+
+int
+nnue_loaded(void)
+{
+	return network.map != NULL;
+}
+
+/* Index of the input feature for a piece of color COLOR on SQUARE, seen
+ * from PERSPECTIVE.  Black sees the board with the ranks mirrored.
+ */
+static int
+feature(chi_color_t perspective, chi_color_t color, chi_piece_t piece,
+        int square)
+{
+	if (perspective == chi_black)
+		square ^= 56;
+
+	return ((color != perspective) * 6 + piece - 1) * 64 + square;
+}
+
+static void
+add_pieces(short int *values, chi_color_t perspective, chi_color_t color,
+           chi_piece_t piece, bitv64 mask)
+{
+	int i;
+
+	while (mask) {
+		int square = chi_bitv2shift(chi_clear_but_least_set(mask));
+		const short int *column = network.ft_weights
+			+ feature(perspective, color, piece, square) * NNUE_HIDDEN;
+
+		for (i = 0; i < NNUE_HIDDEN; ++i)
+			values[i] += column[i];
+
+		mask = chi_clear_least_set(mask);
+	}
+}
+
+void
+nnue_refresh(NNUEAccumulator *acc, const chi_pos *pos)
+{
+	chi_color_t perspective;
+
+	for (perspective = chi_white; perspective <= chi_black; ++perspective) {
+		short int *values = acc->values[perspective];
+
+		memcpy(values, network.ft_biases, sizeof acc->values[perspective]);
+
+		add_pieces(values, perspective, chi_white, pawn, pos->w_pawns);
+		add_pieces(values, perspective, chi_white, knight, pos->w_knights);
+		add_pieces(values, perspective, chi_white, bishop,
+		           pos->w_bishops & ~pos->w_rooks);
+		add_pieces(values, perspective, chi_white, rook,
+		           pos->w_rooks & ~pos->w_bishops);
+		add_pieces(values, perspective, chi_white, queen,
+		           pos->w_bishops & pos->w_rooks);
+		add_pieces(values, perspective, chi_white, king, pos->w_kings);
+
+		add_pieces(values, perspective, chi_black, pawn, pos->b_pawns);
+		add_pieces(values, perspective, chi_black, knight, pos->b_knights);
+		add_pieces(values, perspective, chi_black, bishop,
+		           pos->b_bishops & ~pos->b_rooks);
+		add_pieces(values, perspective, chi_black, rook,
+		           pos->b_rooks & ~pos->b_bishops);
+		add_pieces(values, perspective, chi_black, queen,
+		           pos->b_bishops & pos->b_rooks);
+		add_pieces(values, perspective, chi_black, king, pos->b_kings);
+	}
+}
+
+/* A piece that is added to or removed from the board.  */
+typedef struct Change {
+	chi_color_t color;
+	chi_piece_t piece;
+	int square;
+} Change;
+
+static const short int *
+column(chi_color_t perspective, const Change *change)
+{
+	return network.ft_weights + NNUE_HIDDEN
+		* feature(perspective, change->color, change->piece,
+		          change->square);
+}
+
+void
+nnue_update(const NNUEAccumulator *from, NNUEAccumulator *to,
+            chi_move move, chi_color_t mover)
+{
+	int orig = chi_move_from(move);
+	int dest = chi_move_to(move);
+	chi_piece_t attacker = chi_move_attacker(move);
+	chi_piece_t promote = chi_move_promote(move);
+	chi_piece_t victim = chi_move_victim(move);
+	int back_rank = mover == chi_white ? 0 : 56;
+	Change added[2], removed[2];
+	int num_changes = 1;
+	chi_color_t perspective;
+	int i;
+
+	removed[0].color = added[0].color = mover;
+	removed[0].piece = attacker;
+	removed[0].square = orig;
+	added[0].piece = promote ? promote : attacker;
+	added[0].square = dest;
+
+	if (victim) {
+		/* A capture removes two pieces.  */
+		removed[1].color = !mover;
+		removed[1].piece = victim;
+		removed[1].square = dest;
+		if (chi_move_is_ep(move))
+			removed[1].square += mover == chi_white ? -8 : 8;
+		added[1] = added[0];
+		num_changes = 2;
+	} else if (attacker == king && orig == CHI_E1 + back_rank
+	           && (dest == CHI_G1 + back_rank
+	               || dest == CHI_C1 + back_rank)) {
+		/* Castling moves a rook as well.  */
+		removed[1].color = added[1].color = mover;
+		removed[1].piece = added[1].piece = rook;
+		if (dest == CHI_G1 + back_rank) {
+			removed[1].square = CHI_H1 + back_rank;
+			added[1].square = CHI_F1 + back_rank;
+		} else {
+			removed[1].square = CHI_A1 + back_rank;
+			added[1].square = CHI_D1 + back_rank;
+		}
+		num_changes = 2;
+	}
+
+	for (perspective = chi_white; perspective <= chi_black; ++perspective) {
+		const short int *src = from->values[perspective];
+		short int *dst = to->values[perspective];
+		const short int *add0 = column(perspective, &added[0]);
+		const short int *sub0 = column(perspective, &removed[0]);
+
+		if (num_changes == 1) {
+			for (i = 0; i < NNUE_HIDDEN; ++i)
+				dst[i] = src[i] + add0[i] - sub0[i];
+		} else if (victim) {
+			const short int *sub1 = column(perspective, &removed[1]);
+
+			for (i = 0; i < NNUE_HIDDEN; ++i)
+				dst[i] = src[i] + add0[i] - sub0[i] - sub1[i];
+		} else {
+			const short int *add1 = column(perspective, &added[1]);
+			const short int *sub1 = column(perspective, &removed[1]);
+
+			for (i = 0; i < NNUE_HIDDEN; ++i)
+				dst[i] = src[i] + add0[i] + add1[i] - sub0[i] - sub1[i];
+		}
+	}
+}
+
+/* Clip the accumulator for the side on move and the other side into
+ * the input of the dense layer.
+ */
+static void
+transform(const NNUEAccumulator *acc, chi_color_t on_move,
+          unsigned char *input)
+{
+	const short int *us = acc->values[on_move];
+	const short int *them = acc->values[!on_move];
+	int i;
+
+	for (i = 0; i < NNUE_HIDDEN; ++i) {
+		int value = us[i];
+
+		input[i] = value < 0 ? 0 : value > NNUE_CLIP ? NNUE_CLIP : value;
+		value = them[i];
+		input[NNUE_HIDDEN + i] =
+			value < 0 ? 0 : value > NNUE_CLIP ? NNUE_CLIP : value;
+	}
+}
+
+static void
+affine_scalar(const unsigned char *input, int *output)
+{
+	int i, j;
+
+	for (j = 0; j < NNUE_L1; ++j) {
+		const signed char *weights = network.l1_weights
+			+ j * 2 * NNUE_HIDDEN;
+		int sum = network.l1_biases[j];
+
+		for (i = 0; i < 2 * NNUE_HIDDEN; ++i)
+			sum += weights[i] * input[i];
+
+		output[j] = sum;
+	}
+}
+
+#ifdef NNUE_X86
+/* The inputs are at most 127, so that the pairwise sums of
+ * PMADDUBSW cannot saturate.
+ */
+__attribute__((target("sse4.1")))
+static void
+affine_sse41(const unsigned char *input, int *output)
+{
+	const __m128i ones = _mm_set1_epi16(1);
+	int i, j;
+
+	for (j = 0; j < NNUE_L1; ++j) {
+		const signed char *weights = network.l1_weights
+			+ j * 2 * NNUE_HIDDEN;
+		__m128i sum = _mm_setzero_si128();
+
+		for (i = 0; i < 2 * NNUE_HIDDEN; i += 16) {
+			__m128i in = _mm_loadu_si128((const __m128i *) (input + i));
+			__m128i w = _mm_loadu_si128((const __m128i *) (weights + i));
+			__m128i products = _mm_maddubs_epi16(in, w);
+
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+		}
+
+		sum = _mm_hadd_epi32(sum, sum);
+		sum = _mm_hadd_epi32(sum, sum);
+		output[j] = network.l1_biases[j] + _mm_cvtsi128_si32(sum);
+	}
+}
+
+__attribute__((target("avx2")))
+static void
+affine_avx2(const unsigned char *input, int *output)
+{
+	const __m256i ones = _mm256_set1_epi16(1);
+	int i, j;
+
+	for (j = 0; j < NNUE_L1; ++j) {
+		const signed char *weights = network.l1_weights
+			+ j * 2 * NNUE_HIDDEN;
+		__m256i sum = _mm256_setzero_si256();
+		__m128i sum128;
+
+		for (i = 0; i < 2 * NNUE_HIDDEN; i += 32) {
+			__m256i in = _mm256_loadu_si256((const __m256i *) (input + i));
+			__m256i w = _mm256_loadu_si256(
+				(const __m256i *) (weights + i));
+			__m256i products = _mm256_maddubs_epi16(in, w);
+
+			sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+		}
+
+		sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum),
+		                       _mm256_extracti128_si256(sum, 1));
+		sum128 = _mm_hadd_epi32(sum128, sum128);
+		sum128 = _mm_hadd_epi32(sum128, sum128);
+		output[j] = network.l1_biases[j] + _mm_cvtsi128_si32(sum128);
+	}
+}
+#endif
+
+static int
+output_layer(const int *hidden)
+{
+	int sum = *network.out_bias;
+	int j;
+
+	for (j = 0; j < NNUE_L1; ++j) {
+		int value = hidden[j] >> NNUE_L1_SHIFT;
+
+		value = value < 0 ? 0 : value > NNUE_CLIP ? NNUE_CLIP : value;
+		sum += network.out_weights[j] * value;
+	}
+
+	return sum / NNUE_OUTPUT_SCALE;
+}
+
+int
+nnue_evaluate(const NNUEAccumulator *acc, chi_color_t on_move)
+{
+	unsigned char input[2 * NNUE_HIDDEN];
+	int hidden[NNUE_L1];
+
+	transform(acc, on_move, input);
+	affine(input, hidden);
+
+	return output_layer(hidden);
+}
+
+int
+nnue_evaluate_scalar(const NNUEAccumulator *acc, chi_color_t on_move)
+{
+	unsigned char input[2 * NNUE_HIDDEN];
+	int hidden[NNUE_L1];
+
+	transform(acc, on_move, input);
+	affine_scalar(input, hidden);
+
+	return output_layer(hidden);
+}
+
+int
+nnue_kernel_supported(NNUEKernel k)
+{
+	switch (k) {
+		case NNUE_KERNEL_SCALAR:
+			return 1;
+#ifdef NNUE_X86
+		case NNUE_KERNEL_SSE41:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("sse4.1");
+		case NNUE_KERNEL_AVX2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+#endif
+		default:
+			return 0;
+	}
+}
+
+int
+nnue_select_kernel(NNUEKernel k)
+{
+	if (!nnue_kernel_supported(k))
+		return -1;
+
+	switch (k) {
+#ifdef NNUE_X86
+		case NNUE_KERNEL_SSE41:
+			affine = affine_sse41;
+			break;
+		case NNUE_KERNEL_AVX2:
+			affine = affine_avx2;
+			break;
+#endif
+		default:
+			affine = affine_scalar;
+			break;
+	}
+	kernel = k;
+
+	return 0;
+}
+
+NNUEKernel
+nnue_get_kernel(void)
+{
+	return kernel;
+}
+
+const char *
+nnue_kernel_name(NNUEKernel k)
+{
+	switch (k) {
+		case NNUE_KERNEL_SSE41:
+			return "sse4.1";
+		case NNUE_KERNEL_AVX2:
+			return "avx2";
+		default:
+			return "scalar";
+	}
+}
+
+void
+nnue_init(void)
+{
+	if (nnue_select_kernel(NNUE_KERNEL_AVX2) != 0
+	    && nnue_select_kernel(NNUE_KERNEL_SSE41) != 0)
+		nnue_select_kernel(NNUE_KERNEL_SCALAR);
+}
@@ -0,0 +1,72 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libchi.h>
+
+#include "xalloc.h"
+#include "lisco.h"
+#include "util.h"
+
+#define MIN_PAWN_SIZE (sizeof (PawnEntry) * 1000)
+
+/* Every searching thread has its own table.  */
+static __thread PawnEntry *pawn_table = NULL;
+static __thread size_t pawn_mapped = 0;
+
+static __thread unsigned long int pawn_size = 0;
+
+void
+init_pawn_hash(size_t memuse)
+{
+	if (memuse < MIN_PAWN_SIZE)
+		memuse = MIN_PAWN_SIZE;
+
+	pawn_size = chi_closest_prime(memuse / sizeof *pawn_table);
+	free_huge(pawn_table, pawn_mapped);
+	pawn_table = xmalloc_huge(pawn_size * sizeof *pawn_table,
+	                          &pawn_mapped);
+}
+
+void
+clear_pawn_hash(void)
+{
+	clear_memory(pawn_table, pawn_size * sizeof *pawn_table,
+	             lisco.uci.option_threads);
+}
+
+void
+free_pawn_hash(void)
+{
+	free_huge(pawn_table, pawn_mapped);
+	pawn_table = NULL;
+	pawn_mapped = 0;
+	pawn_size = 0;
+}
+
+PawnEntry *
+pawn_hash_slot(bitv64 signature)
+{
+	return pawn_table + signature % ((bitv64) pawn_size);
+}
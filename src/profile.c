@@ -0,0 +1,76 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "profile.h"
+
+#ifdef LISCO_PROFILE
+
+#include <string.h>
+
+__thread ProfileCounter profile_counters[PROFILE_COUNTERS];
+
+static const char *profile_names[PROFILE_COUNTERS] = {
+	"legal_moves",
+	"apply_move",
+	"unapply_move",
+	"see",
+	"evaluate",
+	"probe_ev",
+	"move_selection",
+	"game_over",
+};
+
+void
+profile_reset(void)
+{
+	memset(profile_counters, 0, sizeof profile_counters);
+}
+
+void
+profile_print(FILE *out)
+{
+	int order[PROFILE_COUNTERS];
+	int i, j;
+
+	for (i = 0; i < PROFILE_COUNTERS; ++i) {
+		int id = i;
+
+		for (j = i; j > 0
+		     && profile_counters[order[j - 1]].cycles
+		        < profile_counters[id].cycles; --j)
+			order[j] = order[j - 1];
+		order[j] = id;
+	}
+
+	for (i = 0; i < PROFILE_COUNTERS; ++i) {
+		const ProfileCounter *counter = profile_counters + order[i];
+
+		if (!counter->calls)
+			continue;
+		fprintf(out, "info string profile %s calls %llu cycles %llu"
+		        " per call %.1f\n",
+		        profile_names[order[i]], counter->calls, counter->cycles,
+		        (double) counter->cycles / counter->calls);
+	}
+}
+
+#endif /* LISCO_PROFILE */
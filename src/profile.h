@@ -0,0 +1,102 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Optional call counters and cycle totals for the hot functions of the
+ * search.  They are compiled in with "configure --enable-profile".
+ * Otherwise all macros expand to nothing.
+ *
+ * A profiled call is enclosed in PROFILE_BEGIN(ID) and PROFILE_END(ID).
+ * The times are inclusive: the cycles of evaluate() include those of
+ * probe_ev().  Every thread has its own counters.
+ */
+
+#ifndef _PROFILE_H
+# define _PROFILE_H        /* Allow multiple inclusion.  */
+
+#include <stdio.h>
+
+typedef enum ProfileId {
+	PROFILE_LEGAL_MOVES = 0,
+	PROFILE_APPLY_MOVE,
+	PROFILE_UNAPPLY_MOVE,
+	PROFILE_SEE,
+	PROFILE_EVALUATE,
+	PROFILE_PROBE_EV,
+	PROFILE_MOVE_SELECTION,
+	PROFILE_GAME_OVER,
+	PROFILE_COUNTERS
+} ProfileId;
+
+#ifdef LISCO_PROFILE
+
+typedef struct ProfileCounter {
+	unsigned long long calls;
+	unsigned long long cycles;
+} ProfileCounter;
+
+extern __thread ProfileCounter profile_counters[PROFILE_COUNTERS];
+
+/* The time stamp counter on x86, nanoseconds elsewhere.  */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+static __inline__ unsigned long long
+profile_clock(void)
+{
+	unsigned int lo, hi;
+
+	__asm__ __volatile__("rdtsc" : "=a" (lo), "=d" (hi));
+
+	return ((unsigned long long) hi << 32) | lo;
+}
+#else
+# include <time.h>
+
+static inline unsigned long long
+profile_clock(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return 1000000000ULL * now.tv_sec + now.tv_nsec;
+}
+#endif
+
+# define PROFILE_BEGIN(id) \
+	unsigned long long profile_start_##id = profile_clock()
+# define PROFILE_END(id) \
+	do { \
+		++profile_counters[id].calls; \
+		profile_counters[id].cycles += profile_clock() - profile_start_##id; \
+	} while (0)
+
+/* Zero all counters.  */
+extern void profile_reset(void);
+
+/* Print the counters ranked by cycles as UCI "info string" lines.  */
+extern void profile_print(FILE *out);
+
+#else
+
+# define PROFILE_BEGIN(id) ((void) 0)
+# define PROFILE_END(id) ((void) 0)
+# define profile_reset() ((void) 0)
+# define profile_print(out) ((void) 0)
+
+#endif /* LISCO_PROFILE */
+
+#endif /* _PROFILE_H */
@@ -25,13 +25,31 @@
 #include <libchi.h>
 
 #include "lisco.h"
+#include "profile.h"
+
+/* Safety margin for delta pruning in centipawns.  */
+#define DELTA_MARGIN 200
 
 static void update_tree(Tree *tree, int ply, chi_pos *position, chi_move move);
 
 int
 quiesce(Tree *tree, int ply, int alpha, int beta)
 {
-	int value = evaluate(tree, ply, alpha, beta);
+	int value;
+	int stand_pat;
+
+	++tree->stats.qnodes;
+	if (ply > tree->stats.seldepth)
+		tree->stats.seldepth = ply;
+
+	PROFILE_BEGIN(PROFILE_EVALUATE);
+	value = stand_pat = evaluate(tree, ply, alpha, beta);
+	PROFILE_END(PROFILE_EVALUATE);
+
+	/* After a lazy exit, the real score can be higher than the stand
+	 * pat score by the margin of the evaluation.
+	 */
+	int delta_margin = DELTA_MARGIN + tree->lazy_margin;
 
 	if (value >= beta) {
 		return beta;
@@ -43,9 +61,20 @@ quiesce(Tree *tree, int ply, int alpha, int beta)
 
 	chi_pos *position = &tree->position;
 
+	/* Delta pruning.  Skip captures that cannot raise alpha, even if
+	 * the exchange on the target square goes well.  The move selector
+	 * applies the threshold for the current alpha, and never lets
+	 * losing captures through.
+	 */
+	int threshold = alpha - stand_pat - delta_margin;
+	if (threshold < 0)
+		threshold = 0;
+
 	// FIXME! The move selector should only generate captures and promotions.
 	MoveSelector selector;
-	move_selector_quiescence_init(&selector, tree);
+	PROFILE_BEGIN(PROFILE_MOVE_SELECTION);
+	move_selector_quiescence_init(&selector, tree, threshold);
+	PROFILE_END(PROFILE_MOVE_SELECTION);
 
 	chi_move move;
 	while ((move = move_selector_next(&selector))) {
@@ -53,7 +82,21 @@ quiesce(Tree *tree, int ply, int alpha, int beta)
 			return alpha;
 		}
 
+		/* Only if alpha has been raised, the threshold must be checked
+		 * again.
+		 */
+		if (alpha - stand_pat - delta_margin > threshold) {
+			PROFILE_BEGIN(PROFILE_SEE);
+			int good = chi_see_ge(position, move,
+			                      alpha - stand_pat - delta_margin);
+			PROFILE_END(PROFILE_SEE);
+			if (!good)
+				continue;
+		}
+
+		PROFILE_BEGIN(PROFILE_APPLY_MOVE);
 		chi_apply_move(position, move);
+		PROFILE_END(PROFILE_APPLY_MOVE);
 		update_tree(tree, ply, position, move);
 
 		value = -quiesce(tree, ply + 1, -beta, -alpha);
@@ -63,7 +106,9 @@ quiesce(Tree *tree, int ply, int alpha, int beta)
 				HASH_EXACT);
 		*/
 
+		PROFILE_BEGIN(PROFILE_UNAPPLY_MOVE);
 		chi_unapply_move(position, move);
+		PROFILE_END(PROFILE_UNAPPLY_MOVE);
 
 		if (value >= beta) {
 			return beta;
@@ -79,6 +124,14 @@ quiesce(Tree *tree, int ply, int alpha, int beta)
 static void
 update_tree(Tree *tree, int ply, chi_pos *position, chi_move move)
 {
+	/* The move has already been applied.  */
+	chi_color_t mover = !chi_on_move(position);
+
 	tree->signatures[ply + 1] = chi_zk_update_signature(lisco.zk_handle,
-		tree->signatures[ply], move, chi_on_move(position));
+		tree->signatures[ply], move, mover);
+	tree->pawn_signatures[ply + 1] = chi_zk_update_pawn_signature(
+		lisco.zk_handle, tree->pawn_signatures[ply], move, mover);
+	if (tree->nnue)
+		nnue_update(&tree->accumulators[ply],
+		            &tree->accumulators[ply + 1], move, mover);
 }
\ No newline at end of file
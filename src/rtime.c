@@ -24,6 +24,7 @@
 #include <errno.h>
 #include <string.h>
 #include <sys/time.h>
+#include <time.h>
 
 long long int 
 rdifftime (struct timeval end, struct timeval start)
@@ -47,3 +48,17 @@ rtime ()
 
 	return now;
 }
+
+long long int
+rclock(void)
+{
+	struct timespec now;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &now) < 0) {
+		fprintf(stderr, "Error reading monotonic clock: %s\n",
+		        strerror(errno));
+		return 0;
+	}
+
+	return 1000LL * now.tv_sec + now.tv_nsec / 1000000;
+}
@@ -0,0 +1,149 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+
+#include "lisco.h"
+
+/* Search statistics.  The counters are incremented directly in the
+ * search and the evaluation.  This file only keeps track of the
+ * iterations and reports the numbers.
+ */
+
+static double
+percent(unsigned long long part, unsigned long long total)
+{
+	return total ? 100.0 * part / total : 0;
+}
+
+static unsigned long long
+total_nodes(const Tree *tree)
+{
+	return tree->nodes + tree->stats.qnodes;
+}
+
+void
+stats_start_iteration(Tree *tree)
+{
+	tree->stats.seldepth = 0;
+}
+
+void
+stats_end_iteration(Tree *tree)
+{
+	SearchStats *stats = &tree->stats;
+	unsigned long long nodes = total_nodes(tree);
+	long long int elapsed = tc_elapsed(tree);
+	int depth = tree->depth;
+	int i;
+
+	if (depth < 1 || depth > MAX_PLY)
+		return;
+
+	/* The arrays hold the totals until all previous iterations are
+	 * subtracted.
+	 */
+	stats->iteration_nodes[depth] = nodes;
+	stats->iteration_time[depth] = elapsed;
+	stats->iteration_moves[depth] = tree->bestmove;
+	for (i = 1; i < depth; ++i) {
+		stats->iteration_nodes[depth] -= stats->iteration_nodes[i];
+		stats->iteration_time[depth] -= stats->iteration_time[i];
+	}
+	stats->iterations = depth;
+}
+
+double
+stats_branching_factor(const Tree *tree, int depth)
+{
+	const SearchStats *stats = &tree->stats;
+
+	if (depth < 2 || depth > stats->iterations
+	    || !stats->iteration_nodes[depth - 1])
+		return 0;
+
+	return (double) stats->iteration_nodes[depth]
+		/ stats->iteration_nodes[depth - 1];
+}
+
+void
+stats_print(const Tree *tree, FILE *out)
+{
+	const SearchStats *stats = &tree->stats;
+	unsigned long long nodes = total_nodes(tree);
+
+	fprintf(out, "info string nodes %llu main %llu quiescence %llu"
+	        " (%.1f%%) seldepth %d hashfull %d\n",
+	        nodes, tree->nodes, stats->qnodes,
+	        percent(stats->qnodes, nodes), stats->seldepth, tt_hashfull());
+	fprintf(out, "info string cutoffs %llu first move %.1f%%"
+	        " branching factor %.2f\n",
+	        stats->cutoffs,
+	        percent(stats->first_move_cutoffs, stats->cutoffs),
+	        stats_branching_factor(tree, stats->iterations));
+	fprintf(out, "info string evaluations %llu cached %.1f%%"
+	        " pawn hash %.1f%% lazy exits %llu %llu %llu"
+	        " cache full %d\n",
+	        stats->evals,
+	        percent(stats->ev_hits, stats->evals),
+	        percent(stats->pawn_hits, stats->evals - stats->ev_hits),
+	        stats->lazy_exits[EVAL_STAGE_PSQ],
+	        stats->lazy_exits[EVAL_STAGE_PAWNS],
+	        stats->lazy_exits[EVAL_STAGE_KING],
+	        ev_hashfull());
+}
+
+void
+stats_write_json(const Tree *tree, FILE *out)
+{
+	const SearchStats *stats = &tree->stats;
+	int depth;
+
+	fprintf(out, "{\"depth\":%d,\"seldepth\":%d,\"time\":%lld",
+	        stats->iterations, stats->seldepth, tc_elapsed(tree));
+	fprintf(out, ",\"nodes\":%llu,\"main_nodes\":%llu"
+	        ",\"quiescence_nodes\":%llu",
+	        total_nodes(tree), tree->nodes, stats->qnodes);
+	fprintf(out, ",\"cutoffs\":%llu,\"first_move_cutoffs\":%llu",
+	        stats->cutoffs, stats->first_move_cutoffs);
+	fprintf(out, ",\"evaluations\":%llu,\"eval_cache_hits\":%llu"
+	        ",\"pawn_hash_hits\":%llu,\"lazy_exits\":[%llu,%llu,%llu]",
+	        stats->evals, stats->ev_hits, stats->pawn_hits,
+	        stats->lazy_exits[EVAL_STAGE_PSQ],
+	        stats->lazy_exits[EVAL_STAGE_PAWNS],
+	        stats->lazy_exits[EVAL_STAGE_KING]);
+	fprintf(out, ",\"tt_probes\":%llu,\"tt_hits\":%llu,\"tb_hits\":%llu",
+	        stats->tt_probes, stats->tt_hits, stats->tb_hits);
+	fprintf(out, ",\"hashfull\":%d,\"eval_cache_full\":%d",
+	        tt_hashfull(), ev_hashfull());
+
+	fprintf(out, ",\"iterations\":[");
+	for (depth = 1; depth <= stats->iterations; ++depth) {
+		fprintf(out, "%s{\"depth\":%d,\"nodes\":%llu,\"time\":%lld"
+		        ",\"branching_factor\":%.3f}",
+		        depth > 1 ? "," : "", depth,
+		        stats->iteration_nodes[depth],
+		        stats->iteration_time[depth],
+		        stats_branching_factor(tree, depth));
+	}
+	fprintf(out, "]}\n");
+}
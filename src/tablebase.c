@@ -0,0 +1,707 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/* Endgame tables with up to four pieces.
+ *
+ * A table holds one byte for every position with a certain material,
+ * see TB_DRAW and friends in lisco.h.  The position is indexed by the
+ * side on move, the pair of king squares, and the squares of the other
+ * pieces.  The board is mirrored so that the white king is always on
+ * the files e to h.  Without pawns, it is also mirrored vertically and
+ * along the diagonal so that the white king ends up in the triangle
+ * e1-h1-e4, and the black king below the diagonal if the white king is
+ * on it.  Only legal king pairs are counted, 462 without pawns and 1806
+ * with pawns, and pawns only take the 48 squares of the ranks 2 to 7.
+ *
+ * The byte also gives the win, draw, or loss, and there is no separate
+ * table for that.  Even the largest tables with four pieces have only a
+ * few megabytes, and the search needs the distance to mate anyway.
+ *
+ * White is always the stronger side.  Positions where black is
+ * stronger are looked up with the colors swapped.  The tables are
+ * found by the material key of the position.  They are mapped into
+ * memory from files named after the material, for example
+ * "KRvKN.ltb":
+ *
+ *	magic		8 bytes "LISCOTB2"
+ *	name		16 bytes, padded with NUL bytes
+ *	size		uint32, number of positions
+ *	longest		uint32, longest distance to mate in plies
+ *	values		uint8[size]
+ *
+ * All numbers are little-endian.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <xalloc.h>
+
+#include <libchi.h>
+
+#include "lisco.h"
+
+#define TB_MAGIC "LISCOTB2"
+#define TB_HEADER_SIZE 32
+#define TB_SUFFIX ".ltb"
+
+/* At most that many tables can be registered.  */
+#define TB_MAX_TABLES 64
+
+/* Slots for the tables by material key, with room for both colors of
+ * every table.
+ */
+#define TB_SLOTS 256
+
+#define TRANSPOSE(square) ((((square) & 0x7) << 3) | ((square) >> 3))
+#define PIECE_SQUARES(piece) ((piece) == pawn ? 48 : 64)
+
+/* The legal pairs of king squares with pawns.  Without pawns, there
+ * are only 462.
+ */
+#define KING_PAIRS_PAWNS 1806
+
+typedef struct KingPairs {
+	int num_pairs;
+	/* Index of the pair or -1.  */
+	short index[64][64];
+	unsigned char squares[KING_PAIRS_PAWNS][2];
+} KingPairs;
+
+/* A table for the material key KEY, with the colors swapped if FLIP is
+ * set.
+ */
+typedef struct TBSlot {
+	bitv64 key;
+	Tablebase *tb;
+	int flip;
+} TBSlot;
+
+static const chi_piece_t name_order[] = {
+	queen, rook, bishop, knight, pawn
+};
+
+static const char piece_letters[] = " PNBRQK";
+
+static Tablebase *tablebases[TB_MAX_TABLES];
+static int num_tablebases;
+static int max_pieces;
+static TBSlot slots[TB_SLOTS];
+static KingPairs king_pairs[2];
+
+static bitv64
+piece_mask(const chi_pos *pos, chi_color_t color, chi_piece_t piece)
+{
+	bitv64 bishops = color == chi_white ? pos->w_bishops : pos->b_bishops;
+	bitv64 rooks = color == chi_white ? pos->w_rooks : pos->b_rooks;
+
+	switch (piece) {
+		case pawn:
+			return color == chi_white ? pos->w_pawns : pos->b_pawns;
+		case knight:
+			return color == chi_white ? pos->w_knights : pos->b_knights;
+		case bishop:
+			return bishops & ~rooks;
+		case rook:
+			return rooks & ~bishops;
+		case queen:
+			return bishops & rooks;
+		case king:
+			return color == chi_white ? pos->w_kings : pos->b_kings;
+		default:
+			return 0;
+	}
+}
+
+static char *
+side_name(char *ptr, const int *counts)
+{
+	int i, n;
+
+	*ptr++ = 'K';
+	for (i = 0; i < sizeof name_order / sizeof name_order[0]; ++i) {
+		for (n = counts[name_order[i]]; n > 0; --n)
+			*ptr++ = piece_letters[name_order[i]];
+	}
+	*ptr = '\0';
+
+	return ptr;
+}
+
+/* Positive if the side with COUNTS is stronger than the side with
+ * OTHER, that is it has more pieces or more valuable ones.
+ */
+static int
+compare_sides(const int *counts, const int *other)
+{
+	int difference = 0;
+	int i;
+
+	for (i = pawn; i < king; ++i)
+		difference += counts[i] - other[i];
+	if (difference)
+		return difference;
+
+	for (i = 0; i < sizeof name_order / sizeof name_order[0]; ++i) {
+		if (counts[name_order[i]] != other[name_order[i]])
+			return counts[name_order[i]] - other[name_order[i]];
+	}
+
+	return 0;
+}
+
+/* Write the name of the material COUNTS to NAME, which must have room
+ * for the name of a table.  Returns non-zero if black is the stronger
+ * side and the colors must be swapped.
+ */
+static int
+material_name(int counts[2][king + 1], char *name)
+{
+	int flip = compare_sides(counts[chi_black], counts[chi_white]) > 0;
+	char *ptr = side_name(name, counts[flip]);
+
+	*ptr++ = 'v';
+	side_name(ptr, counts[!flip]);
+
+	return flip;
+}
+
+/* Non-zero if the white king may stand on WHITE and the black king on
+ * BLACK after mirroring.
+ */
+static int
+is_king_pair(int pawns, int white, int black)
+{
+	int file = white & 0x7, rank = white >> 3;
+	int file_distance = file - (black & 0x7);
+	int rank_distance = rank - (black >> 3);
+
+	if (file_distance >= -1 && file_distance <= 1
+	    && rank_distance >= -1 && rank_distance <= 1)
+		return 0;
+
+	if (pawns)
+		return file < 4;
+
+	if (file > rank || rank >= 4)
+		return 0;
+
+	return file < rank || (black & 0x7) <= (black >> 3);
+}
+
+static void
+init_king_pairs(void)
+{
+	int pawns, white, black;
+
+	if (king_pairs[0].num_pairs)
+		return;
+
+	for (pawns = 0; pawns <= 1; ++pawns) {
+		KingPairs *pairs = king_pairs + pawns;
+
+		for (white = 0; white < 64; ++white) {
+			for (black = 0; black < 64; ++black) {
+				if (!is_king_pair(pawns, white, black)) {
+					pairs->index[white][black] = -1;
+					continue;
+				}
+				pairs->index[white][black] = pairs->num_pairs;
+				pairs->squares[pairs->num_pairs][0] = white;
+				pairs->squares[pairs->num_pairs][1] = black;
+				++pairs->num_pairs;
+			}
+		}
+	}
+}
+
+int
+tb_parse_name(Tablebase *tb, const char *name)
+{
+	int counts[2][king + 1];
+	chi_color_t color = chi_white;
+	chi_piece_t piece;
+	int flip, total = 0;
+	int i, n;
+
+	memset(counts, 0, sizeof counts);
+
+	for (; *name; ++name) {
+		if (*name == 'v' && color == chi_white) {
+			color = chi_black;
+			continue;
+		}
+		for (piece = pawn; piece <= king; ++piece) {
+			if (*name == piece_letters[piece])
+				break;
+		}
+		if (piece > king)
+			return -1;
+		if (++total > TB_MAX_PIECES)
+			return -1;
+		++counts[color][piece];
+	}
+
+	if (counts[chi_white][king] != 1 || counts[chi_black][king] != 1
+	    || total < 3)
+		return -1;
+
+	memset(tb, 0, sizeof *tb);
+	flip = material_name(counts, tb->name);
+
+	for (color = chi_white; color <= chi_black; ++color) {
+		for (i = 0; i < sizeof name_order / sizeof name_order[0]; ++i) {
+			piece = name_order[i];
+			for (n = counts[color ^ flip][piece]; n > 0; --n) {
+				tb->pieces[tb->num_pieces] = piece;
+				tb->colors[tb->num_pieces] = color;
+				++tb->num_pieces;
+				if (piece == pawn)
+					tb->pawns = 1;
+			}
+		}
+	}
+
+	init_king_pairs();
+	tb->size = 2 * king_pairs[tb->pawns].num_pairs;
+	for (i = 0; i < tb->num_pieces; ++i)
+		tb->size *= PIECE_SQUARES(tb->pieces[i]);
+
+	return 0;
+}
+
+unsigned long
+tb_index(const Tablebase *tb, chi_color_t on_move, const int *squares)
+{
+	int white = squares[0];
+	int black = squares[1];
+	int mirror = 0;
+	int transpose = 0;
+	unsigned long index;
+	int i;
+
+	if ((white & 0x7) >= 4)
+		mirror = 0x7;
+	if (!tb->pawns && (white >> 3) >= 4)
+		mirror |= 0x38;
+	white ^= mirror;
+	black ^= mirror;
+	if (!tb->pawns
+	    && ((white & 0x7) > (white >> 3)
+	        || ((white & 0x7) == (white >> 3)
+	            && (black & 0x7) > (black >> 3)))) {
+		transpose = 1;
+		white = TRANSPOSE(white);
+		black = TRANSPOSE(black);
+	}
+
+	index = on_move * king_pairs[tb->pawns].num_pairs
+		+ king_pairs[tb->pawns].index[white][black];
+	for (i = 0; i < tb->num_pieces; ++i) {
+		int square = squares[i + 2] ^ mirror;
+
+		if (transpose)
+			square = TRANSPOSE(square);
+		if (tb->pieces[i] == pawn)
+			index = index * 48 + square - 8;
+		else
+			index = index * 64 + square;
+	}
+
+	return index;
+}
+
+int
+tb_position(const Tablebase *tb, unsigned long index, chi_pos *pos)
+{
+	const KingPairs *pairs = king_pairs + tb->pawns;
+	int squares[TB_MAX_PIECES];
+	bitv64 occupied = 0;
+	chi_color_t on_move;
+	int pair;
+	int in_check;
+	int i;
+
+	for (i = tb->num_pieces - 1; i >= 0; --i) {
+		if (tb->pieces[i] == pawn) {
+			squares[i + 2] = index % 48 + 8;
+			index /= 48;
+		} else {
+			squares[i + 2] = index & 0x3f;
+			index >>= 6;
+		}
+	}
+	pair = index % pairs->num_pairs;
+	on_move = index / pairs->num_pairs;
+	squares[0] = pairs->squares[pair][0];
+	squares[1] = pairs->squares[pair][1];
+
+	for (i = 0; i < tb->num_pieces + 2; ++i) {
+		bitv64 mask = ((bitv64) 1) << squares[i];
+
+		if (occupied & mask)
+			return -1;
+		occupied |= mask;
+	}
+
+	chi_clear_position(pos);
+	chi_on_move(pos) = on_move;
+	/* Like after chi_set_position(), so that moves can be undone.  */
+	pos->irreversible_count = 1;
+	pos->w_kings = ((bitv64) 1) << squares[0];
+	pos->b_kings = ((bitv64) 1) << squares[1];
+
+	for (i = 0; i < tb->num_pieces; ++i) {
+		int square = squares[i + 2];
+		bitv64 mask = ((bitv64) 1) << square;
+		int white = tb->colors[i] == chi_white;
+
+		switch (tb->pieces[i]) {
+			case pawn:
+				if (white)
+					pos->w_pawns |= mask;
+				else
+					pos->b_pawns |= mask;
+				break;
+			case knight:
+				if (white)
+					pos->w_knights |= mask;
+				else
+					pos->b_knights |= mask;
+				break;
+			case queen:
+				if (white)
+					pos->w_rooks |= mask;
+				else
+					pos->b_rooks |= mask;
+				/* FALLTHROUGH */
+			case bishop:
+				if (white)
+					pos->w_bishops |= mask;
+				else
+					pos->b_bishops |= mask;
+				break;
+			case rook:
+				if (white)
+					pos->w_rooks |= mask;
+				else
+					pos->b_rooks |= mask;
+				break;
+			default:
+				break;
+		}
+	}
+
+	pos->w_pieces = pos->w_pawns | pos->w_knights | pos->w_bishops
+		| pos->w_rooks | pos->w_kings;
+	pos->b_pieces = pos->b_pawns | pos->b_knights | pos->b_bishops
+		| pos->b_rooks | pos->b_kings;
+	chi_update_material(pos);
+	chi_update_psq(pos);
+
+	/* The side that has just moved must not be in check.  */
+	chi_on_move(pos) = !on_move;
+	in_check = chi_check_check(pos);
+	chi_on_move(pos) = on_move;
+
+	return in_check ? -1 : 0;
+}
+
+/* Index of POS in TB.  If FLIP is set, the colors of POS are swapped.  */
+static unsigned long
+pos_index(const Tablebase *tb, const chi_pos *pos, int flip)
+{
+	int squares[TB_MAX_PIECES];
+	int mirror = flip ? 0x38 : 0;
+	bitv64 used = 0;
+	int i;
+
+	squares[0] = chi_bitv2shift(piece_mask(pos, flip, king)) ^ mirror;
+	squares[1] = chi_bitv2shift(piece_mask(pos, !flip, king)) ^ mirror;
+
+	/* Of two equal pieces, the first one takes the lower square.  */
+	for (i = 0; i < tb->num_pieces; ++i) {
+		bitv64 mask = piece_mask(pos, tb->colors[i] ^ flip, tb->pieces[i])
+			& ~used;
+
+		mask = chi_clear_but_least_set(mask);
+		used |= mask;
+		squares[i + 2] = chi_bitv2shift(mask) ^ mirror;
+	}
+
+	return tb_index(tb, chi_on_move(pos) ^ flip, squares);
+}
+
+unsigned long
+tb_pos_index(const Tablebase *tb, const chi_pos *pos)
+{
+	return pos_index(tb, pos, 0);
+}
+
+static TBSlot *
+find_slot(bitv64 key)
+{
+	unsigned int i = (key ^ (key >> 20)) % TB_SLOTS;
+
+	while (slots[i].tb && slots[i].key != key)
+		i = (i + 1) % TB_SLOTS;
+
+	return slots + i;
+}
+
+int
+tb_lookup(const chi_pos *pos)
+{
+	bitv64 key = chi_material_key(pos);
+	const TBSlot *slot;
+
+	/* Only the kings are left.  */
+	if (!key)
+		return TB_DRAW;
+
+	slot = find_slot(key);
+	if (!slot->tb)
+		return -1;
+
+	return slot->tb->values[pos_index(slot->tb, pos, slot->flip)];
+}
+
+int
+tb_probe(const chi_pos *pos, int ply, int *score)
+{
+	int value;
+
+	if (!max_pieces
+	    || chi_popcount(pos->w_pieces | pos->b_pieces) > max_pieces)
+		return 0;
+
+	if (chi_ep(pos) || chi_wk_castle(pos) || chi_wq_castle(pos)
+	    || chi_bk_castle(pos) || chi_bq_castle(pos))
+		return 0;
+
+	value = tb_lookup(pos);
+	if (value < 0 || value == TB_ILLEGAL)
+		return 0;
+
+	if (TB_IS_WIN(value))
+		*score = -MATE - ply - TB_PLIES(value);
+	else if (TB_IS_LOSS(value))
+		*score = MATE + ply + TB_PLIES(value);
+	else
+		*score = 0;
+
+	return 1;
+}
+
+void
+tb_register(Tablebase *tb)
+{
+	int i, flip;
+
+	for (i = 0; i < num_tablebases; ++i) {
+		if (strcmp(tablebases[i]->name, tb->name) == 0)
+			break;
+	}
+	if (i == TB_MAX_TABLES)
+		return;
+	if (i == num_tablebases)
+		++num_tablebases;
+	tablebases[i] = tb;
+
+	for (flip = 0; flip <= 1; ++flip) {
+		bitv64 key = 0;
+		TBSlot *slot;
+
+		for (i = 0; i < tb->num_pieces; ++i)
+			key += ((bitv64) 1)
+				<< CHI_MATERIAL_SHIFT(tb->colors[i] ^ flip,
+				                      tb->pieces[i]);
+		slot = find_slot(key);
+		if (!slot->tb || slot->flip == flip) {
+			slot->key = key;
+			slot->tb = tb;
+			slot->flip = flip;
+		}
+	}
+
+	if (tb->num_pieces + 2 > max_pieces)
+		max_pieces = tb->num_pieces + 2;
+}
+
+void
+tb_clear(void)
+{
+	int i;
+
+	for (i = 0; i < num_tablebases; ++i) {
+		if (tablebases[i]->map) {
+			munmap(tablebases[i]->map, tablebases[i]->map_size);
+			free(tablebases[i]);
+		}
+	}
+
+	num_tablebases = 0;
+	max_pieces = 0;
+	memset(slots, 0, sizeof slots);
+}
+
+static unsigned int
+read_u32(const unsigned char *bytes)
+{
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16)
+		| ((unsigned int) bytes[3] << 24);
+}
+
+static void
+write_u32(unsigned char *bytes, unsigned int value)
+{
+	bytes[0] = value;
+	bytes[1] = value >> 8;
+	bytes[2] = value >> 16;
+	bytes[3] = value >> 24;
+}
+
+int
+tb_load(const char *filename)
+{
+	struct stat st;
+	unsigned char *map;
+	char name[sizeof tablebases[0]->name + 1];
+	Tablebase tb;
+	int fd;
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return -1;
+	}
+
+	if (st.st_size < TB_HEADER_SIZE) {
+		close(fd);
+		errno = EINVAL;
+		return -1;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return -1;
+
+	memcpy(name, map + 8, sizeof name - 1);
+	name[sizeof name - 1] = '\0';
+
+	if (memcmp(map, TB_MAGIC, 8) != 0
+	    || tb_parse_name(&tb, name) != 0
+	    || strcmp(tb.name, name) != 0
+	    || read_u32(map + 24) != tb.size
+	    || st.st_size != TB_HEADER_SIZE + tb.size) {
+		munmap(map, st.st_size);
+		errno = EINVAL;
+		return -1;
+	}
+
+	tb.longest = read_u32(map + 28);
+	tb.values = map + TB_HEADER_SIZE;
+	tb.map = map;
+	tb.map_size = st.st_size;
+
+	tb_register(xmemdup(&tb, sizeof tb));
+
+	return 0;
+}
+
+int
+tb_init(const char *directory)
+{
+	DIR *dir;
+	struct dirent *entry;
+	size_t suffix_length = strlen(TB_SUFFIX);
+	int count = 0;
+
+	tb_clear();
+
+	dir = opendir(directory);
+	if (!dir)
+		return -1;
+
+	while ((entry = readdir(dir))) {
+		size_t length = strlen(entry->d_name);
+		char *path;
+
+		if (length <= suffix_length
+		    || strcmp(entry->d_name + length - suffix_length,
+		              TB_SUFFIX) != 0)
+			continue;
+
+		path = xmalloc(strlen(directory) + length + 2);
+		sprintf(path, "%s/%s", directory, entry->d_name);
+		if (tb_load(path) == 0)
+			++count;
+		free(path);
+	}
+
+	closedir(dir);
+
+	return count;
+}
+
+int
+tb_write(const Tablebase *tb, const char *filename)
+{
+	unsigned char header[TB_HEADER_SIZE];
+	FILE *file;
+	int errnum;
+
+	memset(header, 0, sizeof header);
+	memcpy(header, TB_MAGIC, 8);
+	strncpy((char *) header + 8, tb->name, 16);
+	write_u32(header + 24, tb->size);
+	write_u32(header + 28, tb->longest);
+
+	file = fopen(filename, "wb");
+	if (!file)
+		return -1;
+
+	if (fwrite(header, 1, sizeof header, file) != sizeof header
+	    || fwrite(tb->values, 1, tb->size, file) != tb->size) {
+		errnum = errno;
+		fclose(file);
+		errno = errnum;
+		return -1;
+	}
+
+	return fclose(file);
+}
+
+int
+tb_max_pieces(void)
+{
+	return max_pieces;
+}
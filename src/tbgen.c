@@ -0,0 +1,266 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/* Generation of the endgame tables by retrograde analysis.
+ *
+ * The table is filled in passes.  The first pass marks the illegal
+ * positions and the ones where the side on move is mated.  Pass N then
+ * finds all positions with a distance to mate of exactly N plies: for
+ * odd N, the side on move has a move into a position that is lost in
+ * N - 1 plies, for even N, all moves lead into positions that are won,
+ * and the longest of these wins takes N - 1 plies.  Captures and
+ * promotions lead into smaller tables that have been generated before.
+ * Once no more positions are found, the rest are draws.
+ *
+ * Every pass only reads values that have been found in earlier passes,
+ * so the positions can be distributed over several threads that write
+ * into the same table.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include <error.h>
+#include <xalloc.h>
+
+#include <libchi.h>
+
+#include "lisco.h"
+
+/* Threads fetch that many positions at once.  */
+#define TB_CHUNK_SIZE 4096
+
+typedef struct TBJob {
+	Tablebase *tb;
+	int pass;
+	unsigned long next;
+	unsigned long found;
+	/* Longest distance to mate in the smaller tables that is reached.  */
+	int reach;
+} TBJob;
+
+static int child_value(const Tablebase *tb, chi_pos *pos, chi_move move,
+                       int *reach);
+
+/* Value of POS right after a pawn double step.  The tables have no
+ * en passant rights, so if the pawn can be captured en passant, the
+ * value is taken from the moves of POS instead.
+ */
+static int
+ep_value(const Tablebase *tb, chi_pos *pos, int *reach)
+{
+	chi_move moves[CHI_MAX_MOVES];
+	chi_move *end = chi_legal_moves(pos, moves);
+	chi_move *move;
+	int shortest_win = -1;
+	int longest_loss = -1;
+	int draw = 0;
+
+	for (move = moves; move < end; ++move) {
+		if (chi_move_is_ep(*move))
+			break;
+	}
+	if (move == end)
+		return __atomic_load_n(tb->values + tb_pos_index(tb, pos),
+		                       __ATOMIC_RELAXED);
+
+	for (move = moves; move < end; ++move) {
+		int value = child_value(tb, pos, *move, reach);
+
+		if (TB_IS_LOSS(value)) {
+			if (shortest_win < 0 || TB_PLIES(value) < shortest_win)
+				shortest_win = TB_PLIES(value);
+		} else if (TB_IS_WIN(value)) {
+			if (TB_PLIES(value) > longest_loss)
+				longest_loss = TB_PLIES(value);
+		} else {
+			draw = 1;
+		}
+	}
+
+	/* One ply more than the best move.  */
+	if (shortest_win >= 0)
+		return (shortest_win + 2) >> 1;
+	if (!draw)
+		return TB_LOSS + ((longest_loss + 1) >> 1);
+
+	return TB_DRAW;
+}
+
+/* Value of the position after MOVE from the point of view of the side
+ * on move then.  REACH is updated for wins and losses in other tables.
+ */
+static int
+child_value(const Tablebase *tb, chi_pos *pos, chi_move move, int *reach)
+{
+	int value;
+
+	chi_apply_move(pos, move);
+	if (chi_move_victim(move) || chi_move_promote(move)) {
+		value = tb_lookup(pos);
+		if (value < 0)
+			error(EXIT_FAILURE, 0,
+			      "%s: table for a capture or promotion is missing",
+			      tb->name);
+		if (value != TB_DRAW && TB_PLIES(value) > *reach)
+			*reach = TB_PLIES(value);
+	} else if (chi_ep(pos)) {
+		value = ep_value(tb, pos, reach);
+	} else {
+		value = __atomic_load_n(tb->values + tb_pos_index(tb, pos),
+		                        __ATOMIC_RELAXED);
+	}
+	chi_unapply_move(pos, move);
+
+	return value;
+}
+
+/* Value of the undecided position POS in pass PASS, or TB_DRAW if it is
+ * still undecided.
+ */
+static int
+resolve(const Tablebase *tb, chi_pos *pos, int pass, int *reach)
+{
+	chi_move moves[CHI_MAX_MOVES];
+	chi_move *end = chi_legal_moves(pos, moves);
+	chi_move *move;
+	int longest = -1;
+
+	if (end == moves) {
+		/* Stalemate remains a draw.  */
+		return pass == 0 && chi_check_check(pos) ? TB_LOSS : TB_DRAW;
+	}
+
+	if (pass == 0)
+		return TB_DRAW;
+
+	for (move = moves; move < end; ++move) {
+		int value = child_value(tb, pos, *move, reach);
+
+		if (pass & 1) {
+			if (TB_IS_LOSS(value) && TB_PLIES(value) == pass - 1)
+				return (pass + 1) >> 1;
+		} else {
+			if (!TB_IS_WIN(value))
+				return TB_DRAW;
+			if (TB_PLIES(value) > longest)
+				longest = TB_PLIES(value);
+		}
+	}
+
+	if (!(pass & 1) && longest == pass - 1)
+		return TB_LOSS + (pass >> 1);
+
+	return TB_DRAW;
+}
+
+static void *
+generate_chunks(void *arg)
+{
+	TBJob *job = arg;
+	Tablebase *tb = job->tb;
+	unsigned long found = 0;
+	unsigned long index, start, end;
+	int reach = -1, old_reach;
+	chi_pos pos;
+
+	for (;;) {
+		start = __atomic_fetch_add(&job->next, TB_CHUNK_SIZE,
+		                           __ATOMIC_RELAXED);
+		if (start >= tb->size)
+			break;
+		end = start + TB_CHUNK_SIZE < tb->size
+			? start + TB_CHUNK_SIZE : tb->size;
+
+		for (index = start; index < end; ++index) {
+			int value;
+
+			if (__atomic_load_n(tb->values + index, __ATOMIC_RELAXED)
+			    != TB_DRAW)
+				continue;
+
+			if (tb_position(tb, index, &pos) != 0) {
+				value = TB_ILLEGAL;
+			} else {
+				value = resolve(tb, &pos, job->pass, &reach);
+				if (value == TB_DRAW)
+					continue;
+				++found;
+			}
+
+			__atomic_store_n(tb->values + index, value,
+			                 __ATOMIC_RELAXED);
+		}
+	}
+
+	__atomic_fetch_add(&job->found, found, __ATOMIC_RELAXED);
+	old_reach = __atomic_load_n(&job->reach, __ATOMIC_RELAXED);
+	while (reach > old_reach
+	       && !__atomic_compare_exchange_n(&job->reach, &old_reach, reach, 0,
+	                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		continue;
+
+	return NULL;
+}
+
+/* Run pass PASS over TB and return the number of decided positions.  */
+static unsigned long
+generate_pass(Tablebase *tb, int pass, int threads, int *reach)
+{
+	pthread_t *workers = xmalloc(threads * sizeof *workers);
+	TBJob job = { tb, pass, 0, 0, -1 };
+	int i, errnum;
+
+	for (i = 0; i < threads; ++i) {
+		errnum = pthread_create(workers + i, NULL, generate_chunks, &job);
+		if (errnum)
+			error(EXIT_FAILURE, errnum, "cannot create thread");
+	}
+
+	for (i = 0; i < threads; ++i)
+		pthread_join(workers[i], NULL);
+
+	free(workers);
+
+	if (job.reach > *reach)
+		*reach = job.reach;
+
+	return job.found;
+}
+
+void
+tb_generate(Tablebase *tb, int threads)
+{
+	int pass, last = 0, reach = -1;
+
+	tb->values = xzalloc(tb->size);
+
+	/* After the second pass, all moves of the undecided positions into
+	 * the smaller tables have been seen.  Their wins and losses still
+	 * decide positions one ply later.
+	 */
+	for (pass = 0; pass <= last + 1 || pass <= reach + 1; ++pass) {
+		if (generate_pass(tb, pass, threads, &reach))
+			last = pass;
+	}
+
+	tb->longest = last;
+}
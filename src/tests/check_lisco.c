@@ -26,7 +26,14 @@
 
 #include "../lisco.h"
 
+extern Suite *analyze_suite();
+extern Suite *endgame_suite();
+extern Suite *evaluate_suite();
+extern Suite *material_suite();
 extern Suite *move_selector_suite();
+extern Suite *nnue_suite();
+extern Suite *statistics_suite();
+extern Suite *tablebase_suite();
 extern Suite *time_control_suite();
 extern Suite *tt_suite();
 extern Suite *uci_engine_suite();
@@ -47,7 +54,14 @@ main(int argc, char *argv[])
 
 	lisco_initialize(argv[0]);
 
-	runner = srunner_create(move_selector_suite());
+	runner = srunner_create(evaluate_suite());
+	srunner_add_suite(runner, analyze_suite());
+	srunner_add_suite(runner, endgame_suite());
+	srunner_add_suite(runner, material_suite());
+	srunner_add_suite(runner, move_selector_suite());
+	srunner_add_suite(runner, nnue_suite());
+	srunner_add_suite(runner, statistics_suite());
+	srunner_add_suite(runner, tablebase_suite());
 	srunner_add_suite(runner, time_control_suite());
 	srunner_add_suite(runner, tt_suite());
 	srunner_add_suite(runner, uci_engine_suite());
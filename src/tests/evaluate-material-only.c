@@ -31,7 +31,7 @@ evaluate_material_only(Tree *tree, int ply, int alpha, int beta)
 {
 	chi_pos* pos = &tree->position;
 
-	++tree->evals;
+	++tree->stats.evals;
 
 	int score = 100 * chi_material(pos);
 
@@ -3,56 +3,40 @@
 use strict;
 
 use Test::More;
-use IPC::Open2;
+use JSON::PP;
 
-my ($epdfile, @commands) = @ARGV;
+my ($epdfile, @options) = @ARGV;
 
 if (!defined $epdfile || !length $epdfile) {
-	die "Usage: $@ EPDFILE[, COMMANDS...]"
+	die "Usage: $0 EPDFILE [OPTIONS...]"
 }
 
 # Find lisco executable.
-my $lisco = "../liscoold";
-$lisco = "../liscoold.exe" unless -e $lisco;
+my $lisco = "../lisco";
+$lisco = "../lisco.exe" unless -e $lisco;
 
-open STDERR, ">&STDOUT";
-
-push @commands, "epdfile $epdfile", "quit";
-
-my ($cout, $cin);
-my $pid = open2 $cout, $cin, $lisco
+open my $cout, '-|', $lisco, 'analyze', @options, $epdfile
 	or die "cannot exec '$lisco': $!";
 
-foreach my $cmd (@commands) {
-	$cin->print("$cmd\n");
-}
-
-my $header_seen;
+my $results = 0;
 my $failures = 0;
-while (1) {
-	my $line = $cout->getline;
-	last if !defined $line;
-
-	print STDERR "$line";
-	if (!$header_seen) {
-		if ($line =~ /^ *\| *Solution *\| *Refuted *\| *R *\| *Name *\| *\n$/) {
-			$header_seen = 1;
-		}
-	} else {
-		if ($line =~ /^ *\| *([0-9]+) *\| *([0-9.]+) *\| *([0-9]+) *\| *([0-9.]+) *\| *(X|-) *\| *(.+?) *\| *\n$/) {
-			my ($sdepth, $stime, $rdepth, $rtime, $solved, $name) =
-				($1, $2, $3, $4, $5, $6);
-			ok 'X' eq $solved, $name;
-			++$failures if 'X' ne $solved;
-		}
-	}
+while (my $line = $cout->getline) {
+	print STDERR $line;
+
+	my $result = decode_json $line;
+	next if !exists $result->{bm} && !exists $result->{am};
+
+	my $name = $result->{id} // "line $result->{index}";
+	ok $result->{solved}, $name;
+	++$results;
+	++$failures if !$result->{solved};
 }
 
-waitpid $pid, 0;
+close $cout;
 ok !$?;
 
 done_testing;
 
-my $success = $header_seen && $failures == 0;
+my $success = $results && $failures == 0;
 
 exit !$success;
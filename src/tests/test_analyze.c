@@ -0,0 +1,107 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include <check.h>
+
+#include "libchi.h"
+#include "../lisco.h"
+
+/* Return the result line for position INDEX in OUTPUT.  */
+static const char *
+find_result(const char *output, int index)
+{
+	char prefix[32];
+	const char *line;
+
+	sprintf(prefix, "{\"index\":%d,", index);
+	line = strstr(output, prefix);
+	if (line && line != output && line[-1] != '\n')
+		return NULL;
+
+	return line;
+}
+
+START_TEST(test_analyze)
+{
+	static char input[] =
+		"# A comment.\n"
+		"6k1/5ppp/8/8/8/8/8/R5K1 w - - bm Ra8; id \"back rank\";\n"
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1\n"
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - acd 1;\n"
+		"this is not chess\n";
+	static char output[8192];
+	SearchParams limits;
+	const char *line;
+	FILE *in, *out;
+
+	memset(&limits, 0, sizeof limits);
+	limits.depth = 3;
+
+	in = fmemopen(input, strlen(input), "r");
+	ck_assert_ptr_nonnull(in);
+	out = fmemopen(output, sizeof output - 1, "w");
+	ck_assert_ptr_nonnull(out);
+	ck_assert_int_eq(analyze(in, out, &limits, 2), 0);
+	fclose(out);
+	fclose(in);
+
+	ck_assert_ptr_null(find_result(output, 1));
+
+	line = find_result(output, 2);
+	ck_assert_ptr_nonnull(line);
+	ck_assert_ptr_nonnull(strstr(line, "\"id\":\"back rank\""));
+	ck_assert_ptr_nonnull(strstr(line, "\"bestmove\":\"a1a8\""));
+	ck_assert_ptr_nonnull(strstr(line, "\"bm\":\"a1a8\",\"solved\":true,"
+	                                   "\"solve_depth\":1,"));
+
+	line = find_result(output, 3);
+	ck_assert_ptr_nonnull(line);
+	ck_assert_ptr_nonnull(strstr(line, "\"depth\":3,"));
+	ck_assert_ptr_null(strstr(line, "\"solved\""));
+
+	line = find_result(output, 4);
+	ck_assert_ptr_nonnull(line);
+	ck_assert_ptr_nonnull(strstr(line, "\"depth\":1,"));
+
+	line = find_result(output, 5);
+	ck_assert_ptr_nonnull(line);
+	ck_assert(strncmp(strstr(line, ","), ",\"error\":", 9) == 0);
+}
+END_TEST
+
+Suite *
+analyze_suite(void)
+{
+	Suite *suite;
+	TCase *tc_analyze;
+
+	suite = suite_create("Batch Analysis");
+
+	tc_analyze = tcase_create("Analyze");
+	tcase_add_test(tc_analyze, test_analyze);
+	suite_add_tcase(suite, tc_analyze);
+
+	return suite;
+}
@@ -0,0 +1,110 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <check.h>
+
+#include "lisco.h"
+
+static int
+recognize_fen(const char *fen, int *score)
+{
+	chi_pos pos;
+
+	ck_assert_int_eq(chi_set_position(&pos, fen), 0);
+
+	return recognize_endgame(&pos, score);
+}
+
+START_TEST(test_endgame_kpk)
+{
+	int score;
+
+	ck_assert_int_eq(recognize_fen("4k3/8/4K3/4P3/8/8/8/8 w - - 0 1", &score),
+	                 ENDGAME_EXACT);
+	ck_assert_int_ge(score, KNOWN_WIN);
+
+	/* The same from the other side.  */
+	ck_assert_int_eq(recognize_fen("4k3/8/4K3/4P3/8/8/8/8 b - - 0 1", &score),
+	                 ENDGAME_EXACT);
+	ck_assert_int_le(score, -KNOWN_WIN);
+
+	ck_assert_int_eq(recognize_fen("8/8/8/8/8/4k3/4P3/4K3 w - - 0 1", &score),
+	                 ENDGAME_EXACT);
+	ck_assert_int_eq(score, 0);
+}
+END_TEST
+
+START_TEST(test_endgame_mates)
+{
+	int score, closer;
+
+	ck_assert_int_eq(recognize_fen("8/8/8/8/8/2k5/8/KBN5 w - - 0 1", &score),
+	                 ENDGAME_SCALED);
+	ck_assert_int_ge(score, KNOWN_WIN);
+
+	/* A king closer to the right corner is worse for the defender.  */
+	ck_assert_int_eq(recognize_fen("8/8/8/8/8/3K4/1k6/5BN1 b - - 0 1", &score),
+	                 ENDGAME_SCALED);
+	ck_assert_int_eq(recognize_fen("8/8/8/8/8/3K4/1k6/5NB1 b - - 0 1",
+	                               &closer),
+	                 ENDGAME_SCALED);
+	ck_assert_int_gt(score, closer);
+
+	ck_assert_int_eq(recognize_fen("8/8/8/8/8/2k5/8/K6R b - - 0 1", &score),
+	                 ENDGAME_SCALED);
+	ck_assert_int_le(score, -KNOWN_WIN);
+
+	ck_assert_int_eq(recognize_fen("8/8/8/8/8/2k5/8/K5NN w - - 0 1", &score),
+	                 ENDGAME_EXACT);
+	ck_assert_int_eq(score, 0);
+}
+END_TEST
+
+START_TEST(test_endgame_unknown)
+{
+	int score;
+
+	ck_assert_int_eq(recognize_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP"
+	                               "/RNBQKBNR w KQkq - 0 1", &score),
+	                 ENDGAME_UNKNOWN);
+	ck_assert_int_eq(recognize_fen("8/8/8/8/8/2k5/2p5/K6R w - - 0 1",
+	                               &score),
+	                 ENDGAME_UNKNOWN);
+}
+END_TEST
+
+Suite *
+endgame_suite(void)
+{
+	Suite *suite;
+	TCase *tc_basic;
+
+	suite = suite_create("Endgame Recognizers");
+
+	tc_basic = tcase_create("Basic functions");
+	tcase_add_test(tc_basic, test_endgame_kpk);
+	tcase_add_test(tc_basic, test_endgame_mates);
+	tcase_add_test(tc_basic, test_endgame_unknown);
+	suite_add_tcase(suite, tc_basic);
+
+	return suite;
+}
@@ -0,0 +1,152 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <ctype.h>
+#include <string.h>
+
+#include <check.h>
+
+#include "lisco.h"
+
+/* Mirror a position given in FEN, so that white becomes black and vice
+ * versa.
+ */
+static void
+mirror_fen(const char *fen, char *mirrored)
+{
+	char board[8][16];
+	char side[2], castling[5], ep[3];
+	int half_moves, full_moves;
+	int rank = 0, i;
+	const char *ptr = fen;
+	char *out = mirrored;
+
+	memset(board, 0, sizeof board);
+	for (i = 0; *ptr != ' '; ++ptr) {
+		if (*ptr == '/') {
+			++rank;
+			i = 0;
+		} else {
+			board[rank][i++] = isupper(*ptr) ? tolower(*ptr) : toupper(*ptr);
+		}
+	}
+	ck_assert_int_eq(sscanf(ptr, " %1s %4s %2s %d %d",
+	                        side, castling, ep, &half_moves, &full_moves),
+	                 5);
+
+	for (rank = 7; rank >= 0; --rank) {
+		out += sprintf(out, "%s%s", board[rank], rank ? "/" : "");
+	}
+
+	for (i = 0; castling[i]; ++i) {
+		if (castling[i] != '-')
+			castling[i] = isupper(castling[i])
+				? tolower(castling[i]) : toupper(castling[i]);
+	}
+	if (ep[0] != '-')
+		ep[1] = ep[1] == '3' ? '6' : '3';
+
+	sprintf(out, " %c %s %s %d %d", side[0] == 'w' ? 'b' : 'w',
+	        castling, ep, half_moves, full_moves);
+}
+
+static int
+evaluate_fen(const char *fen)
+{
+	Tree tree;
+
+	memset(&tree, 0, sizeof tree);
+	ck_assert_int_eq(chi_set_position(&tree.position, fen), 0);
+	tree.signatures[0] = chi_zk_signature(lisco.zk_handle, &tree.position);
+	tree.pawn_signatures[0] = chi_zk_pawn_signature(lisco.zk_handle,
+		&tree.position);
+
+	return evaluate(&tree, 0, -INF, +INF);
+}
+
+START_TEST(test_evaluate_symmetry)
+{
+	static const char *fens[] = {
+		"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1",
+		"r1bqk2r/pppp1ppp/2n2n2/2b1p3/2B1P3/3P1N2/PPP2PPP/RNBQK2R w KQkq - 0 5",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"2kr3r/ppq2ppp/2n1b3/3pP3/3P4/P1PB1N2/5PPP/R2Q1RK1 b - - 3 16",
+		/* King walked, queen out early.  */
+		"r1bqk2r/pppp1ppp/2n2n2/2b1p3/2B1P3/2NQBN2/PPPPKPPP/R6R b kq - 6 6",
+		"8/5pk1/6p1/1P6/P7/6P1/5PK1/8 w - - 0 40",
+		"6k1/1P3ppp/8/8/8/8/r4PPP/6K1 w - - 0 30",
+	};
+	size_t i;
+
+	for (i = 0; i < sizeof fens / sizeof fens[0]; ++i) {
+		char mirrored[128];
+
+		mirror_fen(fens[i], mirrored);
+		ck_assert_msg(evaluate_fen(fens[i]) == evaluate_fen(mirrored),
+		              "'%s' and '%s' evaluate differently",
+		              fens[i], mirrored);
+	}
+}
+END_TEST
+
+START_TEST(test_evaluate_lazy_margin)
+{
+	static const char *fen =
+		"r1bqk2r/pppp1ppp/2n2n2/2b1p3/2B1P3/3P1N2/PPP2PPP/RNBQK2R w KQkq - 0 5";
+	Tree tree;
+	int lazy, margin, exact;
+
+	memset(&tree, 0, sizeof tree);
+	ck_assert_int_eq(chi_set_position(&tree.position, fen), 0);
+	tree.signatures[0] = chi_zk_signature(lisco.zk_handle, &tree.position);
+	tree.pawn_signatures[0] = chi_zk_pawn_signature(lisco.zk_handle,
+		&tree.position);
+	clear_ev_hash();
+
+	/* Far below alpha, the evaluation stops after the first stage.  */
+	lazy = evaluate(&tree, 0, 5000, 5001);
+	margin = tree.lazy_margin;
+	ck_assert_int_gt(margin, 0);
+	ck_assert_int_le(lazy + margin, 5000);
+
+	/* The real score is within the margin.  */
+	exact = evaluate(&tree, 0, -INF, +INF);
+	ck_assert_int_eq(tree.lazy_margin, 0);
+	ck_assert_int_le(exact, lazy + margin);
+}
+END_TEST
+
+Suite *
+evaluate_suite(void)
+{
+	Suite *suite;
+	TCase *tc_basic;
+
+	suite = suite_create("Evaluation");
+
+	tc_basic = tcase_create("Basic functions");
+	tcase_add_test(tc_basic, test_evaluate_symmetry);
+	tcase_add_test(tc_basic, test_evaluate_lazy_margin);
+	suite_add_tcase(suite, tc_basic);
+
+	return suite;
+}
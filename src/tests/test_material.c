@@ -0,0 +1,123 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <check.h>
+
+#include "lisco.h"
+
+static const MaterialEntry *
+probe_fen(const char *fen)
+{
+	static chi_pos pos;
+
+	ck_assert_int_eq(chi_set_position(&pos, fen), 0);
+
+	return material_probe(&pos);
+}
+
+START_TEST(test_material_initial)
+{
+	const MaterialEntry *material = probe_fen(
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+
+	ck_assert_int_eq(material->phase, CHI_PHASE_MAX);
+	ck_assert_int_eq(material->imbalance, 0);
+	ck_assert_int_eq(material->draw, 0);
+	ck_assert_int_eq(material->scale[chi_white], MATERIAL_SCALE_NORMAL);
+	ck_assert_int_eq(material->scale[chi_black], MATERIAL_SCALE_NORMAL);
+	ck_assert_ptr_eq(material->endgame, NULL);
+
+	/* Black lacks the bishop pair.  */
+	material = probe_fen(
+		"rn1qkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+	ck_assert_int_gt(material->imbalance, 0);
+	ck_assert_int_eq(material->phase, CHI_PHASE_MAX - 1);
+
+	/* Promotions cannot push the phase over the maximum.  */
+	material = probe_fen(
+		"rnbqkbnr/pppppppp/8/8/8/8/1PPPPPPP/QNBQKBNR w Kkq - 0 1");
+	ck_assert_int_eq(material->phase, CHI_PHASE_MAX);
+}
+END_TEST
+
+START_TEST(test_material_draws)
+{
+	const MaterialEntry *material;
+
+	ck_assert_int_ne(probe_fen("4k3/8/8/8/8/8/8/4K3 w - - 0 1")->draw, 0);
+	ck_assert_int_ne(probe_fen("4k3/8/8/8/8/8/8/3NK3 w - - 0 1")->draw, 0);
+	ck_assert_int_ne(probe_fen("4kb2/8/8/8/8/8/8/3NK3 w - - 0 1")->draw, 0);
+	ck_assert_int_eq(probe_fen("4k3/8/8/8/8/8/8/2BNK3 w - - 0 1")->draw, 0);
+	ck_assert_int_eq(probe_fen("4k3/8/8/8/8/8/4P3/4K3 w - - 0 1")->draw, 0);
+
+	/* A rook against a minor piece is hard to win.  */
+	material = probe_fen("4kb2/8/8/8/8/8/8/3RK3 w - - 0 1");
+	ck_assert_int_eq(material->draw, 0);
+	ck_assert_int_lt(material->scale[chi_white], MATERIAL_SCALE_NORMAL);
+	ck_assert_int_gt(material->scale[chi_white], 0);
+
+	/* A bishop and a pawn still win.  */
+	material = probe_fen("4k3/8/8/8/8/8/4P3/3BK3 w - - 0 1");
+	ck_assert_int_eq(material->scale[chi_white], MATERIAL_SCALE_NORMAL);
+	ck_assert_int_eq(material->scale[chi_black], 0);
+}
+END_TEST
+
+START_TEST(test_material_endgames)
+{
+	const MaterialEntry *material;
+
+	material = probe_fen("8/8/8/8/8/2k5/8/KBN5 w - - 0 1");
+	ck_assert_ptr_ne(material->endgame, NULL);
+	ck_assert_int_eq(material->strong, chi_white);
+	ck_assert_int_eq(material->endgame_result, ENDGAME_SCALED);
+
+	material = probe_fen("4k3/4p3/8/8/8/8/8/4K3 w - - 0 1");
+	ck_assert_ptr_ne(material->endgame, NULL);
+	ck_assert_int_eq(material->strong, chi_black);
+	ck_assert_int_eq(material->endgame_result, ENDGAME_EXACT);
+
+	/* The generic recognizer for a lone king.  */
+	material = probe_fen("4k3/8/8/8/8/8/8/RR2K3 w - - 0 1");
+	ck_assert_ptr_ne(material->endgame, NULL);
+	ck_assert_int_eq(material->strong, chi_white);
+
+	material = probe_fen("4k3/8/8/8/8/8/8/R3K1n1 w - - 0 1");
+	ck_assert_ptr_eq(material->endgame, NULL);
+}
+END_TEST
+
+Suite *
+material_suite(void)
+{
+	Suite *suite;
+	TCase *tc_basic;
+
+	suite = suite_create("Material table");
+
+	tc_basic = tcase_create("Basic functions");
+	tcase_add_test(tc_basic, test_material_initial);
+	tcase_add_test(tc_basic, test_material_draws);
+	tcase_add_test(tc_basic, test_material_endgames);
+	suite_add_tcase(suite, tc_basic);
+
+	return suite;
+}
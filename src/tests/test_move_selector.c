@@ -162,7 +162,7 @@ START_TEST(test_quiescence)
 	ck_assert_int_eq(errnum, 0);
 
 	MoveSelector selector;
-	move_selector_quiescence_init(&selector, &tree);
+	move_selector_quiescence_init(&selector, &tree, 0);
 	ck_assert_int_eq(selector.num_moves, 8);
 	ck_assert_int_eq(selector.selected, 0);
 
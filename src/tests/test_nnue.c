@@ -0,0 +1,199 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <check.h>
+
+#include "lisco.h"
+
+static const char *fens[] = {
+	/* Castling and captures for white.  */
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	/* The same for black.  */
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b KQkq - 0 1",
+	/* En passant.  */
+	"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+	/* Promotions with and without captures.  */
+	"n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+	"n1n5/PPPk4/8/8/8/8/4Kppp/5N1N w - - 0 1",
+};
+
+static unsigned int seed = 2021;
+
+static int
+random_number(int min, int max)
+{
+	seed = seed * 1103515245 + 12345;
+
+	return min + (int) ((seed >> 8) % (unsigned int) (max - min + 1));
+}
+
+static void
+write_le(FILE *fp, unsigned int value, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size; ++i) {
+		fputc(value & 0xff, fp);
+		value >>= 8;
+	}
+}
+
+/* Write a network with random weights and load it.  */
+static void
+load_random_network(void)
+{
+	char filename[] = "/tmp/lisco-nnue-XXXXXX";
+	FILE *fp;
+	int fd, i;
+
+	fd = mkstemp(filename);
+	ck_assert_int_ge(fd, 0);
+	fp = fdopen(fd, "wb");
+	ck_assert_ptr_ne(fp, NULL);
+
+	fwrite("LISCONN1", 1, 8, fp);
+	write_le(fp, NNUE_HIDDEN, 4);
+	write_le(fp, NNUE_L1, 4);
+	for (i = 0; i < NNUE_HIDDEN; ++i)
+		write_le(fp, random_number(-64, 64), 2);
+	for (i = 0; i < NNUE_INPUTS * NNUE_HIDDEN; ++i)
+		write_le(fp, random_number(-32, 32), 2);
+	for (i = 0; i < NNUE_L1; ++i)
+		write_le(fp, random_number(-2000, 2000), 4);
+	write_le(fp, random_number(-100, 100), 4);
+	for (i = 0; i < NNUE_L1 * 2 * NNUE_HIDDEN; ++i)
+		write_le(fp, random_number(-128, 127), 1);
+	for (i = 0; i < NNUE_L1; ++i)
+		write_le(fp, random_number(-128, 127), 1);
+	fclose(fp);
+
+	ck_assert_int_eq(nnue_load(filename), 0);
+	ck_assert_int_ne(nnue_loaded(), 0);
+	unlink(filename);
+}
+
+START_TEST(test_nnue_load)
+{
+	char filename[] = "/tmp/lisco-nnue-XXXXXX";
+	int fd;
+
+	ck_assert_int_eq(nnue_load("/nonexistent/lisco.nnue"), -1);
+	ck_assert_int_eq(errno, ENOENT);
+
+	fd = mkstemp(filename);
+	ck_assert_int_ge(fd, 0);
+	ck_assert_int_eq(write(fd, "LISCONN1", 8), 8);
+	close(fd);
+	ck_assert_int_eq(nnue_load(filename), -1);
+	ck_assert_int_eq(errno, EINVAL);
+	ck_assert_int_eq(nnue_loaded(), 0);
+	unlink(filename);
+
+	load_random_network();
+}
+END_TEST
+
+START_TEST(test_nnue_incremental)
+{
+	size_t i;
+
+	load_random_network();
+
+	for (i = 0; i < sizeof fens / sizeof fens[0]; ++i) {
+		chi_pos pos;
+		chi_move moves[CHI_MAX_MOVES];
+		chi_move *end;
+		chi_move *mv;
+		NNUEAccumulator before, updated, expected;
+
+		ck_assert_int_eq(chi_set_position(&pos, fens[i]), 0);
+		nnue_refresh(&before, &pos);
+		end = chi_legal_moves(&pos, moves);
+		ck_assert_int_gt(end - moves, 0);
+
+		for (mv = moves; mv < end; ++mv) {
+			chi_color_t mover = chi_on_move(&pos);
+
+			chi_apply_move(&pos, *mv);
+			nnue_update(&before, &updated, *mv, mover);
+			nnue_refresh(&expected, &pos);
+			ck_assert_msg(memcmp(&updated, &expected, sizeof expected) == 0,
+			              "accumulator differs after move %d in '%s'",
+			              (int) (mv - moves), fens[i]);
+			chi_unapply_move(&pos, *mv);
+		}
+	}
+}
+END_TEST
+
+START_TEST(test_nnue_kernels)
+{
+	NNUEKernel saved = nnue_get_kernel();
+	NNUEKernel kernel;
+	size_t i;
+
+	load_random_network();
+
+	for (kernel = NNUE_KERNEL_SCALAR; kernel <= NNUE_KERNEL_AVX2; ++kernel) {
+		if (!nnue_kernel_supported(kernel))
+			continue;
+		ck_assert_int_eq(nnue_select_kernel(kernel), 0);
+
+		for (i = 0; i < sizeof fens / sizeof fens[0]; ++i) {
+			chi_pos pos;
+			NNUEAccumulator acc;
+
+			ck_assert_int_eq(chi_set_position(&pos, fens[i]), 0);
+			nnue_refresh(&acc, &pos);
+			ck_assert_int_eq(nnue_evaluate(&acc, chi_white),
+			                 nnue_evaluate_scalar(&acc, chi_white));
+			ck_assert_int_eq(nnue_evaluate(&acc, chi_black),
+			                 nnue_evaluate_scalar(&acc, chi_black));
+		}
+	}
+
+	nnue_select_kernel(saved);
+}
+END_TEST
+
+Suite *
+nnue_suite(void)
+{
+	Suite *suite;
+	TCase *tc_basic;
+
+	suite = suite_create("Evaluation network");
+
+	tc_basic = tcase_create("Basic functions");
+	tcase_add_test(tc_basic, test_nnue_load);
+	tcase_add_test(tc_basic, test_nnue_incremental);
+	tcase_add_test(tc_basic, test_nnue_kernels);
+	suite_add_tcase(suite, tc_basic);
+
+	return suite;
+}
@@ -0,0 +1,114 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include <check.h>
+
+#include "libchi.h"
+#include "../lisco.h"
+
+START_TEST(test_iterations)
+{
+	static Tree tree;
+
+	memset(&tree, 0, sizeof tree);
+	tc_start(&tree);
+
+	/* Totals after each iteration.  */
+	tree.depth = 1;
+	tree.nodes = 20;
+	tree.stats.qnodes = 10;
+	stats_end_iteration(&tree);
+
+	tree.depth = 2;
+	tree.nodes = 80;
+	tree.stats.qnodes = 70;
+	stats_end_iteration(&tree);
+
+	tree.depth = 3;
+	tree.nodes = 300;
+	tree.stats.qnodes = 450;
+	stats_end_iteration(&tree);
+
+	ck_assert_int_eq(tree.stats.iterations, 3);
+	ck_assert_uint_eq(tree.stats.iteration_nodes[1], 30);
+	ck_assert_uint_eq(tree.stats.iteration_nodes[2], 120);
+	ck_assert_uint_eq(tree.stats.iteration_nodes[3], 600);
+
+	ck_assert(stats_branching_factor(&tree, 1) == 0);
+	ck_assert(stats_branching_factor(&tree, 2) == 4);
+	ck_assert(stats_branching_factor(&tree, 3) == 5);
+	ck_assert(stats_branching_factor(&tree, 4) == 0);
+}
+END_TEST
+
+START_TEST(test_json)
+{
+	static Tree tree;
+	char output[4096];
+	FILE *out;
+
+	memset(&tree, 0, sizeof tree);
+	memset(output, 0, sizeof output);
+	tc_start(&tree);
+
+	tree.depth = 1;
+	tree.nodes = 21;
+	tree.stats.qnodes = 4;
+	tree.stats.cutoffs = 10;
+	tree.stats.first_move_cutoffs = 9;
+	tree.stats.seldepth = 5;
+	stats_end_iteration(&tree);
+
+	out = fmemopen(output, sizeof output - 1, "w");
+	ck_assert_ptr_nonnull(out);
+	stats_write_json(&tree, out);
+	fclose(out);
+
+	ck_assert_int_eq(output[0], '{');
+	ck_assert_ptr_nonnull(strstr(output, "\"depth\":1,\"seldepth\":5,"));
+	ck_assert_ptr_nonnull(strstr(output, "\"nodes\":25,\"main_nodes\":21,"
+	                                     "\"quiescence_nodes\":4"));
+	ck_assert_ptr_nonnull(strstr(output, "\"first_move_cutoffs\":9"));
+	ck_assert_ptr_nonnull(strstr(output, "\"iterations\":[{\"depth\":1,"
+	                                     "\"nodes\":25,"));
+	ck_assert_ptr_nonnull(strstr(output, "}]}\n"));
+}
+END_TEST
+
+Suite *
+statistics_suite(void)
+{
+	Suite *suite;
+	TCase *tc_statistics;
+
+	suite = suite_create("Search Statistics");
+
+	tc_statistics = tcase_create("Statistics");
+	tcase_add_test(tc_statistics, test_iterations);
+	tcase_add_test(tc_statistics, test_json);
+	suite_add_tcase(suite, tc_statistics);
+
+	return suite;
+}
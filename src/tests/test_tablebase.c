@@ -0,0 +1,219 @@
+/* This file is part of the chess engine lisco.
+ *
+ * Copyright (C) 2002-2021 cantanea EOOD.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <check.h>
+
+#include "lisco.h"
+
+static Tablebase tables[5];
+
+/* Generate NAME once and register it.  */
+static Tablebase *
+generate(Tablebase *tb, const char *name)
+{
+	if (!tb->values) {
+		ck_assert_int_eq(tb_parse_name(tb, name), 0);
+		tb_generate(tb, 2);
+	}
+	tb_register(tb);
+
+	return tb;
+}
+
+static void
+generate_all(void)
+{
+	tb_clear();
+	generate(tables + 0, "KQvK");
+	generate(tables + 1, "KRvK");
+	generate(tables + 2, "KBvK");
+	generate(tables + 3, "KNvK");
+	generate(tables + 4, "KPvK");
+}
+
+static int
+lookup_fen(const char *fen)
+{
+	chi_pos pos;
+
+	ck_assert_int_eq(chi_set_position(&pos, fen), 0);
+
+	return tb_lookup(&pos);
+}
+
+START_TEST(test_tablebase_names)
+{
+	Tablebase tb;
+
+	ck_assert_int_eq(tb_parse_name(&tb, "KNvKR"), 0);
+	ck_assert_str_eq(tb.name, "KRvKN");
+	ck_assert_int_eq(tb.num_pieces, 2);
+	ck_assert_int_eq(tb.pieces[0], rook);
+	ck_assert_int_eq(tb.colors[0], chi_white);
+	ck_assert_int_eq(tb.pieces[1], knight);
+	ck_assert_int_eq(tb.colors[1], chi_black);
+	ck_assert_int_eq(tb.pawns, 0);
+	ck_assert_uint_eq(tb.size, 2UL * 462 * 64 * 64);
+
+	ck_assert_int_eq(tb_parse_name(&tb, "KvKPB"), 0);
+	ck_assert_str_eq(tb.name, "KBPvK");
+	ck_assert_int_eq(tb.pawns, 1);
+	ck_assert_uint_eq(tb.size, 2UL * 1806 * 64 * 48);
+
+	ck_assert_int_eq(tb_parse_name(&tb, "KvK"), -1);
+	ck_assert_int_eq(tb_parse_name(&tb, "KQK"), -1);
+	ck_assert_int_eq(tb_parse_name(&tb, "KQRvKR"), -1);
+	ck_assert_int_eq(tb_parse_name(&tb, "KXvK"), -1);
+}
+END_TEST
+
+START_TEST(test_tablebase_mates)
+{
+	int squares[3];
+
+	generate_all();
+
+	/* The longest mates are well known.  */
+	ck_assert_uint_eq(tables[0].longest, 20);
+	ck_assert_uint_eq(tables[1].longest, 32);
+	ck_assert_uint_eq(tables[4].longest, 56);
+	ck_assert_uint_eq(tables[2].longest, 0);
+	ck_assert_uint_eq(tables[3].longest, 0);
+
+	ck_assert_int_eq(lookup_fen("k7/8/1K6/8/8/8/8/6Q1 w - - 0 1"), 1);
+	ck_assert_int_eq(lookup_fen("k7/8/1K6/8/8/8/8/6Q1 b - - 0 1"),
+	                 TB_LOSS + 1);
+	ck_assert_int_eq(lookup_fen("k7/2Q5/1K6/8/8/8/8/8 b - - 0 1"), TB_DRAW);
+	ck_assert_int_eq(lookup_fen("k7/1Q6/1K6/8/8/8/8/8 b - - 0 1"), TB_LOSS);
+
+	/* The same with the colors swapped.  */
+	ck_assert_int_eq(lookup_fen("6q1/8/8/8/8/1k6/8/K7 b - - 0 1"), 1);
+	ck_assert_int_eq(lookup_fen("6q1/8/8/8/8/1k6/8/K7 w - - 0 1"),
+	                 TB_LOSS + 1);
+
+	ck_assert_int_eq(lookup_fen("r7/8/8/8/8/8/2k5/K7 w - - 0 1"), TB_LOSS);
+
+	/* Black is in check with white on move.  Squares are h1 = 0 to
+	 * a8 = 63.
+	 */
+	squares[0] = 46;
+	squares[1] = 63;
+	squares[2] = 0;
+	ck_assert_int_eq(tables[0].values[tb_index(tables + 0, chi_white,
+	                                           squares)], TB_ILLEGAL);
+
+	ck_assert_int_eq(lookup_fen("8/8/8/8/8/8/8/K1k4N w - - 0 1"), TB_DRAW);
+
+	tb_clear();
+}
+END_TEST
+
+START_TEST(test_tablebase_kpk)
+{
+	Tablebase *tb = tables + 4;
+	unsigned long index;
+	chi_pos pos;
+
+	generate_all();
+
+	/* The pawn ending must agree with the bitbase.  */
+	for (index = 0; index < tb->size; ++index) {
+		int value = tb->values[index];
+		int wins;
+
+		if (tb_position(tb, index, &pos) != 0) {
+			ck_assert_int_eq(value, TB_ILLEGAL);
+			continue;
+		}
+		ck_assert_int_ne(value, TB_ILLEGAL);
+		ck_assert_uint_eq(tb_pos_index(tb, &pos), index);
+
+		wins = chi_on_move(&pos) == chi_white
+			? TB_IS_WIN(value) : TB_IS_LOSS(value);
+		ck_assert_int_eq(wins, chi_kpk_probe(&pos) != 0);
+	}
+
+	tb_clear();
+}
+END_TEST
+
+START_TEST(test_tablebase_file)
+{
+	char filename[] = "/tmp/lisco-tb-XXXXXX";
+	chi_pos pos;
+	int fd, score;
+
+	generate_all();
+
+	fd = mkstemp(filename);
+	ck_assert_int_ge(fd, 0);
+	close(fd);
+	ck_assert_int_eq(tb_write(tables + 0, filename), 0);
+
+	tb_clear();
+	ck_assert_int_eq(tb_max_pieces(), 0);
+	ck_assert_int_eq(tb_load(filename), 0);
+	unlink(filename);
+	ck_assert_int_eq(tb_max_pieces(), 3);
+
+	ck_assert_int_eq(chi_set_position(&pos, "k7/8/1K6/8/8/8/8/6Q1 w - - 0 1"),
+	                 0);
+	ck_assert_int_eq(tb_probe(&pos, 3, &score), 1);
+	ck_assert_int_eq(score, -MATE - 4);
+
+	ck_assert_int_eq(chi_set_position(&pos, "k7/8/1K6/8/8/8/8/6Q1 b - - 0 1"),
+	                 0);
+	ck_assert_int_eq(tb_probe(&pos, 3, &score), 1);
+	ck_assert_int_eq(score, MATE + 5);
+
+	/* No table for that.  */
+	ck_assert_int_eq(chi_set_position(&pos, "k7/8/1K6/8/8/8/8/7R w - - 0 1"),
+	                 0);
+	ck_assert_int_eq(tb_probe(&pos, 3, &score), 0);
+
+	tb_clear();
+	ck_assert_int_eq(tb_max_pieces(), 0);
+}
+END_TEST
+
+Suite *
+tablebase_suite(void)
+{
+	Suite *suite;
+	TCase *tc_basic;
+
+	suite = suite_create("Endgame tables");
+
+	tc_basic = tcase_create("Basic functions");
+	tcase_set_timeout(tc_basic, 60);
+	tcase_add_test(tc_basic, test_tablebase_names);
+	tcase_add_test(tc_basic, test_tablebase_mates);
+	tcase_add_test(tc_basic, test_tablebase_kpk);
+	tcase_add_test(tc_basic, test_tablebase_file);
+	suite_add_tcase(suite, tc_basic);
+
+	return suite;
+}
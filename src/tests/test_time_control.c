@@ -39,8 +39,14 @@ START_TEST(test_movetime)
 
 	process_search_params(&tree, &params);
 
-	ck_assert_uint_eq(tree.fixed_time, 120000);
-	ck_assert(tree.nodes_to_tc > 0);
+	ck_assert_uint_eq(tree.soft_limit, 120000);
+	ck_assert_uint_eq(tree.hard_limit, 120000);
+	ck_assert_int_eq(tree.flexible_time, 0);
+
+	params.overhead = 50;
+	process_search_params(&tree, &params);
+	ck_assert_uint_eq(tree.soft_limit, 119950);
+	ck_assert_uint_eq(tree.hard_limit, 119950);
 }
 END_TEST
 
@@ -56,8 +62,9 @@ START_TEST(test_nodes)
 
 	process_search_params(&tree, &params);
 
-	ck_assert_uint_eq(tree.fixed_time, 0);
-	ck_assert_uint_eq(tree.nodes_to_tc, 2304);
+	ck_assert_uint_eq(tree.soft_limit, 0);
+	ck_assert_uint_eq(tree.hard_limit, 0);
+	ck_assert_uint_eq(tree.max_nodes, 2304);
 }
 END_TEST
 
@@ -114,7 +121,7 @@ START_TEST(test_sudden_death)
 	 * number of moves to go which is 60.
 	 */
 	process_search_params(&tree, &params);
-	ck_assert_uint_eq(tree.fixed_time, 1000);
+	ck_assert_uint_eq(tree.soft_limit, 1000);
 
 	const char *fen;
 
@@ -149,7 +156,7 @@ START_TEST(test_sudden_death)
 	errnum = chi_set_position(&tree.position, fen);
 	ck_assert_int_eq(errnum, 0);
 	process_search_params(&tree, &params);
-	ck_assert_uint_eq(tree.fixed_time, 1111);
+	ck_assert_uint_eq(tree.soft_limit, 1111);
 
 	/* 13 pieces for each side, material imbalance is 0.  The material
 	 * balance (weight 0.25) should still indicate 60 moves to go.
@@ -182,8 +189,111 @@ START_TEST(test_sudden_death)
 	errnum = chi_set_position(&tree.position, fen);
 	ck_assert_int_eq(errnum, 0);
 	process_search_params(&tree, &params);
-	ck_assert_uint_eq(tree.fixed_time, 3000);
+	ck_assert_uint_eq(tree.soft_limit, 3000);
+	ck_assert_uint_eq(tree.hard_limit, 15000);
+	ck_assert_int_eq(tree.flexible_time, 1);
+}
+END_TEST
+
+START_TEST(test_short_of_time)
+{
+	SearchParams params;
+	Tree tree;
+
+	memset(&params, 0, sizeof params);
+	memset(&tree, 0, sizeof tree);
+
+	chi_init_position(&tree.position);
+
+	/* The last move before the time control must not use more than the
+	 * time left minus the overhead.
+	 */
+	params.mytime = 1000;
+	params.movestogo = 1;
+	params.overhead = 100;
+	process_search_params(&tree, &params);
+	ck_assert_uint_eq(tree.soft_limit, 900);
+	ck_assert_uint_eq(tree.hard_limit, 900);
+
+	/* The increments of the moves to go count, the overhead of each of
+	 * them is lost.  (2000 + 9 * 1000 - 10 * 100) / 10 = 1000.
+	 */
+	params.mytime = 2000;
+	params.myinc = 1000;
+	params.movestogo = 10;
+	process_search_params(&tree, &params);
+	ck_assert_uint_eq(tree.soft_limit, 1000);
+	ck_assert_uint_eq(tree.hard_limit, 1900);
+
+	/* Less time than overhead.  */
+	params.mytime = 50;
+	params.myinc = 0;
+	params.movestogo = 0;
+	process_search_params(&tree, &params);
+	ck_assert_uint_eq(tree.soft_limit, 1);
+	ck_assert_uint_eq(tree.hard_limit, 1);
+}
+END_TEST
+
+START_TEST(test_stability)
+{
+	Tree tree;
+	chi_move e2e4 = chi_coords2shift(4, 1) | chi_coords2shift(4, 3) << 6;
+	chi_move d2d4 = chi_coords2shift(3, 1) | chi_coords2shift(3, 3) << 6;
+
+	memset(&tree, 0, sizeof tree);
+
+	/* Pretend that 0.5 seconds have passed of a budget of 1.2 seconds.
+	 * A new iteration is started, if less than half of the scaled budget
+	 * has been used.
+	 */
+	tree.soft_limit = 1200;
+	tree.hard_limit = 6000;
+	tree.flexible_time = 1;
+	tc_start(&tree);
+	tc_stop(&tree);
+	tree.start_time -= 500;
+
+	/* A stable best move stops before the budget is used up.  */
+	ck_assert_int_eq(tc_next_iteration(&tree, e2e4, 20), 0);
+
+	/* A new best move gets more time.  */
+	ck_assert_int_ne(tc_next_iteration(&tree, d2d4, 20), 0);
+
+	/* And so does a dropping score.  */
+	tree.bestmove_changes = 0;
+	ck_assert_int_ne(tc_next_iteration(&tree, d2d4, -60), 0);
+	ck_assert_int_eq(tc_next_iteration(&tree, d2d4, -60), 0);
+
+	/* Without flexible time, the budget is fixed.  */
+	tree.flexible_time = 0;
+	tree.bestmove_changes = 0;
+	ck_assert_int_ne(tc_next_iteration(&tree, e2e4, -200), 0);
+}
+END_TEST
+
+START_TEST(test_timer)
+{
+	Tree tree;
+	long long int elapsed;
+
+	memset(&tree, 0, sizeof tree);
 
+	tree.hard_limit = 50;
+	tc_start(&tree);
+	while (!tree.move_now && tc_elapsed(&tree) < 5000)
+		;
+	elapsed = tc_elapsed(&tree);
+	tc_stop(&tree);
+	ck_assert_int_eq(tree.move_now, 1);
+	ck_assert(elapsed >= 50);
+	ck_assert(elapsed < 1000);
+
+	/* Stopping before the deadline leaves the flag alone.  */
+	tree.hard_limit = 60000;
+	tc_start(&tree);
+	tc_stop(&tree);
+	ck_assert_int_eq(tree.move_now, 0);
 }
 END_TEST
 
@@ -205,6 +315,9 @@ time_control_suite(void)
 
 	tc_time_allocation = tcase_create("Time Allocation");
 	tcase_add_test(tc_time_allocation, test_sudden_death);
+	tcase_add_test(tc_time_allocation, test_short_of_time);
+	tcase_add_test(tc_time_allocation, test_stability);
+	tcase_add_test(tc_time_allocation, test_timer);
 	suite_add_tcase(suite, tc_time_allocation);
 
 	return suite;
@@ -22,7 +22,11 @@
 # include <config.h>
 #endif
 
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include <check.h>
 
@@ -36,6 +40,82 @@ START_TEST(test_tt_init)
 }
 END_TEST
 
+static void
+read_file(const char *filename, char **data, long *size)
+{
+	FILE *file = fopen(filename, "rb");
+
+	ck_assert_ptr_ne(file, NULL);
+	ck_assert_int_eq(fseek(file, 0, SEEK_END), 0);
+	*size = ftell(file);
+	ck_assert_int_gt(*size, 0);
+	rewind(file);
+	*data = malloc(*size);
+	ck_assert_ptr_ne(*data, NULL);
+	ck_assert_int_eq(fread(*data, 1, *size, file), *size);
+	fclose(file);
+}
+
+START_TEST(test_tt_snapshot)
+{
+	char first[] = "/tmp/lisco-tt-XXXXXX";
+	char second[] = "/tmp/lisco-tt-XXXXXX";
+	char *first_data, *second_data;
+	long first_size, second_size;
+	FILE *file;
+	int fd;
+
+	fd = mkstemp(first);
+	ck_assert_int_ge(fd, 0);
+	close(fd);
+	fd = mkstemp(second);
+	ck_assert_int_ge(fd, 0);
+	close(fd);
+
+	tt_init(100000);
+	ck_assert_int_eq(tt_save(first), 0);
+	tt_destroy();
+
+	/* A round trip must reproduce the file byte by byte.  */
+	ck_assert_int_eq(tt_load(first), 0);
+	ck_assert_int_eq(tt_hashfull(), 0);
+	ck_assert_int_eq(tt_save(second), 0);
+	read_file(first, &first_data, &first_size);
+	read_file(second, &second_data, &second_size);
+	ck_assert_int_eq(first_size, second_size);
+	ck_assert_int_eq(memcmp(first_data, second_data, first_size), 0);
+	free(second_data);
+
+	/* Wrong magic.  */
+	first_data[0] = 'X';
+	file = fopen(second, "wb");
+	ck_assert_ptr_ne(file, NULL);
+	fwrite(first_data, 1, first_size, file);
+	fclose(file);
+	errno = 0;
+	ck_assert_int_eq(tt_load(second), -1);
+	ck_assert_int_eq(errno, EINVAL);
+
+	/* Truncated.  */
+	first_data[0] = 'L';
+	file = fopen(second, "wb");
+	ck_assert_ptr_ne(file, NULL);
+	fwrite(first_data, 1, first_size - 1, file);
+	fclose(file);
+	errno = 0;
+	ck_assert_int_eq(tt_load(second), -1);
+	ck_assert_int_eq(errno, EINVAL);
+
+	/* The table that was loaded before is still usable.  */
+	tt_clear();
+	tt_destroy();
+
+	free(first_data);
+	unlink(first);
+	unlink(second);
+}
+END_TEST
+
 Suite *
 tt_suite(void)
 {
@@ -46,6 +126,7 @@ tt_suite(void)
 
 	tc_basic = tcase_create("Basic functions");
 	tcase_add_test(tc_basic, test_tt_init);
+	tcase_add_test(tc_basic, test_tt_snapshot);
 	suite_add_tcase(suite, tc_basic);
 
 	return suite;
@@ -96,6 +96,12 @@ START_TEST(test_uci_uci)
 	expect = "\noption name Threads type spin default 1 min 1 max " TEST_UCI_TOSTR(UCI_ENGINE_MAX_THREADS) "\n";
 	ck_assert_ptr_nonnull(strstr(output, expect));
 
+	expect = "\noption name Move Overhead type spin default " TEST_UCI_TOSTR(UCI_ENGINE_MOVE_OVERHEAD) " min 0 max " TEST_UCI_TOSTR(UCI_ENGINE_MAX_MOVE_OVERHEAD) "\n";
+	ck_assert_ptr_nonnull(strstr(output, expect));
+
+	expect = "\ninfo string slider attacks: ";
+	ck_assert_ptr_nonnull(strstr(output, expect));
+
 	expect = "uciok\n";
 	expect_length = strlen(expect);
 	ck_assert_int_eq(strncmp(output + output_length - expect_length, expect, expect_length), 0);
@@ -170,6 +176,371 @@ START_TEST(test_uci_position)
 }
 END_TEST
 
+/* Send "position COMMAND" and check the position and its history
+ * against FEN.
+ */
+static void
+check_position(UCIEngineOptions *options, FILE *out, const char *command,
+               const char *fen, size_t num_moves)
+{
+	char *args = xstrdup(command);
+	chi_pos expect;
+	const char *current_fen;
+
+	ck_assert_int_eq(uci_handle_position(options, args, out), 1);
+	free(args);
+
+	current_fen = chi_fen(&lisco.position);
+	ck_assert_str_eq(current_fen, fen);
+	free((void *) current_fen);
+
+	ck_assert_int_eq(chi_set_position(&expect, fen), 0);
+	ck_assert_uint_eq(lisco.game_moves.num_moves, num_moves);
+	ck_assert_uint_eq(lisco.game_signatures[num_moves],
+	                  chi_zk_signature(lisco.zk_handle, &expect));
+}
+
+START_TEST(test_uci_position_incremental)
+{
+	const char output[1024];
+
+	INIT_UCI(engine_options, output, NULL, NULL, engine_out, "[memstream]");
+
+	check_position(&engine_options, engine_out,
+	               "startpos moves e2e4 e7e5 g1f3",
+	               "rnbqkbnr/pppp1ppp/8/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R"
+	               " b KQkq - 1 2", 3);
+
+	/* The game goes on.  */
+	check_position(&engine_options, engine_out,
+	               "startpos moves e2e4 e7e5 g1f3 b8c6 f1c4 g8f6 e1g1",
+	               "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQ1RK1"
+	               " b kq - 5 4", 7);
+
+	/* Take back moves and play others.  */
+	check_position(&engine_options, engine_out,
+	               "startpos moves e2e4 e7e5 g1f3 g8f6",
+	               "rnbqkb1r/pppp1ppp/5n2/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R"
+	               " w KQkq - 2 3", 4);
+	check_position(&engine_options, engine_out,
+	               "startpos moves e2e4",
+	               "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR"
+	               " b KQkq e3 0 1", 1);
+
+	/* A different start.  */
+	check_position(&engine_options, engine_out,
+	               "fen 4k3/P7/8/8/8/8/8/4K3 w - - 0 1 moves a7a8n",
+	               "N3k3/8/8/8/8/8/8/4K3 b - - 0 1", 1);
+
+	/* Illegal moves stop the replay.  */
+	check_position(&engine_options, engine_out,
+	               "startpos moves e2e4 e7e5 e1e2 e8e7 a1a3 a7a6",
+	               "rnbq1bnr/ppppkppp/8/4p3/4P3/8/PPPPKPPP/RNBQ1BNR"
+	               " w - - 2 3", 4);
+
+	fflush(engine_out);
+	ck_assert_str_eq(output, "info Illegal move 'a1a3'.\n");
+}
+END_TEST
+
+/* Search to depth 3 in the current position.  */
+static void
+search_depth_3(UCIEngineOptions *options, FILE *out)
+{
+	FILE *saved_out = lisco.uci.out;
+	char *command = xstrdup("depth 3");
+
+	lisco.uci.out = out;
+	ck_assert_int_eq(uci_handle_go(options, command, out), 1);
+	lisco.uci.out = saved_out;
+	free(command);
+}
+
+START_TEST(test_uci_ucinewgame)
+{
+	const char output[4096];
+	int status;
+	char *command;
+
+	INIT_UCI(engine_options, output, NULL, NULL, engine_out, "[memstream]");
+
+	check_position(&engine_options, engine_out,
+	               "startpos moves e2e4 e7e5",
+	               "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR"
+	               " w KQkq e6 0 2", 2);
+	search_depth_3(&engine_options, engine_out);
+	ck_assert_int_gt(ev_hashfull(), 0);
+
+	command = xstrdup("");
+	status = uci_handle_ucinewgame(&engine_options, command, engine_out);
+	free(command);
+	ck_assert_int_eq(status, 1);
+	ck_assert_int_eq(tt_hashfull(), 0);
+	ck_assert_int_eq(ev_hashfull(), 0);
+	ck_assert_ptr_null(lisco.game_start);
+	ck_assert_int_eq(lisco.game_moves.num_moves, 0);
+
+	/* The same start position sets up a new game.  */
+	check_position(&engine_options, engine_out,
+	               "startpos moves d2d4",
+	               "rnbqkbnr/pppppppp/8/8/3P4/8/PPP1PPPP/RNBQKBNR"
+	               " b KQkq d3 0 1", 1);
+}
+END_TEST
+
+START_TEST(test_uci_use_nnue)
+{
+	const char output[4096];
+	char *command;
+
+	INIT_UCI(engine_options, output, NULL, NULL, engine_out, "[memstream]");
+
+	check_position(&engine_options, engine_out,
+	               "startpos moves e2e4",
+	               "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR"
+	               " b KQkq e3 0 1", 1);
+	search_depth_3(&engine_options, engine_out);
+	ck_assert_int_gt(ev_hashfull(), 0);
+
+	/* Scores of the other evaluator are dropped.  */
+	command = xstrdup("name UseNNUE value true");
+	ck_assert_int_eq(uci_handle_setoption(&engine_options, command,
+	                                      engine_out), 1);
+	free(command);
+	ck_assert_int_ne(engine_options.use_nnue, 0);
+	ck_assert_int_eq(ev_hashfull(), 0);
+
+	search_depth_3(&engine_options, engine_out);
+	ck_assert_int_gt(ev_hashfull(), 0);
+
+	command = xstrdup("name UseNNUE value false");
+	ck_assert_int_eq(uci_handle_setoption(&engine_options, command,
+	                                      engine_out), 1);
+	free(command);
+	ck_assert_int_eq(engine_options.use_nnue, 0);
+	ck_assert_int_eq(ev_hashfull(), 0);
+
+	/* Setting the same value again keeps the cache.  */
+	search_depth_3(&engine_options, engine_out);
+	command = xstrdup("name UseNNUE value false");
+	ck_assert_int_eq(uci_handle_setoption(&engine_options, command,
+	                                      engine_out), 1);
+	free(command);
+	ck_assert_int_gt(ev_hashfull(), 0);
+}
+END_TEST
+
+/* Set up POSITION, search with six seconds on both clocks, and return
+ * the time budget that is reported in debug mode.
+ */
+static long long
+time_budget(UCIEngineOptions *options, FILE *out, const char *output,
+            const char *position)
+{
+	FILE *saved_out = lisco.uci.out;
+	char *command = xstrdup(position);
+	const char *line;
+	long long budget;
+
+	ck_assert_int_eq(uci_handle_position(options, command, out), 1);
+	free(command);
+
+	fflush(out);
+	line = output + strlen(output);
+	lisco.uci.out = out;
+	command = xstrdup("wtime 6000 btime 6000");
+	ck_assert_int_eq(uci_handle_go(options, command, out), 1);
+	free(command);
+	lisco.uci.out = saved_out;
+
+	fflush(out);
+	line = strstr(line, "info string time budget ");
+	ck_assert_ptr_nonnull(line);
+	ck_assert_int_eq(sscanf(line, "info string time budget %lld", &budget),
+	                 1);
+
+	return budget;
+}
+
+START_TEST(test_uci_time_budget)
+{
+	const char output[16384];
+	char *command;
+	long long opening, ending;
+
+	INIT_UCI(engine_options, output, NULL, NULL, engine_out, "[memstream]");
+
+	command = xstrdup("on");
+	ck_assert_int_eq(uci_handle_debug(&engine_options, command, engine_out),
+	                 1);
+	free(command);
+
+	/* Fewer moves are left in the ending, and each gets more time.  */
+	opening = time_budget(&engine_options, engine_out, output,
+	                      "startpos");
+	ending = time_budget(&engine_options, engine_out, output,
+	                     "fen 8/5pk1/6p1/8/8/6P1/5PK1/8 w - - 0 40");
+	ck_assert_int_gt(opening, 0);
+	ck_assert_int_gt(ending, opening);
+}
+END_TEST
+
+START_TEST(test_uci_setoption)
+{
+	const char output[1024];
+	int status;
+	char *command;
+
+	INIT_UCI(engine_options, output, NULL, NULL, engine_out, "[memstream]");
+
+	command = xstrdup("name Hash value 2");
+	status = uci_handle_setoption(&engine_options, command, engine_out);
+	free(command);
+	ck_assert_int_eq(status, 1);
+	ck_assert_uint_eq(engine_options.hash_size, 2);
+
+	command = xstrdup("name Threads value 4");
+	status = uci_handle_setoption(&engine_options, command, engine_out);
+	free(command);
+	ck_assert_int_eq(engine_options.option_threads, 4);
+
+	command = xstrdup("name Eval Cache value 1");
+	status = uci_handle_setoption(&engine_options, command, engine_out);
+	free(command);
+	ck_assert_uint_eq(engine_options.ev_size, 1);
+
+	command = xstrdup("name Clear Hash");
+	status = uci_handle_setoption(&engine_options, command, engine_out);
+	free(command);
+	ck_assert_int_eq(status, 1);
+
+	fflush(engine_out);
+	ck_assert_str_eq(output, "");
+
+	/* Out of range values are rejected.  */
+	command = xstrdup("name Hash value 0");
+	status = uci_handle_setoption(&engine_options, command, engine_out);
+	free(command);
+	ck_assert_int_eq(status, 1);
+	ck_assert_uint_eq(engine_options.hash_size, 2);
+
+	command = xstrdup("name Pawn Hash value lots");
+	status = uci_handle_setoption(&engine_options, command, engine_out);
+	free(command);
+	ck_assert_uint_eq(engine_options.pawn_size, LISCO_DEFAULT_PAWN_SIZE);
+
+	fflush(engine_out);
+	ck_assert_ptr_nonnull(strstr(output, "option 'Hash' must be between"));
+	ck_assert_ptr_nonnull(strstr(output, "option 'Pawn Hash' must be between"));
+
+	/* Restore the defaults for the other tests.  */
+	tt_init((size_t) LISCO_DEFAULT_TT_SIZE << 20);
+	init_ev_hash((size_t) LISCO_DEFAULT_EV_SIZE << 20);
+}
+END_TEST
+
+START_TEST(test_uci_multipv)
+{
+	const char output[4096];
+	int status;
+	char *command;
+	FILE *saved_out = lisco.uci.out;
+	const char *line, *previous;
+	int score, previous_score;
+
+	INIT_UCI(engine_options, output, NULL, NULL, engine_out, "[memstream]");
+
+	command = xstrdup("name MultiPV value 3");
+	status = uci_handle_setoption(&engine_options, command, engine_out);
+	free(command);
+	ck_assert_int_eq(status, 1);
+	ck_assert_int_eq(engine_options.multipv, 3);
+
+	/* The search reports to the global options.  */
+	lisco.uci.out = engine_out;
+	lisco.uci.multipv = engine_options.multipv;
+	chi_init_position(&lisco.position);
+	command = xstrdup("depth 2");
+	status = uci_handle_go(&engine_options, command, engine_out);
+	free(command);
+	lisco.uci.out = saved_out;
+	lisco.uci.multipv = 1;
+	ck_assert_int_eq(status, 1);
+
+	fflush(engine_out);
+
+	/* Three lines for the last iteration, the best first.  */
+	line = strstr(output, "info depth 2 ");
+	ck_assert_ptr_nonnull(line);
+	line = strstr(line, " multipv 1 ");
+	ck_assert_ptr_nonnull(line);
+	previous = line;
+	ck_assert_int_eq(sscanf(line, " multipv 1 score cp %d",
+	                        &previous_score), 1);
+	line = strstr(previous, " multipv 2 ");
+	ck_assert_ptr_nonnull(line);
+	ck_assert_int_eq(sscanf(line, " multipv 2 score cp %d", &score), 1);
+	ck_assert_int_ge(previous_score, score);
+	previous_score = score;
+	line = strstr(line, " multipv 3 ");
+	ck_assert_ptr_nonnull(line);
+	ck_assert_int_eq(sscanf(line, " multipv 3 score cp %d", &score), 1);
+	ck_assert_int_ge(previous_score, score);
+	ck_assert_ptr_null(strstr(output, "multipv 4"));
+}
+END_TEST
+
+START_TEST(test_uci_pv)
+{
+	const char output[4096];
+	int status;
+	char *command;
+	FILE *saved_out = lisco.uci.out;
+	char *line, *token, *end, *ponder;
+	chi_pos position;
+	chi_move move;
+	int num_moves = 0;
+	char expect[32];
+
+	INIT_UCI(engine_options, output, NULL, NULL, engine_out, "[memstream]");
+
+	lisco.uci.out = engine_out;
+	chi_init_position(&lisco.position);
+	command = xstrdup("depth 4");
+	status = uci_handle_go(&engine_options, command, engine_out);
+	free(command);
+	lisco.uci.out = saved_out;
+	ck_assert_int_eq(status, 1);
+
+	fflush(engine_out);
+
+	/* The variation of the last iteration is complete and legal.  */
+	line = strstr(output, "info depth 4 ");
+	ck_assert_ptr_nonnull(line);
+	while (strstr(line + 1, "info depth 4 "))
+		line = strstr(line + 1, "info depth 4 ");
+	line = strstr(line, " pv ") + 4;
+	end = strchr(line, '\n');
+	ck_assert_ptr_nonnull(end);
+	*end = '\0';
+
+	chi_init_position(&position);
+	ponder = NULL;
+	for (token = strtok(line, " "); token; token = strtok(NULL, " ")) {
+		ck_assert_int_eq(chi_parse_move(&position, &move, token), 0);
+		ck_assert_int_eq(chi_apply_move(&position, move), 0);
+		if (++num_moves == 2)
+			ponder = token;
+	}
+	ck_assert_int_ge(num_moves, 4);
+
+	/* The second move is the one to ponder on.  */
+	ck_assert_ptr_nonnull(ponder);
+	snprintf(expect, sizeof expect, " ponder %s\n", ponder);
+	ck_assert_ptr_nonnull(strstr(end + 1, expect));
+}
+END_TEST
+
 Suite *
 uci_engine_suite(void)
 {
@@ -184,6 +555,13 @@ uci_engine_suite(void)
 	tcase_add_test(tc_uci_parser, test_uci_uci);
 	tcase_add_test(tc_uci_parser, test_uci_debug);
 	tcase_add_test(tc_uci_parser, test_uci_position);
+	tcase_add_test(tc_uci_parser, test_uci_position_incremental);
+	tcase_add_test(tc_uci_parser, test_uci_ucinewgame);
+	tcase_add_test(tc_uci_parser, test_uci_use_nnue);
+	tcase_add_test(tc_uci_parser, test_uci_time_budget);
+	tcase_add_test(tc_uci_parser, test_uci_setoption);
+	tcase_add_test(tc_uci_parser, test_uci_multipv);
+	tcase_add_test(tc_uci_parser, test_uci_pv);
 	suite_add_tcase(suite, tc_uci_parser);
 
 	return suite;
@@ -20,6 +20,8 @@
 # include <config.h>
 #endif
 
+#include <string.h>
+
 #include <check.h>
 
 #include "xalloc.h"
@@ -85,6 +87,28 @@ START_TEST(test_num_cpus)
 }
 END_TEST
 
+START_TEST(test_xmalloc_huge)
+{
+	size_t sizes[] = { 1000, 3 << 20 };
+	size_t i, j, mapped;
+	unsigned char *ptr;
+
+	for (i = 0; i < sizeof sizes / sizeof sizes[0]; ++i) {
+		ptr = xmalloc_huge(sizes[i], &mapped);
+		ck_assert_ptr_nonnull(ptr);
+		ck_assert_uint_ge(mapped, sizes[i]);
+		ck_assert_uint_eq(((unsigned long) ptr) % 64, 0);
+		for (j = 0; j < mapped; j += 4096)
+			ck_assert_uint_eq(ptr[j], 0);
+		memset(ptr, 0xff, sizes[i]);
+		clear_memory(ptr, sizes[i], 2);
+		for (j = 0; j < sizes[i]; ++j)
+			ck_assert_uint_eq(ptr[j], 0);
+		free_huge(ptr, mapped);
+	}
+}
+END_TEST
+
 Suite *
 util_suite(void)
 {
@@ -101,6 +125,7 @@ util_suite(void)
 
 	tc_os = tcase_create("OS Features");
 	tcase_add_test(tc_os, test_num_cpus);
+	tcase_add_test(tc_os, test_xmalloc_huge);
 	suite_add_tcase(suite, tc_os);
 
 	return suite;
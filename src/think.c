@@ -26,93 +26,116 @@
 #include "libchi.h"
 
 #include "lisco.h"
+#include "profile.h"
 
 #define DEBUG_SEARCH 0
-#define DEBUG_TIME_CONTROL 0
 
 static void update_tree(Tree *tree, int ply, chi_pos *position, chi_move move);
 
 #if DEBUG_SEARCH
 static void
-print_line(FILE *stream, chi_pos *start, Line *line)
+debug_move(Tree *tree, int ply, chi_move move, const char *what)
 {
-	chi_pos position;
 	char *buf = NULL;
 	unsigned int bufsize;
-	int errnum;
-
-	chi_copy_pos(&position, start);
-	for (int i = 0; i < line->num_moves; ++i) {
-		chi_move move = line->moves[i];
-		errnum = chi_print_move(&position, line->moves[i], &buf, &bufsize, 0);
-		chi_apply_move(&position, move);
-		fprintf(stream, " %s", buf);
-	}
 
+	chi_print_move(&tree->position, move, &buf, &bufsize, 0);
+	fprintf(stderr, "%*s%s %s\n", 2 * ply, "", what, buf);
 	free(buf);
-	fprintf(stream, "<\n");
 }
 
 static void
-debug_start_search(Tree *tree, chi_move move)
+debug_start_search(Tree *tree, int ply, chi_move move)
 {
-	fprintf(stderr, "considering");
-	print_line(stderr, &lisco.position, &tree->line);
+	debug_move(tree, ply, move, "considering");
 }
 
 static void
-debug_end_search(Tree *tree, chi_move move)
+debug_end_search(Tree *tree, int ply, chi_move move)
 {
-	fprintf(stderr, "done considering");
-	print_line(stderr, &lisco.position, &tree->line);
+	debug_move(tree, ply, move, "done considering");
 }
 #endif
 
+/* Make MOVE followed by the variation of the next ply the principal
+ * variation at PLY.
+ */
 static void
-print_pv(Tree *tree, int depth)
+update_pv(Tree *tree, int ply, chi_move move)
 {
-	FILE *out = lisco.uci.out;
-	long elapsed = rdifftime(rtime(), tree->start_time);
-	long nps = elapsed ? 1000 * tree->nodes / elapsed : tree->nodes;
+	Line *pv = &tree->pv[ply];
+	const Line *next = &tree->pv[ply + 1];
+	unsigned int num_moves = next->num_moves;
+
+	if (num_moves > MAX_PV - 1)
+		num_moves = MAX_PV - 1;
+
+	pv->moves[0] = move;
+	memcpy(pv->moves + 1, next->moves, num_moves * sizeof *pv->moves);
+	pv->num_moves = num_moves + 1;
+}
+
+/* Print line K of the MultiPV lines.  */
+static void
+print_pv(Tree *tree, int k)
+{
+	FILE *out = tree->out;
+	long elapsed = tc_elapsed(tree);
+	unsigned long long nodes = tree->nodes + tree->stats.qnodes;
+	long nps = elapsed ? 1000 * nodes / elapsed : nodes;
 	char *buf = NULL;
 	unsigned int bufsize;
+	const Line *line = &tree->multipv_lines[k];
+	chi_color_t on_move = chi_on_move(&tree->position);
+	unsigned int i;
 
-	chi_pos position;
-	chi_copy_pos(&position, &tree->position);
+	if (!out)
+		return;
 
-	fprintf(out, "info depth %d multipv 1 score cp %d nodes %llu nps %ld"
-			" tbhits %llu time %ld pv",
-			tree->depth, tree->score, tree->nodes, nps, tree->tt_hits, elapsed);
+	fprintf(out, "info depth %d seldepth %d multipv %d score cp %d"
+			" nodes %llu nps %ld hashfull %d tbhits %llu time %ld pv",
+			tree->depth, tree->stats.seldepth, k + 1,
+			tree->multipv_scores[k], nodes, nps, tt_hashfull(),
+			tree->stats.tb_hits, elapsed);
 
-	Line *line = &tree->line;
-	for (int i = 0; i < line->num_moves; ++i) {
-		chi_move move = line->moves[i];
-		chi_coordinate_notation(line->moves[i], chi_on_move(&position), &buf, &bufsize);
-		chi_apply_move(&position, move);
+	for (i = 0; i < line->num_moves; ++i) {
+		chi_coordinate_notation(line->moves[i], on_move, &buf, &bufsize);
 		fprintf(out, " %s", buf);
+		on_move = !on_move;
 	}
 	free(buf);
 
 	fprintf(out, "\n");
 }
 
-static void
-time_control(Tree *tree)
+/* Insert the principal variation at the root with SCORE into the sorted
+ * MultiPV lines of the current iteration.  Returns the new lower bound
+ * for the root moves, the score of the last line, once all lines are
+ * filled.
+ */
+static int
+multipv_insert(Tree *tree, int score)
 {
-	struct timeval now = rtime();
-	long elapsed = rdifftime(now, tree->start_time);
-	unsigned long long nps = 1000 * (tree->nodes / elapsed);
-	tree->nodes_to_tc = nps / 10;
-#if DEBUG_TIME_CONTROL
-	fprintf(stderr, "elapsed: %ld ms (of %lld ms), nodes: %llu, nps: %lld, nodes to next tc: %lld.\n",
-		elapsed, tree->fixed_time, tree->nodes, nps, tree->nodes_to_tc);
-#endif
-	if (elapsed > tree->fixed_time - 200) {
-		tree->move_now = 1;
-#if DEBUG_TIME_CONTROL
-		fprintf(stderr, "Time's up, move now!\n");
-#endif
+	int i;
+
+	if (tree->pv_count < tree->multipv)
+		++tree->pv_count;
+
+	for (i = tree->pv_count - 1; i > 0 && tree->multipv_scores[i - 1] < score;
+	     --i) {
+		tree->multipv_lines[i] = tree->multipv_lines[i - 1];
+		tree->multipv_scores[i] = tree->multipv_scores[i - 1];
 	}
+	tree->multipv_lines[i] = tree->pv[0];
+	tree->multipv_scores[i] = score;
+
+	tree->bestmove = tree->multipv_lines[0].moves[0];
+	tree->score = tree->multipv_scores[0];
+
+	if (tree->pv_count < tree->multipv)
+		return -INF;
+
+	return tree->multipv_scores[tree->pv_count - 1];
 }
 
 static int
@@ -124,11 +147,18 @@ alphabeta(Tree *tree, int depth, int alpha, int beta)
 	int ply = tree->depth - depth;
 
 	++tree->nodes;
-	if (--tree->nodes_to_tc <= 0 && !tree->max_depth) {
-		time_control(tree);
+	if (tree->max_nodes && tree->nodes >= tree->max_nodes) {
+		tree->move_now = 1;
 	}
 
-	if (chi_game_over(position, &result)) {
+	tree->pv[ply].num_moves = 0;
+	if (ply > tree->stats.seldepth)
+		tree->stats.seldepth = ply;
+
+	PROFILE_BEGIN(PROFILE_GAME_OVER);
+	int game_over = chi_game_over(position, &result);
+	PROFILE_END(PROFILE_GAME_OVER);
+	if (game_over) {
 		if (chi_result_is_white_win(result) || chi_result_is_black_win(result)) {
 			return MATE + (tree->depth - depth);
 		} else {
@@ -136,6 +166,20 @@ alphabeta(Tree *tree, int depth, int alpha, int beta)
 		}
 	}
 
+	/* Endings with a known result need no search.  A position only
+	 * enters the tables by a capture or a pawn move, and the probe there
+	 * cuts off everything below.  If the root is already in the tables,
+	 * its children are probed, and the horizon is probed anyway.
+	 */
+	if (ply > 0
+	    && (position->half_move_clock == 0 || ply == 1 || depth == 0)
+	    && tb_probe(position, ply, &value)) {
+		++tree->stats.tb_hits;
+		return value;
+	}
+	if (ply > 0 && recognize_endgame(position, &value) == ENDGAME_EXACT)
+		return value;
+
 	if (depth == 0) {
 #if DEBUG_SEARCH
 		fprintf (stderr, "\tstart quiescence search (ply = %d, alpha = %d, beta = %d)\n",
@@ -151,11 +195,11 @@ alphabeta(Tree *tree, int depth, int alpha, int beta)
 
 	/*
 	int alpha, beta;
-	++tree->tt_probes;
+	++tree->stats.tt_probes;
 	unsigned int tt_hit = probe_tt (position, tree->signatures[ply], depth,
 			&alpha, &beta);
 	if (tt_hit != HASH_UNKNOWN) {
-		++tree->tt_hits;
+		++tree->stats.tt_hits;
 #if DEBUG_SEARCH
 		fprintf(stderr, "\ttable hit type %u.\n", tt_hit);
 #endif
@@ -173,49 +217,69 @@ alphabeta(Tree *tree, int depth, int alpha, int beta)
 	*/
 
 	MoveSelector selector;
+	PROFILE_BEGIN(PROFILE_MOVE_SELECTION);
 	move_selector_init(&selector, tree,
 		tree->depth == depth && tree->bestmove ? tree->bestmove : 0);
+	PROFILE_END(PROFILE_MOVE_SELECTION);
 
-	++tree->line.num_moves;
 	chi_move move;
+	int searched = 0;
 	while ((move = move_selector_next(&selector))) {
 		if (tree->move_now) {
-			return alpha;
+			break;
 		}
 
-		tree->line.moves[tree->line.num_moves - 1] = move;
-
 #if DEBUG_SEARCH
-		debug_start_search(tree, move);
+		debug_start_search(tree, ply, move);
 #endif
 
+		PROFILE_BEGIN(PROFILE_APPLY_MOVE);
 		chi_apply_move(position, move);
+		PROFILE_END(PROFILE_APPLY_MOVE);
 		update_tree(tree, ply, position, move);
 
 		value = -alphabeta(tree, depth - 1, -beta, -alpha);
+		++searched;
 
 		/*
 		store_tt_entry(position, tree->signatures[ply + 1], move, depth, value,
 				HASH_EXACT);
 		*/
 
+		PROFILE_BEGIN(PROFILE_UNAPPLY_MOVE);
 		chi_unapply_move(position, move);
+		PROFILE_END(PROFILE_UNAPPLY_MOVE);
+
+		/* The result of an aborted search is meaningless.  */
+		if (tree->move_now)
+			break;
 
 #if DEBUG_SEARCH
-		debug_end_search(tree, move);
+		debug_end_search(tree, ply, move);
 		fprintf(stderr, "\tvalue: %d (best: %d)\n", value, alpha);
 #endif
 
 		if (value >= beta) {
 			/* Fail high.  */
+			++tree->stats.cutoffs;
+			if (searched == 1)
+				++tree->stats.first_move_cutoffs;
 #if DEBUG_SEARCH
 			fprintf(stderr, "\tfail high: value(%d) >= beta(%d)\n", value, beta);
 #endif
-			--tree->line.num_moves;
 			return beta;
 		}
 
 		if (value > alpha) {
+			/* With more than one line, the root moves only have to
+			 * beat the worst line.
+			 */
+			update_pv(tree, ply, move);
+			if (depth == tree->depth && tree->multipv > 1) {
+				alpha = multipv_insert(tree, value);
+				continue;
+			}
+
 			alpha = value;
 #if DEBUG_SEARCH
 			fprintf(stderr, "\tNew best move with best value %d.\n", alpha);
@@ -226,13 +290,14 @@ alphabeta(Tree *tree, int depth, int alpha, int beta)
 #endif
 				tree->bestmove = move;
 				tree->score = value;
-				print_pv(tree, depth);
+				tree->pv_count = 1;
+				tree->multipv_lines[0] = tree->pv[0];
+				tree->multipv_scores[0] = value;
+				print_pv(tree, 0);
 			}
 		}
 	}
 
-	--tree->line.num_moves;
-
 	return alpha;
 }
 
@@ -248,11 +313,18 @@ alphabeta_move_list(Tree *tree, int depth, int alpha, int beta, MoveList *list)
 	int ply = tree->depth - depth;
 
 	++tree->nodes;
-	if (--tree->nodes_to_tc <= 0 && !tree->max_depth) {
-		time_control(tree);
+	if (tree->max_nodes && tree->nodes >= tree->max_nodes) {
+		tree->move_now = 1;
 	}
 
-	if (chi_game_over(position, &result)) {
+	tree->pv[ply].num_moves = 0;
+	if (ply > tree->stats.seldepth)
+		tree->stats.seldepth = ply;
+
+	PROFILE_BEGIN(PROFILE_GAME_OVER);
+	int game_over = chi_game_over(position, &result);
+	PROFILE_END(PROFILE_GAME_OVER);
+	if (game_over) {
 		if (chi_result_is_white_win(result) || chi_result_is_black_win(result)) {
 			return MATE + (tree->depth - depth);
 		} else {
@@ -273,17 +345,16 @@ alphabeta_move_list(Tree *tree, int depth, int alpha, int beta, MoveList *list)
 		return qscore;
 	}
 
-	++tree->line.num_moves;
 	for (size_t i = 0; i < list->num_moves; ++i) {
 		chi_move move = list->moves[i];
 
-		tree->line.moves[tree->line.num_moves - 1] = move;
-
 #if DEBUG_SEARCH
-		debug_start_search(tree, move);
+		debug_start_search(tree, ply, move);
 #endif
 
+		PROFILE_BEGIN(PROFILE_APPLY_MOVE);
 		chi_apply_move(position, move);
+		PROFILE_END(PROFILE_APPLY_MOVE);
 		update_tree(tree, ply, position, move);
 
 		value = -alphabeta(tree, depth - 1, -beta, -alpha);
@@ -293,10 +364,16 @@ alphabeta_move_list(Tree *tree, int depth, int alpha, int beta, MoveList *list)
 				HASH_EXACT);
 		*/
 
+		PROFILE_BEGIN(PROFILE_UNAPPLY_MOVE);
 		chi_unapply_move(position, move);
+		PROFILE_END(PROFILE_UNAPPLY_MOVE);
+
+		/* The result of an aborted search is meaningless.  */
+		if (tree->move_now)
+			break;
 
 #if DEBUG_SEARCH
-		debug_end_search(tree, move);
+		debug_end_search(tree, ply, move);
 		fprintf(stderr, "\tvalue: %d (best: %d)\n", value, alpha);
 #endif
 
@@ -305,11 +382,19 @@ alphabeta_move_list(Tree *tree, int depth, int alpha, int beta, MoveList *list)
 #if DEBUG_SEARCH
 			fprintf(stderr, "\tfail high: value(%d) >= beta(%d)\n", value, beta);
 #endif
-			--tree->line.num_moves;
 			return beta;
 		}
 
 		if (value > alpha) {
+			/* With more than one line, the root moves only have to
+			 * beat the worst line.
+			 */
+			update_pv(tree, ply, move);
+			if (depth == tree->depth && tree->multipv > 1) {
+				alpha = multipv_insert(tree, value);
+				continue;
+			}
+
 			alpha = value;
 #if DEBUG_SEARCH
 			fprintf(stderr, "\tNew best move with best value %d.\n", alpha);
@@ -321,24 +406,58 @@ alphabeta_move_list(Tree *tree, int depth, int alpha, int beta, MoveList *list)
 				tree->bestmove = move;
 				tree->score =
 					chi_on_move(position) == chi_white ? value : -value;
-				print_pv(tree, depth);
+				tree->pv_count = 1;
+				tree->multipv_lines[0] = tree->pv[0];
+				tree->multipv_scores[0] = value;
+				print_pv(tree, 0);
 			}
 		}
 	}
 
-	--tree->line.num_moves;
-
 	return alpha;
 }
 
+/* Order the root moves for the MultiPV search.  The lines of the last
+ * iteration come first, so that the bound for the other moves is tight
+ * from the start.
+ */
+static void
+order_root_moves(Tree *tree, MoveList *list, chi_move *moves)
+{
+	chi_move legal[CHI_MAX_MOVES];
+	chi_move *candidates = legal;
+	size_t num_candidates, i;
+	int k;
+
+	if (tree->searchmoves.num_moves) {
+		candidates = tree->searchmoves.moves;
+		num_candidates = tree->searchmoves.num_moves;
+	} else {
+		num_candidates = chi_legal_moves(&tree->position, legal) - legal;
+	}
+
+	list->moves = moves;
+	list->num_moves = 0;
+	for (k = 0; k < tree->pv_count; ++k)
+		moves[list->num_moves++] = tree->multipv_lines[k].moves[0];
+	for (i = 0; i < num_candidates; ++i) {
+		for (k = 0; k < tree->pv_count; ++k)
+			if (candidates[i] == tree->multipv_lines[k].moves[0])
+				break;
+		if (k == tree->pv_count)
+			moves[list->num_moves++] = candidates[i];
+	}
+}
+
 static int
 root_search(Tree *tree)
 {
-	int depth, score;
+	int depth, score, k;
 	chi_bool forced_mate;
+	chi_move moves[CHI_MAX_MOVES];
+	MoveList root_moves;
 
-	tree->start_time = rtime();
-	tree->move_now = 0;
+	tc_start(tree);
 	tree->score = 0;
 
 	int max_depth = tree->max_depth ? tree->max_depth : MAX_PLY;
@@ -348,43 +467,87 @@ root_search(Tree *tree)
 		fprintf(stderr, "Deepening search to maximum %d plies.\n", depth);
 #endif
 		tree->depth = depth;
-
-		if (tree->searchmoves.num_moves) {
-			score = alphabeta_move_list(tree, depth, -INF, +INF,
+		stats_start_iteration(tree);
+
+		/* The lines are collected from scratch in every iteration.  */
+		if (tree->multipv > 1) {
+			order_root_moves(tree, &root_moves, moves);
+			tree->pv_count = 0;
+			alphabeta_move_list(tree, depth, -INF, +INF, &root_moves);
+		} else if (tree->searchmoves.num_moves) {
+			tree->pv_count = 0;
+			alphabeta_move_list(tree, depth, -INF, +INF,
 					&tree->searchmoves);
 		} else {
-			score = alphabeta(tree, depth, -INF, +INF);
+			tree->pv_count = 0;
+			alphabeta(tree, depth, -INF, +INF);
+		}
+
+		if (!tree->move_now) {
+			stats_end_iteration(tree);
+			if (tree->multipv > 1)
+				for (k = 0; k < tree->pv_count; ++k)
+					print_pv(tree, k);
 		}
 
+		score = tree->multipv_scores[0];
 		forced_mate = score == -MATE -depth;
 
-		if (chi_on_move(&lisco.position) == chi_black)
-			score = -score;
+		if (tree->move_now)
+			break;
 
-		lisco.bestmove = tree->bestmove;
-		lisco.bestmove_found = 1;
-		lisco.pondermove_found = 0;
 		if (forced_mate) {
 			break;
 		}
 
-		if (tree->move_now)
+		if (!tc_next_iteration(tree, tree->bestmove, score))
 			break;
 	}
 
+	tc_stop(tree);
+
+	if (chi_on_move(&tree->position) == chi_black)
+		score = -score;
+
 	return score;
 }
 
 void
 think(Tree *tree)
+{
+	tree->out = lisco.uci.out;
+	if (search_position(tree, &lisco.position) != 0)
+		return;
+
+	if (tree->bestmove) {
+		const Line *pv = &tree->multipv_lines[0];
+
+		lisco.bestmove = tree->bestmove;
+		lisco.bestmove_found = 1;
+		lisco.pondermove_found = pv->num_moves > 1;
+		if (lisco.pondermove_found)
+			lisco.pondermove = pv->moves[1];
+	}
+}
+
+int
+search_position(Tree *tree, const chi_pos *pos)
 {
 	int score;
 
-	if (chi_game_over(&lisco.position, NULL)) return;
+	if (chi_game_over(pos, NULL))
+		return -1;
 
-	chi_copy_pos(&tree->position, &lisco.position);
+	chi_copy_pos(&tree->position, pos);
 
 	tree->signatures[0] = chi_zk_signature(lisco.zk_handle, &tree->position);
+	tree->pawn_signatures[0] = chi_zk_pawn_signature(lisco.zk_handle,
+		&tree->position);
+
+	tree->nnue = lisco.uci.use_nnue && nnue_loaded();
+	tree->multipv = lisco.uci.multipv > 1 ? lisco.uci.multipv : 1;
+	if (tree->nnue)
+		nnue_refresh(&tree->accumulators[0], &tree->position);
 
 	score = root_search(tree);
 
@@ -392,11 +555,21 @@ think(Tree *tree)
 	//fprintf(stderr, "score: %d\n", score);
 	//fprintf(stderr, "info nodes searched: %lu\n", tree.nodes);
 	//fprintf(stderr, "info nodes evaluate_locald: %lu\n", tree.evals);
+
+	return 0;
 }
 
 static void
 update_tree(Tree *tree, int ply, chi_pos *position, chi_move move)
 {
+	/* The move has already been applied.  */
+	chi_color_t mover = !chi_on_move(position);
+
 	tree->signatures[ply + 1] = chi_zk_update_signature(lisco.zk_handle,
-		tree->signatures[ply], move, chi_on_move(position));
+		tree->signatures[ply], move, mover);
+	tree->pawn_signatures[ply + 1] = chi_zk_update_pawn_signature(
+		lisco.zk_handle, tree->pawn_signatures[ply], move, mover);
+	if (tree->nnue)
+		nnue_update(&tree->accumulators[ply],
+		            &tree->accumulators[ply + 1], move, mover);
 }
\ No newline at end of file
@@ -20,12 +20,23 @@
 # include <config.h>
 #endif
 
+#include <errno.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
 
 #include "lisco.h"
 
+#define DEBUG_TIME_CONTROL 0
+
+/* The hard limit is at most this multiple of the soft limit.  */
+#define HARD_LIMIT_FACTOR 5
+
 static void allocate_time(Tree *tree, SearchParams *params);
 static double moves_to_go(chi_pos *position);
+static void *timer_main(void *closure);
 
 int
 process_search_params(Tree *tree, SearchParams *params)
@@ -34,21 +45,24 @@ process_search_params(Tree *tree, SearchParams *params)
 		params->depth = 2 * params->mate - 1;
 	}
 
+	tree->soft_limit = tree->hard_limit = 0;
+	tree->flexible_time = 0;
+	tree->max_nodes = 0;
+
 	if (params->depth) {
 		tree->max_depth = params->depth;
 	} else {
 		/* If no other hint given, use 30 seconds per move.  */
-		tree->fixed_time = 30000;
+		tree->soft_limit = tree->hard_limit = 30000;
 	}
 
-	/* Initial value for calibration.  */
-	tree->nodes_to_tc = 10000;
-
 	if (params->movetime) {
-		tree->fixed_time = params->movetime;
+		tree->soft_limit = params->movetime > params->overhead
+			? params->movetime - params->overhead : 1;
+		tree->hard_limit = tree->soft_limit;
 	} else if (params->nodes) {
-		tree->nodes_to_tc = params->nodes;
-		tree->fixed_time = 0;
+		tree->max_nodes = params->nodes;
+		tree->soft_limit = tree->hard_limit = 0;
 	} else if (params->mytime) {
 		allocate_time(tree, params);
 	}
@@ -72,13 +86,166 @@ allocate_time(Tree *tree, SearchParams *params)
 		mtg = params->movestogo;
 	}
 
-	double time_left = params->mytime + params->movestogo * params->myinc;
+	// The increment for this move is already included in the time left.
+	// The overhead is lost for every move.
+	double time_left = params->mytime + (mtg - 1) * params->myinc
+		- mtg * params->overhead;
+	double available = (double) params->mytime - params->overhead;
+
+	if (available < 1)
+		available = 1;
+
+	tree->soft_limit = (long long int) floor(0.5 + time_left / mtg);
+	if (tree->soft_limit < 1)
+		tree->soft_limit = 1;
+	if (tree->soft_limit > available)
+		tree->soft_limit = available;
+	tree->hard_limit = HARD_LIMIT_FACTOR * tree->soft_limit;
+	if (tree->hard_limit > available)
+		tree->hard_limit = available;
+	tree->flexible_time = 1;
+}
+
+void
+tc_start(Tree *tree)
+{
+	pthread_condattr_t attr;
+	int errnum;
+
+	tree->start_time = rclock();
+	tree->move_now = 0;
+	tree->last_bestmove = 0;
+	tree->last_score = 0;
+	tree->bestmove_changes = 0;
+	tree->timer_running = 0;
+
+	if (!tree->hard_limit)
+		return;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&tree->timer_cond, &attr);
+	pthread_condattr_destroy(&attr);
+	pthread_mutex_init(&tree->timer_mutex, NULL);
+
+	tree->timer_cancelled = 0;
+	errnum = pthread_create(&tree->timer_thread, NULL, timer_main, tree);
+	if (errnum) {
+		fprintf(stderr, "cannot start timer thread: %s\n",
+		        strerror(errnum));
+		pthread_cond_destroy(&tree->timer_cond);
+		pthread_mutex_destroy(&tree->timer_mutex);
+		return;
+	}
+	tree->timer_running = 1;
+}
+
+void
+tc_stop(Tree *tree)
+{
+	if (!tree->timer_running)
+		return;
+
+	pthread_mutex_lock(&tree->timer_mutex);
+	tree->timer_cancelled = 1;
+	pthread_cond_signal(&tree->timer_cond);
+	pthread_mutex_unlock(&tree->timer_mutex);
+
+	pthread_join(tree->timer_thread, NULL);
+	pthread_cond_destroy(&tree->timer_cond);
+	pthread_mutex_destroy(&tree->timer_mutex);
+	tree->timer_running = 0;
+}
+
+long long int
+tc_elapsed(const Tree *tree)
+{
+	return rclock() - tree->start_time;
+}
+
+static void *
+timer_main(void *closure)
+{
+	Tree *tree = closure;
+	long long int deadline = tree->start_time + tree->hard_limit;
+	struct timespec abstime;
+
+	abstime.tv_sec = deadline / 1000;
+	abstime.tv_nsec = (deadline % 1000) * 1000000;
+
+	pthread_mutex_lock(&tree->timer_mutex);
+	while (!tree->timer_cancelled) {
+		if (pthread_cond_timedwait(&tree->timer_cond, &tree->timer_mutex,
+		                           &abstime)
+		    == ETIMEDOUT) {
+			tree->move_now = 1;
+#if DEBUG_TIME_CONTROL
+			fprintf(stderr, "Time's up, move now!\n");
+#endif
+			break;
+		}
+	}
+	pthread_mutex_unlock(&tree->timer_mutex);
+
+	return NULL;
+}
+
+/* If the best move keeps changing or the score drops, the position is
+ * difficult and deserves more time.  If the best move is stable, the
+ * search stops early.
+ */
+int
+tc_next_iteration(Tree *tree, chi_move bestmove, int score)
+{
+	double scale;
+	long long int elapsed, limit;
+	int drop;
+
+	tree->bestmove_changes /= 2;
+	if (tree->last_bestmove && bestmove != tree->last_bestmove)
+		tree->bestmove_changes += 1;
+
+	/* Stable best move 0.7, one recent change about 1.2, at most 2.  */
+	scale = 0.7 + 0.5 * tree->bestmove_changes;
+	if (scale > 2)
+		scale = 2;
+
+	/* Up to 50 % more for a score that dropped by a pawn or more.  */
+	drop = tree->last_bestmove ? tree->last_score - score : 0;
+	if (drop > 100)
+		drop = 100;
+	if (drop > 0)
+		scale *= 1 + drop / 200.0;
+
+	tree->last_bestmove = bestmove;
+	tree->last_score = score;
+
+	if (!tree->soft_limit)
+		return 1;
+
+	elapsed = tc_elapsed(tree);
+
+	/* With a fixed time, the rest of the time can still be used.  The
+	 * best move of an iteration that is aborted is kept.
+	 */
+	if (!tree->flexible_time)
+		return elapsed < tree->soft_limit;
+
+	limit = (long long int) (scale * tree->soft_limit);
+	if (limit > tree->hard_limit)
+		limit = tree->hard_limit;
+
+#if DEBUG_TIME_CONTROL
+	fprintf(stderr, "elapsed: %lld ms, soft limit %lld ms (scale %.2f),"
+	        " hard limit: %lld ms.\n",
+	        elapsed, limit, scale, tree->hard_limit);
+#endif
 
-	// FIXME! This should not be fixed_time but have a better name.
-	// FIXME! Depending on the volatility of the position, there should be
-	// a time cushion that can be used if the evaluation changes a lot between
-	// iterations.
-	tree->fixed_time = (int) floor(0.5 + time_left / mtg);
+	/* The next iteration takes several times as long as all previous
+	 * ones together.  If it is unlikely to finish in time, the time is
+	 * saved for later moves.
+	 */
+	return 2 * elapsed < limit;
 }
 
 /* Estimate how many moves until the end of the game.  We never assume less
@@ -16,12 +16,39 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+/* The transposition table can be saved to a file and mapped back into
+ * memory:
+ *
+ *	magic		8 bytes "LISCOTT1"
+ *	zobrist		uint32, CHI_ZK_VERSION
+ *	entry size	uint32, size of one entry in bytes
+ *	byte order	uint32, 0x01020304 in the byte order of the entries
+ *	reserved	uint32, 0
+ *	entries		uint64, number of entries
+ *	start		uint64, signature of the start position
+ *	reserved	16 bytes, 0
+ *	entries		TTEntry[entries]
+ *
+ * The numbers in the header are little-endian, except for the byte
+ * order mark.  The entries are stored as they are in memory, so that the
+ * file can be used without copying.  A file from a machine with another
+ * byte order or structure layout, or with other zobrist keys, is
+ * rejected.
+ */
+
 #ifdef HAVE_CONFIG_H
 # include <config.h>
 #endif
 
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include <libchi.h>
 
@@ -41,9 +68,19 @@ typedef struct TTEntry {
 // Roughly 0.6 MB.
 #define MIN_TT_SIZE (sizeof (TTEntry) * 20000)
 
-static TTEntry *tt = NULL;
-static void *tt_free_me = NULL;
-static size_t tt_size = 0;
+#define TT_MAGIC "LISCOTT1"
+#define TT_HEADER_SIZE 64
+#define TT_BYTE_ORDER 0x01020304
+
+/* Every searching thread has its own table.  */
+static __thread TTEntry *tt = NULL;
+static __thread size_t tt_size = 0;
+/* The allocated block that TT points into, or NULL.  */
+static __thread void *tt_mem = NULL;
+static __thread size_t tt_mem_size = 0;
+/* The mapping of a snapshot that TT points into, or NULL.  */
+static __thread void *tt_map = NULL;
+static __thread size_t tt_map_size = 0;
 
 void
 tt_init(size_t size)
@@ -53,26 +90,174 @@ tt_init(size_t size)
 	if (size < MIN_TT_SIZE)
 		size = MIN_TT_SIZE;
 	
-	tt_size = size;
-
-	tt = xmalloc_aligned(&tt_free_me, 64, tt_size * sizeof *tt);
+	tt_size = size / sizeof *tt;
 
-	tt_clear();
+	/* The memory is already zeroed.  Clearing it here would place all
+	 * pages now instead of when the search thread first touches them.
+	 */
+	tt_mem = xmalloc_huge(tt_size * sizeof *tt, &tt_mem_size);
+	tt = tt_mem;
 }
 
 void
 tt_clear(void)
 {
-	memset(tt, 0, tt_size * sizeof *tt);
+	clear_memory(tt, tt_size * sizeof *tt, lisco.uci.option_threads);
 }
 
 void
 tt_destroy(void)
 {
-	if (tt_free_me)
-		free(tt_free_me);
+	free_huge(tt_mem, tt_mem_size);
+	if (tt_map)
+		munmap(tt_map, tt_map_size);
 	
-	tt_free_me = NULL;
+	tt_mem = NULL;
+	tt_mem_size = 0;
+	tt_map = NULL;
+	tt_map_size = 0;
 	tt = NULL;
 	tt_size = 0;
 }
+
+int
+tt_hashfull(void)
+{
+	size_t i, sample = tt_size < 1000 ? tt_size : 1000;
+	int used = 0;
+
+	for (i = 0; i < sample; ++i)
+		if (tt[i].signature_hi || tt[i].signature_lo || tt[i].move)
+			++used;
+
+	return sample ? used * 1000 / sample : 0;
+}
+
+static void
+write_u32(unsigned char *bytes, unsigned int value)
+{
+	bytes[0] = value;
+	bytes[1] = value >> 8;
+	bytes[2] = value >> 16;
+	bytes[3] = value >> 24;
+}
+
+static unsigned int
+read_u32(const unsigned char *bytes)
+{
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16)
+		| ((unsigned int) bytes[3] << 24);
+}
+
+static void
+write_u64(unsigned char *bytes, bitv64 value)
+{
+	write_u32(bytes, value);
+	write_u32(bytes + 4, value >> 32);
+}
+
+static bitv64
+read_u64(const unsigned char *bytes)
+{
+	return read_u32(bytes) | ((bitv64) read_u32(bytes + 4) << 32);
+}
+
+/* The signature of the start position tells whether the zobrist keys
+ * are still the same.
+ */
+static bitv64
+start_signature(void)
+{
+	chi_pos pos;
+
+	chi_init_position(&pos);
+
+	return chi_zk_signature(lisco.zk_handle, &pos);
+}
+
+int
+tt_save(const char *filename)
+{
+	unsigned char header[TT_HEADER_SIZE];
+	unsigned int byte_order = TT_BYTE_ORDER;
+	FILE *file;
+	int errnum;
+
+	memset(header, 0, sizeof header);
+	memcpy(header, TT_MAGIC, 8);
+	write_u32(header + 8, CHI_ZK_VERSION);
+	write_u32(header + 12, sizeof *tt);
+	memcpy(header + 16, &byte_order, 4);
+	write_u64(header + 24, tt_size);
+	write_u64(header + 32, start_signature());
+
+	file = fopen(filename, "wb");
+	if (!file)
+		return -1;
+
+	if (fwrite(header, 1, sizeof header, file) != sizeof header
+	    || fwrite(tt, sizeof *tt, tt_size, file) != tt_size) {
+		errnum = errno;
+		fclose(file);
+		errno = errnum;
+		return -1;
+	}
+
+	return fclose(file);
+}
+
+int
+tt_load(const char *filename)
+{
+	struct stat st;
+	unsigned char *map;
+	unsigned int byte_order;
+	bitv64 entries;
+	int fd;
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return -1;
+	}
+
+	if (st.st_size < TT_HEADER_SIZE) {
+		close(fd);
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* The pages are only copied when the search writes to them.  */
+	map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+	           fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return -1;
+
+	memcpy(&byte_order, map + 16, 4);
+	entries = read_u64(map + 24);
+	if (memcmp(map, TT_MAGIC, 8) != 0
+	    || read_u32(map + 8) != CHI_ZK_VERSION
+	    || read_u32(map + 12) != sizeof *tt
+	    || byte_order != TT_BYTE_ORDER
+	    || read_u64(map + 32) != start_signature()
+	    || !entries
+	    || entries != (st.st_size - TT_HEADER_SIZE) / sizeof *tt
+	    || (st.st_size - TT_HEADER_SIZE) % sizeof *tt) {
+		munmap(map, st.st_size);
+		errno = EINVAL;
+		return -1;
+	}
+
+	tt_destroy();
+
+	tt = (TTEntry *) (map + TT_HEADER_SIZE);
+	tt_size = entries;
+	tt_map = map;
+	tt_map_size = st.st_size;
+
+	return 0;
+}
@@ -20,7 +20,9 @@
 # include <config.h>
 #endif
 
+#include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <errno.h>
 #include <ctype.h>
 
@@ -28,7 +30,10 @@
 
 #include "uci-engine.h"
 
+#include "xalloc.h"
+#include "xstrndup.h"
 #include "lisco.h"
+#include "profile.h"
 #include "util.h"
 
 #define DELIM " \n\t\v\f\r"
@@ -43,6 +48,33 @@ next_token(char **string)
 	return strsep(string, DELIM);
 }
 
+/* Parse the VALUE of the spin option NAME into RESULT.  Returns non-zero
+ * for success.
+ */
+static int
+parse_spin(FILE *out, const char *name, const char *value,
+           unsigned long min, unsigned long max, unsigned long *result)
+{
+	char *endptr;
+	unsigned long number;
+
+	if (!value) {
+		fprintf(out, "info error: option '%s' needs a value\n", name);
+		return 0;
+	}
+
+	number = strtoul(value, &endptr, 10);
+	if (endptr == value || *endptr || number < min || number > max) {
+		fprintf(out, "info error: option '%s' must be between %lu"
+		        " and %lu: %s\n", name, min, max, value);
+		return 0;
+	}
+
+	*result = number;
+
+	return 1;
+}
+
 void
 uci_init(UCIEngineOptions *options, FILE *in, const char *inname,
          FILE *out, const char *outname)
@@ -50,6 +82,11 @@ uci_init(UCIEngineOptions *options, FILE *in, const char *inname,
 	memset(options, 0, sizeof *options);
 
 	options->option_threads = 1;
+	options->hash_size = LISCO_DEFAULT_TT_SIZE;
+	options->ev_size = LISCO_DEFAULT_EV_SIZE;
+	options->pawn_size = LISCO_DEFAULT_PAWN_SIZE;
+	options->move_overhead = UCI_ENGINE_MOVE_OVERHEAD;
+	options->multipv = 1;
 	options->in = in;
 	options->inname = inname;
 	options->out = out;
@@ -95,6 +132,14 @@ uci_main(UCIEngineOptions *options)
 			case 'u':
 				if(strcmp(command + 1, "ci") == 0) {
 					go_on = uci_handle_uci(options, trim(trimmed), out);
+				} else if(strcmp(command + 1, "cinewgame") == 0) {
+					go_on = uci_handle_ucinewgame(options, trim(trimmed),
+					                              out);
+				}
+				break;
+			case 's':
+				if(strcmp(command + 1, "etoption") == 0) {
+					go_on = uci_handle_setoption(options, trim(trimmed), out);
 				}
 				break;
 			case 'd':
@@ -139,9 +184,30 @@ uci_handle_uci(UCIEngineOptions *options, char *args, FILE *out)
 {
 	fprintf(out, "id name %s %s\n", PACKAGE, PACKAGE_VERSION);
 	fprintf(out, "id author %s\n", "Guido Flohr <guido.flohr@cantanea.com>");
+	fprintf(out, "option name Hash type spin default %u min 1 max %u\n",
+	        LISCO_DEFAULT_TT_SIZE, LISCO_MAX_HASH_SIZE);
+	fprintf(out, "option name Eval Cache type spin default %u min 1 max %u\n",
+	        LISCO_DEFAULT_EV_SIZE, LISCO_MAX_HASH_SIZE);
+	fprintf(out, "option name Pawn Hash type spin default %u min 1 max %u\n",
+	        LISCO_DEFAULT_PAWN_SIZE, UCI_ENGINE_MAX_PAWN_SIZE);
+	fprintf(out, "option name Clear Hash type button\n");
+	fprintf(out, "option name HashFile type string default <empty>\n");
+	fprintf(out, "option name Save Hash type button\n");
+	fprintf(out, "option name Load Hash type button\n");
+	fprintf(out, "option name MultiPV type spin default 1 min 1 max %u\n",
+	        UCI_ENGINE_MAX_MULTIPV);
 	fprintf(out, "option name Threads type spin default 1 min 1 max %u\n",
 	        UCI_ENGINE_MAX_THREADS);
+	fprintf(out, "option name Move Overhead type spin default %u min 0 max %u\n",
+	        UCI_ENGINE_MOVE_OVERHEAD, UCI_ENGINE_MAX_MOVE_OVERHEAD);
+	fprintf(out, "option name UseNNUE type check default false\n");
+	fprintf(out, "option name EvalFile type string default <empty>\n");
+	fprintf(out, "option name TablebasePath type string default <empty>\n");
+	fprintf(out, "option name StatisticsFile type string default <empty>\n");
+	fprintf(out, "info string slider attacks: %s\n",
+	        chi_mm_backend_name(chi_mm_get_backend()));
 	fprintf(out, "uciok\n");
+	fflush(out);
 
 	return 1;
 }
@@ -158,15 +224,310 @@ uci_handle_debug(UCIEngineOptions *options, char *args, FILE *out)
 	return 1;
 }
 
+int
+uci_handle_setoption(UCIEngineOptions *options, char *args, FILE *out)
+{
+	char *name;
+	char *value = NULL;
+	char *separator;
+	unsigned long number;
+
+	if (strncmp(args, "name", 4) != 0 || !isspace(args[4])) {
+		fprintf(out, "info error: usage: setoption name NAME [value VALUE]\n");
+		return 1;
+	}
+	name = (char *) ltrim(args + 4);
+
+	/* Option names may contain spaces.  */
+	for (separator = name; (separator = strstr(separator, "value"));
+	     ++separator) {
+		if (isspace(separator[-1])
+		    && (separator[5] == '\0' || isspace(separator[5]))) {
+			value = (char *) ltrim(separator + 5);
+			separator[-1] = '\0';
+			name = trim(name);
+			break;
+		}
+	}
+
+	if (strcasecmp(name, "Hash") == 0) {
+		if (!parse_spin(out, name, value, 1, LISCO_MAX_HASH_SIZE,
+		                &number))
+			return 1;
+		options->hash_size = number;
+		tt_init((size_t) number << 20);
+	} else if (strcasecmp(name, "Eval Cache") == 0) {
+		if (!parse_spin(out, name, value, 1, LISCO_MAX_HASH_SIZE,
+		                &number))
+			return 1;
+		options->ev_size = number;
+		init_ev_hash((size_t) number << 20);
+	} else if (strcasecmp(name, "Pawn Hash") == 0) {
+		if (!parse_spin(out, name, value, 1, UCI_ENGINE_MAX_PAWN_SIZE,
+		                &number))
+			return 1;
+		options->pawn_size = number;
+		init_pawn_hash((size_t) number << 20);
+	} else if (strcasecmp(name, "Clear Hash") == 0) {
+		tt_clear();
+		clear_ev_hash();
+		clear_pawn_hash();
+		init_material();
+	} else if (strcasecmp(name, "HashFile") == 0) {
+		free(options->hash_file);
+		options->hash_file = NULL;
+		if (value && *value && strcmp(value, "<empty>") != 0)
+			options->hash_file = xstrdup(value);
+	} else if (strcasecmp(name, "Save Hash") == 0) {
+		if (!options->hash_file) {
+			fprintf(out, "info string set HashFile first\n");
+			return 1;
+		}
+		if (tt_save(options->hash_file) != 0) {
+			fprintf(out, "info string cannot save hash to '%s': %s\n",
+			        options->hash_file, strerror(errno));
+			return 1;
+		}
+		fprintf(out, "info string hash saved to '%s'\n",
+		        options->hash_file);
+	} else if (strcasecmp(name, "Load Hash") == 0) {
+		if (!options->hash_file) {
+			fprintf(out, "info string set HashFile first\n");
+			return 1;
+		}
+		if (tt_load(options->hash_file) != 0) {
+			fprintf(out, "info string cannot load hash from '%s': %s\n",
+			        options->hash_file, errno == EINVAL
+			        ? "not a hash file of this engine"
+			        : strerror(errno));
+			return 1;
+		}
+		fprintf(out, "info string hash loaded from '%s'\n",
+		        options->hash_file);
+	} else if (strcasecmp(name, "MultiPV") == 0) {
+		if (!parse_spin(out, name, value, 1, UCI_ENGINE_MAX_MULTIPV,
+		                &number))
+			return 1;
+		options->multipv = number;
+	} else if (strcasecmp(name, "Threads") == 0) {
+		if (!parse_spin(out, name, value, 1, UCI_ENGINE_MAX_THREADS,
+		                &number))
+			return 1;
+		options->option_threads = number;
+	} else if (strcasecmp(name, "Move Overhead") == 0) {
+		if (!parse_spin(out, name, value, 0, UCI_ENGINE_MAX_MOVE_OVERHEAD,
+		                &number))
+			return 1;
+		options->move_overhead = number;
+	} else if (strcasecmp(name, "UseNNUE") == 0) {
+		int use_nnue = value && strcmp(value, "true") == 0;
+
+		/* The evaluation cache does not know which evaluator filled
+		 * it.
+		 */
+		if (use_nnue != options->use_nnue)
+			clear_ev_hash();
+		options->use_nnue = use_nnue;
+		if (options->use_nnue && !nnue_loaded())
+			fprintf(out, "info string no network loaded,"
+			        " set EvalFile first\n");
+	} else if (strcasecmp(name, "EvalFile") == 0) {
+		if (!value || !*value || strcmp(value, "<empty>") == 0)
+			return 1;
+		if (nnue_load(value) != 0) {
+			fprintf(out, "info string cannot load network '%s': %s\n",
+			        value, strerror(errno));
+			return 1;
+		}
+		/* Scores of the old network must not be reused.  */
+		clear_ev_hash();
+		free(options->eval_file);
+		options->eval_file = xstrdup(value);
+		fprintf(out, "info string network '%s' loaded, kernel %s\n",
+		        value, nnue_kernel_name(nnue_get_kernel()));
+	} else if (strcasecmp(name, "StatisticsFile") == 0) {
+		free(options->stats_file);
+		options->stats_file = NULL;
+		if (value && *value && strcmp(value, "<empty>") != 0)
+			options->stats_file = xstrdup(value);
+	} else if (strcasecmp(name, "TablebasePath") == 0) {
+		int count;
+
+		if (!value || !*value || strcmp(value, "<empty>") == 0) {
+			tb_clear();
+			return 1;
+		}
+		count = tb_init(value);
+		if (count < 0) {
+			fprintf(out, "info string cannot read tablebases from '%s': %s\n",
+			        value, strerror(errno));
+			return 1;
+		}
+		free(options->tablebase_path);
+		options->tablebase_path = xstrdup(value);
+		fprintf(out, "info string %d tablebases loaded from '%s'\n",
+		        count, value);
+	} else {
+		fprintf(out, "info error: unknown option '%s'\n", name);
+	}
+
+	return 1;
+}
+
+/* Parse MOVESTR in coordinate notation like "e7e8q".  Returns 0 for
+ * success or -1.
+ */
+static int
+parse_coordinates(const char *movestr, int *from, int *to,
+                  chi_piece_t *promote)
+{
+	int from_file = tolower(movestr[0]) - 'a';
+	int from_rank = movestr[1] - '1';
+	int to_file, to_rank;
+
+	if (from_file < 0 || from_file > 7 || from_rank < 0 || from_rank > 7)
+		return -1;
+
+	to_file = tolower(movestr[2]) - 'a';
+	to_rank = movestr[3] - '1';
+	if (to_file < 0 || to_file > 7 || to_rank < 0 || to_rank > 7)
+		return -1;
+
+	switch (tolower(movestr[4])) {
+		case '\0':
+			*promote = empty;
+			break;
+		case 'q':
+			*promote = queen;
+			break;
+		case 'r':
+			*promote = rook;
+			break;
+		case 'b':
+			*promote = bishop;
+			break;
+		case 'n':
+			*promote = knight;
+			break;
+		default:
+			return -1;
+	}
+	if (*promote != empty && movestr[5])
+		return -1;
+
+	*from = chi_coords2shift(from_file, from_rank);
+	*to = chi_coords2shift(to_file, to_rank);
+
+	return 0;
+}
+
+/* Non-zero if MOVESTR is MOVE in coordinate notation.  */
+static int
+is_same_move(chi_move move, const char *movestr)
+{
+	int from, to;
+	chi_piece_t promote;
+
+	return parse_coordinates(movestr, &from, &to, &promote) == 0
+		&& chi_move_from(move) == from && chi_move_to(move) == to
+		&& chi_move_promote(move) == promote;
+}
+
+/* Find MOVESTR among the legal moves of POS.  Moves in coordinate
+ * notation, the normal case, only need one move generation.  Returns 0
+ * for success, CHI_ERR_PARSER or CHI_ERR_ILLEGAL_MOVE.
+ */
+static int
+parse_legal_move(chi_pos *pos, chi_move *move, const char *movestr)
+{
+	chi_move moves[CHI_MAX_MOVES];
+	chi_move *end;
+	chi_move *ptr;
+	int from, to;
+	chi_piece_t promote;
+
+	if (parse_coordinates(movestr, &from, &to, &promote) != 0) {
+		if (chi_parse_move(pos, move, movestr) != 0)
+			return CHI_ERR_PARSER;
+		if (chi_check_legality(pos, *move) != 0)
+			return CHI_ERR_ILLEGAL_MOVE;
+		return 0;
+	}
+
+	end = chi_legal_moves(pos, moves);
+	for (ptr = moves; ptr < end; ++ptr) {
+		if (chi_move_from(*ptr) == from && chi_move_to(*ptr) == to
+		    && chi_move_promote(*ptr) == promote) {
+			*move = *ptr;
+			return 0;
+		}
+	}
+
+	return CHI_ERR_ILLEGAL_MOVE;
+}
+
+/* Take back the moves of the game after the first NUM_MOVES.  */
+static void
+truncate_game(size_t num_moves)
+{
+	MoveList *moves = &lisco.game_moves;
+
+	while (moves->num_moves > num_moves)
+		chi_unapply_move(&lisco.position,
+		                 moves->moves[--moves->num_moves]);
+}
+
+/* Set up the start of the game from START with length LENGTH.  */
+static void
+start_game(const chi_pos *position, const char *start, size_t length)
+{
+	free(lisco.game_start);
+	lisco.game_start = xstrndup(start, length);
+
+	chi_copy_pos(&lisco.position, position);
+	lisco.game_moves.num_moves = 0;
+	lisco.game_signatures = xrealloc(lisco.game_signatures,
+	                                 sizeof *lisco.game_signatures);
+	lisco.game_signatures[0] = chi_zk_signature(lisco.zk_handle,
+	                                            &lisco.position);
+}
+
+static int
+play_move(chi_move move)
+{
+	chi_color_t mover = chi_on_move(&lisco.position);
+	size_t num_moves = lisco.game_moves.num_moves;
+	int errnum;
+
+	errnum = chi_apply_move(&lisco.position, move);
+	if (errnum)
+		return errnum;
+
+	move_list_add(&lisco.game_moves, move);
+	lisco.game_signatures = xrealloc(lisco.game_signatures,
+		(num_moves + 2) * sizeof *lisco.game_signatures);
+	lisco.game_signatures[num_moves + 1] = chi_zk_update_signature(
+		lisco.zk_handle, lisco.game_signatures[num_moves], move, mover);
+
+	return 0;
+}
+
+/* GUIs send the whole game before every move.  If the game starts like
+ * the previous one, only the moves that differ are taken back or played.
+ */
 int
 uci_handle_position(UCIEngineOptions *options, char *args, FILE *out)
 {
 	char *rest;
 	const char *type;
 	const char *command;
+	const char *start;
+	size_t start_length;
+	chi_pos position;
 	int errnum;
 	chi_move move;
 	const char *movestr;
+	size_t num_moves = 0;
 
 	if (!args) {
 		fprintf(out, "info Command 'position' requires an argument.\n");
@@ -182,25 +543,36 @@ uci_handle_position(UCIEngineOptions *options, char *args, FILE *out)
 		}
 
 		rest = trim(rest);
-		errnum = chi_extract_position(&lisco.position, rest, (const char **) &rest);
+		start = rest;
+		errnum = chi_extract_position(&position, rest, (const char **) &rest);
 		if (errnum) {
 			fprintf(out, "info Invalid FEN string (%d).\n", errnum);
 			return 1;
 		}
+		start_length = rest - start;
 	} else if (strcmp("startpos", type) == 0) {
-		chi_init_position(&lisco.position);
+		chi_init_position(&position);
+		start = type;
+		start_length = strlen(type);
 	} else {
 		fprintf(out, "info Command 'position' requires one of 'startpos' or"
 			" 'fen' as an argument.\n");
 		return 1;
 	}
 
+	if (!lisco.game_start || strlen(lisco.game_start) != start_length
+	    || strncmp(lisco.game_start, start, start_length) != 0)
+		start_game(&position, start, start_length);
+
 	rest = trim(rest);
-	if (!rest || !*rest)
+	if (!rest || !*rest) {
+		truncate_game(0);
 		return 1;
+	}
 
 	command = strsep(&rest, DELIM);
 	if (strcmp("moves", command)) {
+		truncate_game(0);
 		fprintf(out, "info Expected 'moves' after position, not '%s'.\n",
 		        command);
 		return 1;
@@ -208,27 +580,36 @@ uci_handle_position(UCIEngineOptions *options, char *args, FILE *out)
 
 	while (rest) {
 		movestr = strsep(&rest, DELIM);
-		if (*movestr) {
-			errnum = chi_parse_move(&lisco.position, &move, movestr);
-			if (errnum) {
-				fprintf(out, "info Invalid move '%s'.\n", movestr);
-				return 1;
-			}
+		if (!*movestr)
+			continue;
 
-			errnum = chi_check_legality(&lisco.position, move);
-			if (errnum) {
-				fprintf(out, "info Illegal move '%s'.\n", movestr);
-				return 1;
+		if (num_moves < lisco.game_moves.num_moves) {
+			if (is_same_move(lisco.game_moves.moves[num_moves], movestr)) {
+				++num_moves;
+				continue;
 			}
+			truncate_game(num_moves);
+		}
 
-			errnum = chi_apply_move(&lisco.position, move);
-			if (errnum) {
-				fprintf(out, "info Cannot apply move '%s'.\n", movestr);
-				return 1;
-			}
+		errnum = parse_legal_move(&lisco.position, &move, movestr);
+		if (errnum == CHI_ERR_PARSER) {
+			fprintf(out, "info Invalid move '%s'.\n", movestr);
+			break;
+		} else if (errnum) {
+			fprintf(out, "info Illegal move '%s'.\n", movestr);
+			break;
 		}
+
+		errnum = play_move(move);
+		if (errnum) {
+			fprintf(out, "info Cannot apply move '%s'.\n", movestr);
+			break;
+		}
+		++num_moves;
 	}
 
+	truncate_game(num_moves);
+
 	return 1;
 }
 
@@ -264,8 +645,8 @@ static int is_coordinate_notation(char *movestr) {
 	return !movestr[5];
 }
 
-int
-uci_handle_go(UCIEngineOptions *options, char *args, FILE *out)
+static int
+go(UCIEngineOptions *options, char *args, FILE *out, Tree *tree)
 {
 	char *bestmove = NULL;
 	char *pondermove = NULL;
@@ -276,13 +657,16 @@ uci_handle_go(UCIEngineOptions *options, char *args, FILE *out)
 	unsigned long perft_depth = 0;
 	char *endptr;
 
-	Tree tree;
 	SearchParams params;
 
-	memset(&tree, 0, sizeof tree);
+	memset(tree, 0, sizeof *tree);
 	memset(&params, 0, sizeof params);
 
+	/* The time control needs the position to estimate the moves to go.  */
+	chi_copy_pos(&tree->position, &lisco.position);
+
 	move_list_init(&params.searchmoves);
+	params.overhead = options->move_overhead;
 
 	while ((token = next_token(&argptr)) != NULL) {
 		if (strcmp("searchmoves", token) == 0) {
@@ -469,15 +853,33 @@ uci_handle_go(UCIEngineOptions *options, char *args, FILE *out)
 			        token);
 		}
 
-		if (!process_search_params(&tree, &params)) {
+		if (!process_search_params(tree, &params)) {
 			fprintf(out, "info cannot understand search parameters.\n");
 			return 1;
 		}
 	}
 
+	if (options->debug && tree->soft_limit)
+		fprintf(out, "info string time budget %lld ms, at most %lld ms\n",
+		        tree->soft_limit, tree->hard_limit);
 
-	think(&tree);
-	move_list_destroy(&tree.searchmoves);
+	profile_reset();
+	think(tree);
+	move_list_destroy(&tree->searchmoves);
+
+	stats_print(tree, out);
+	profile_print(out);
+	if (options->stats_file) {
+		FILE *stats_out = fopen(options->stats_file, "a");
+
+		if (stats_out) {
+			stats_write_json(tree, stats_out);
+			fclose(stats_out);
+		} else {
+			fprintf(out, "info string cannot open '%s': %s\n",
+			        options->stats_file, strerror(errno));
+		}
+	}
 
 	if (lisco.bestmove_found) {
 		errnum = chi_coordinate_notation(
@@ -491,7 +893,7 @@ uci_handle_go(UCIEngineOptions *options, char *args, FILE *out)
 		if (errnum) {
 			fprintf(out, "bestmove 0000\n");
 		} else if (pondermove) {
-			fprintf(out, "bestmove %s pondermove %s\n", bestmove, pondermove);
+			fprintf(out, "bestmove %s ponder %s\n", bestmove, pondermove);
 		} else {
 			fprintf(out, "bestmove %s\n", bestmove);
 		}
@@ -505,6 +907,36 @@ uci_handle_go(UCIEngineOptions *options, char *args, FILE *out)
 	return 1;
 }
 
+int
+uci_handle_go(UCIEngineOptions *options, char *args, FILE *out)
+{
+	/* The tree is too big for the stack of some threads.  */
+	Tree *tree = xmalloc(sizeof *tree);
+	int go_on;
+
+	go_on = go(options, args, out, tree);
+	free(tree);
+
+	return go_on;
+}
+
+int
+uci_handle_ucinewgame(UCIEngineOptions *options, char *args, FILE *out)
+{
+	/* Positions of the old game are useless now.  */
+	tt_clear();
+	clear_ev_hash();
+	clear_pawn_hash();
+	init_material();
+
+	/* The next position command must not continue the old game.  */
+	free(lisco.game_start);
+	lisco.game_start = NULL;
+	lisco.game_moves.num_moves = 0;
+
+	return 1;
+}
+
 int
 uci_handle_isready(UCIEngineOptions *options, char *args, FILE *out)
 {
@@ -26,10 +26,31 @@
 #include <stdio.h>
 
 #define UCI_ENGINE_MAX_THREADS 512
+#define UCI_ENGINE_MOVE_OVERHEAD 30
+#define UCI_ENGINE_MAX_MOVE_OVERHEAD 5000
+#define UCI_ENGINE_MAX_PAWN_SIZE 1024
+#define UCI_ENGINE_MAX_MULTIPV 64
 
 typedef struct UCIEngineOptions {
 	int debug;
 	int option_threads;
+	/* Sizes of the transposition table, the evaluation cache and the
+	 * pawn hash in MB.
+	 */
+	unsigned long hash_size;
+	unsigned long ev_size;
+	unsigned long pawn_size;
+	int use_nnue;
+	/* Milliseconds lost per move for communication.  */
+	unsigned long move_overhead;
+	/* Number of best lines to report.  */
+	int multipv;
+	char *eval_file;
+	char *tablebase_path;
+	/* Statistics of every search are appended to this file as JSON.  */
+	char *stats_file;
+	/* The transposition table is saved to and loaded from this file.  */
+	char *hash_file;
 	FILE *in;
 	const char *inname;
 	FILE *out;
@@ -51,7 +72,11 @@ extern int uci_handle_uci(UCIEngineOptions *options, char *args, FILE *out);
 extern int uci_handle_debug(UCIEngineOptions *options, char *args, FILE *out);
 extern int uci_handle_position(UCIEngineOptions *options, char *args, FILE *out);
 extern int uci_handle_go(UCIEngineOptions *options, char *args, FILE *out);
+extern int uci_handle_setoption(UCIEngineOptions *options, char *args,
+                                FILE *out);
 extern int uci_handle_isready(UCIEngineOptions *options, char *args, FILE *out);
+extern int uci_handle_ucinewgame(UCIEngineOptions *options, char *args,
+                                 FILE *out);
 #endif
 
 #ifdef __cplusplus
@@ -24,8 +24,10 @@
 #include <errno.h>
 #include <limits.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #ifdef _WIN32
 # define WIN32_LEAN_AND_MEAN
@@ -182,3 +184,130 @@ xmalloc_aligned(void **to_free, unsigned alignment, size_t size)
 	address = (address + a64 - 1) & ~(a64 - 1);
 	return (void *) address;
 }
+
+/* The size of a huge page on x86_64 and aarch64 Linux.  */
+#define HUGE_PAGE_SIZE ((size_t) 2 << 20)
+
+void *
+xmalloc_huge(size_t size, size_t *mapped)
+{
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	size_t head, tail;
+	char *ptr, *aligned;
+
+	if (size < HUGE_PAGE_SIZE) {
+		size = (size + page_size - 1) & ~(page_size - 1);
+		ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+		           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED)
+			xalloc_die();
+		*mapped = size;
+		return ptr;
+	}
+
+	size = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+
+#ifdef MAP_HUGETLB
+	/* Only succeeds if the administrator has reserved enough huge
+	 * pages.
+	 */
+	ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+	           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (ptr != MAP_FAILED) {
+		*mapped = size;
+		return ptr;
+	}
+#endif
+
+	/* Otherwise, ask for transparent huge pages.  They are only used
+	 * for blocks aligned to the huge page size, and therefore the
+	 * excess at both ends of the mapping is given back.
+	 */
+	ptr = mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+	           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ptr == MAP_FAILED)
+		xalloc_die();
+
+	aligned = (char *) (((unsigned long long) ptr + HUGE_PAGE_SIZE - 1)
+	                    & ~((unsigned long long) HUGE_PAGE_SIZE - 1));
+	head = aligned - ptr;
+	tail = HUGE_PAGE_SIZE - head;
+	if (head)
+		munmap(ptr, head);
+	if (tail)
+		munmap(aligned + size, tail);
+
+#ifdef MADV_HUGEPAGE
+	madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+
+	*mapped = size;
+
+	return aligned;
+}
+
+void
+free_huge(void *ptr, size_t mapped)
+{
+	if (ptr)
+		munmap(ptr, mapped);
+}
+
+/* Every thread clears at least that many bytes.  */
+#define CLEAR_CHUNK_MIN (1 << 20)
+
+typedef struct ClearJob {
+	char *start;
+	size_t size;
+} ClearJob;
+
+static void *
+clear_chunk(void *closure)
+{
+	ClearJob *job = closure;
+
+	memset(job->start, 0, job->size);
+
+	return NULL;
+}
+
+void
+clear_memory(void *ptr, size_t size, int threads)
+{
+	pthread_t *tids;
+	ClearJob *jobs;
+	size_t chunk;
+	int i, started;
+
+	if (threads > 1 && size / threads < CLEAR_CHUNK_MIN)
+		threads = size / CLEAR_CHUNK_MIN;
+	if (threads <= 1) {
+		memset(ptr, 0, size);
+		return;
+	}
+
+	tids = xmalloc(threads * sizeof *tids);
+	jobs = xmalloc(threads * sizeof *jobs);
+
+	/* Chunks are multiples of the page size, the last one gets the
+	 * rest.
+	 */
+	chunk = (size / threads) & ~((size_t) 4095);
+	for (i = 0; i < threads; ++i) {
+		jobs[i].start = (char *) ptr + i * chunk;
+		jobs[i].size = i < threads - 1 ? chunk : size - i * chunk;
+	}
+
+	/* If a thread cannot be created, its job is done here.  */
+	for (i = started = 0; i < threads; ++i) {
+		if (pthread_create(tids + started, NULL, clear_chunk, jobs + i))
+			clear_chunk(jobs + i);
+		else
+			++started;
+	}
+	for (i = 0; i < started; ++i)
+		pthread_join(tids[i], NULL);
+
+	free(jobs);
+	free(tids);
+}
@@ -48,6 +48,18 @@ extern long num_cpus(void);
  */
 extern void *xmalloc_aligned(void **to_free, unsigned alignement, size_t size);
 
+/* Allocates at least SIZE zeroed bytes for a big hash table.  Blocks of
+ * 2 MB or more are backed by huge pages if possible, in order to reduce
+ * TLB misses.  The pages are only placed, when they are first touched,
+ * so that they end up on the NUMA node of the thread using the table.
+ * The size to pass to free_huge() is stored in MAPPED.
+ */
+extern void *xmalloc_huge(size_t size, size_t *mapped);
+extern void free_huge(void *ptr, size_t mapped);
+
+/* Zero SIZE bytes at PTR with up to THREADS threads.  */
+extern void clear_memory(void *ptr, size_t size, int threads);
+
 #ifdef __cplusplus
 }
 #endif